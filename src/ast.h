@@ -4,6 +4,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -57,9 +58,13 @@ struct Attrs
     bool string_;
     bool wstring_;
     bool user_check_;
+    bool host_memory_;
     bool is_size_or_count_;
     Token size_;
     Token count_;
+    Token chunked_;
+    Token length_;
+    Token align_;
 };
 
 typedef std::vector<std::string> Dims;
@@ -93,6 +98,19 @@ struct Function
     std::vector<Decl*> params_;
     bool switchless_;
     bool errno_;
+    bool batchable_;
+    bool deferred_;
+    bool async_;
+};
+
+struct Channel
+{
+    std::string name_;
+    Type* type_;
+    uint64_t size_;
+    // Records flow into the enclave through [in] channels and out of it
+    // through [out] channels.
+    bool in_;
 };
 
 struct Edl
@@ -102,6 +120,7 @@ struct Edl
     std::vector<UserType*> types_;
     std::vector<Function*> trusted_funcs_;
     std::vector<Function*> untrusted_funcs_;
+    std::vector<Channel*> channels_;
 };
 
 enum Directive
@@ -7,13 +7,17 @@
 #include <fstream>
 
 #include "ast.h"
+#include "d_emitter.h"
 #include "f_emitter.h"
+#include "layout.h"
+#include "options.h"
 #include "utils.h"
 #include "w_emitter.h"
 
 class CEmitter
 {
     Edl* edl_;
+    const Options& options_;
     bool gen_t_c_;
     std::ofstream file_;
     std::string indent_;
@@ -40,7 +44,8 @@ class CEmitter
     }
 
   public:
-    CEmitter(Edl* edl) : edl_(edl), gen_t_c_(false), file_(), indent_()
+    CEmitter(Edl* edl, const Options& options)
+        : edl_(edl), options_(options), gen_t_c_(false), file_(), indent_()
     {
     }
 
@@ -63,10 +68,26 @@ class CEmitter
         trusted_function_ids();
         out() << "/**** ECALL marshalling structs. ****/";
         ecall_marshalling_structs();
+        DEmitter(edl_, file_, options_)
+            .emit(edl_->trusted_funcs_, edl_->untrusted_funcs_, true);
         out() << "/**** ECALL functions. ****/"
               << "";
         for (Function* f : edl_->trusted_funcs_)
             emit_forwarder(f);
+        for (Function* f : edl_->trusted_funcs_)
+            if (f->batchable_)
+                FEmitter(edl_, file_, options_).emit_batch(f);
+        for (Function* f : edl_->trusted_funcs_)
+            for (Decl* p : f->params_)
+                if (is_chunked(p))
+                    FEmitter(edl_, file_, options_).emit_chunk(f, p);
+        if (!edl_->channels_.empty())
+        {
+            out() << "/**** Channels. ****/"
+                  << "";
+            for (Channel* c : edl_->channels_)
+                FEmitter(edl_, file_, options_).emit_channel(c);
+        }
         out() << "/**** ECALL function table. ****/"
               << "";
         ecalls_table();
@@ -74,8 +95,12 @@ class CEmitter
         untrusted_function_ids();
         out() << "/**** OCALL marshalling structs. ****/";
         ocall_marshalling_structs();
+        if (options_.stats_)
+            call_stats(edl_->untrusted_funcs_);
         out() << "/**** OCALL function wrappers. ****/"
               << "";
+        if (has_deferred(edl_))
+            WEmitter(edl_, file_, options_).emit_deferred_buffer();
         for (Function* f : edl_->untrusted_funcs_)
             emit_wrapper(f);
         if (edl_->untrusted_funcs_.empty())
@@ -103,10 +128,21 @@ class CEmitter
         trusted_function_names();
         out() << "/**** ECALL marshalling structs. ****/";
         ecall_marshalling_structs();
+        DEmitter(edl_, file_, options_)
+            .emit(edl_->untrusted_funcs_, edl_->trusted_funcs_, false);
+        if (options_.stats_)
+            call_stats(edl_->trusted_funcs_);
         out() << "/**** ECALL function wrappers. ****/"
               << "";
+        if (has_chunked(edl_))
+            WEmitter(edl_, file_, options_).emit_chunk_helpers();
         for (Function* f : edl_->trusted_funcs_)
             emit_wrapper(f, prefix);
+        for (Function* f : edl_->trusted_funcs_)
+            if (f->batchable_)
+                WEmitter(edl_, file_, options_).emit_batch(f, prefix);
+        if (!edl_->channels_.empty())
+            WEmitter(edl_, file_, options_).emit_channels();
         out() << "/**** Untrusted function IDs. ****/";
         untrusted_function_ids();
         out() << "/**** OCALL marshalling structs. ****/";
@@ -115,6 +151,9 @@ class CEmitter
               << "";
         for (Function* f : edl_->untrusted_funcs_)
             emit_forwarder(f);
+        if (has_deferred(edl_))
+            FEmitter(edl_, file_, options_)
+                .emit_deferred_batch(edl_->untrusted_funcs_);
         if (edl_->untrusted_funcs_.empty())
             out() << "/* There were no ocalls. */"
                   << "";
@@ -129,9 +168,9 @@ class CEmitter
               << "               settings,"
               << "               setting_count,"
               << "               _" + edl_->name_ + "_ocall_function_table,"
-              << "               " + to_str(edl_->untrusted_funcs_.size()) + ","
+              << "               " + to_str(num_ocalls()) + ","
               << "               _" + edl_->name_ + "_ecall_info_table,"
-              << "                " + to_str(edl_->trusted_funcs_.size()) + ","
+              << "                " + to_str(num_ecalls()) + ","
               << "               enclave);"
               << "}"
               << ""
@@ -147,6 +186,17 @@ class CEmitter
         std::string pfx = "    " + edl_->name_ + "_fcn_id_";
         for (Function* f : edl_->trusted_funcs_)
             out() << pfx + f->name_ + " = " + to_str(idx++) + ",";
+        for (Function* f : edl_->trusted_funcs_)
+            if (f->batchable_)
+                out() << pfx + f->name_ + "_batch = " + to_str(idx++) + ",";
+        for (Function* f : edl_->trusted_funcs_)
+            for (Decl* p : f->params_)
+                if (is_chunked(p))
+                    out() << pfx + f->name_ + "_" + p->name_ +
+                                 "_chunk = " + to_str(idx++) + ",";
+        for (Channel* c : edl_->channels_)
+            out() << pfx + "oe_channel_" + c->name_ + " = " + to_str(idx++) +
+                         ",";
         out() << pfx + "trusted_call_id_max = OE_ENUM_MAX"
               << "};"
               << "";
@@ -158,11 +208,25 @@ class CEmitter
                      "_ecall_info_table[] = "
               << "{";
         for (Function* f : edl_->trusted_funcs_)
-            out() << "    { \"" + f->name_ + "\" },";
+            ecall_info(f->name_);
+        for (Function* f : edl_->trusted_funcs_)
+            if (f->batchable_)
+                ecall_info(f->name_ + "_batch");
+        for (Function* f : edl_->trusted_funcs_)
+            for (Decl* p : f->params_)
+                if (is_chunked(p))
+                    ecall_info(f->name_ + "_" + p->name_ + "_chunk");
+        for (Channel* c : edl_->channels_)
+            ecall_info("oe_channel_" + c->name_);
         out() << "};"
               << "";
     }
 
+    void ecall_info(const std::string& name)
+    {
+        out() << "    { \"" + name + "\" },";
+    }
+
     void untrusted_function_ids()
     {
         out() << "enum"
@@ -171,6 +235,8 @@ class CEmitter
         std::string pfx = "    " + edl_->name_ + "_fcn_id_";
         for (Function* f : edl_->untrusted_funcs_)
             out() << pfx + f->name_ + " = " + to_str(idx++) + ",";
+        if (has_deferred(edl_))
+            out() << pfx + "oe_deferred_batch = " + to_str(idx++) + ",";
         out() << pfx + "untrusted_call_max = OE_ENUM_MAX"
               << "};"
               << "";
@@ -178,36 +244,183 @@ class CEmitter
 
     void ecall_marshalling_structs()
     {
+        bool batchable = false;
         for (Function* f : edl_->trusted_funcs_)
+        {
             marshalling_struct(f, false);
+            batchable = batchable || f->batchable_;
+        }
+        if (batchable)
+            batch_header_struct();
+        if (has_chunked(edl_))
+            chunk_header_struct();
+        if (!edl_->channels_.empty())
+            channel_args_struct();
+    }
+
+    /*
+     * The batch ECALLs follow the ECALLs in the function table, then the
+     * ECALLs that carry the chunks of chunked parameters and the ECALLs that
+     * attach the rings of the channels.
+     */
+    size_t num_ecalls()
+    {
+        size_t n = edl_->trusted_funcs_.size() + edl_->channels_.size();
+        for (Function* f : edl_->trusted_funcs_)
+        {
+            if (f->batchable_)
+                ++n;
+            for (Decl* p : f->params_)
+                if (is_chunked(p))
+                    ++n;
+        }
+        return n;
+    }
+
+    /*
+     * A chunk is marshalled as this header followed by the elements, in the
+     * input buffer for chunked in parameters and in the output buffer for
+     * chunked out parameters. The args struct of the function sits between
+     * the header and the elements in the input buffer. offset and count are
+     * in elements, and flags holds the OE_CHUNK_* flags.
+     */
+    void chunk_header_struct()
+    {
+        std::string header_t = edl_->name_ + "_chunk_header_t";
+        out() << "typedef struct _" + header_t << "{"
+              << "    oe_result_t oe_result;"
+              << "    uint8_t* deepcopy_out_buffer;"
+              << "    size_t deepcopy_out_buffer_size;"
+              << "    uint64_t offset;"
+              << "    uint64_t count;"
+              << "    uint64_t flags;"
+              << "} " + header_t + ";"
+              << "";
+    }
+
+    /*
+     * The batch of a batchable ECALL is marshalled as this header followed by
+     * an array of arg structs. The header starts with the same fields as the
+     * arg structs.
+     */
+    void batch_header_struct()
+    {
+        std::string header_t = edl_->name_ + "_batch_header_t";
+        out() << "typedef struct _" + header_t << "{"
+              << "    oe_result_t oe_result;"
+              << "    uint8_t* deepcopy_out_buffer;"
+              << "    size_t deepcopy_out_buffer_size;"
+              << "    size_t count;"
+              << "} " + header_t + ";"
+              << "";
+    }
+
+    /* The ring is the only parameter of the ECALL that attaches it. */
+    void channel_args_struct()
+    {
+        std::string args_t = edl_->name_ + "_channel_args_t";
+        out() << "typedef struct _" + args_t << "{"
+              << "    oe_result_t oe_result;"
+              << "    uint8_t* deepcopy_out_buffer;"
+              << "    size_t deepcopy_out_buffer_size;"
+              << "    oe_channel_ring_t* ring;"
+              << "} " + args_t + ";"
+              << "";
     }
 
     void ocall_marshalling_structs()
     {
         for (Function* f : edl_->untrusted_funcs_)
             marshalling_struct(f, true);
+        if (has_deferred(edl_))
+            deferred_structs();
+    }
+
+    /* The deferred OCALL batch follows the OCALLs in the function table. */
+    size_t num_ocalls()
+    {
+        return edl_->untrusted_funcs_.size() + (has_deferred(edl_) ? 1 : 0);
+    }
+
+    /*
+     * A flushed deferred OCALL buffer is marshalled as the args struct
+     * followed by the records. Each record holds the input buffer of one
+     * deferred OCALL.
+     */
+    void deferred_structs()
+    {
+        std::string args_t = edl_->name_ + "_deferred_batch_args_t";
+        std::string record_t = edl_->name_ + "_deferred_record_t";
+        out() << "typedef struct _" + args_t << "{"
+              << "    oe_result_t oe_result;"
+              << "    uint8_t* deepcopy_out_buffer;"
+              << "    size_t deepcopy_out_buffer_size;"
+              << "} " + args_t + ";"
+              << ""
+              << "typedef struct _" + record_t << "{"
+              << "    uint64_t function_id;"
+              << "    uint64_t size;"
+              << "} " + record_t + ";"
+              << "";
+    }
+
+    /*
+     * The counters of the calls this side makes, indexed by function id, and
+     * their accessors. The batch and deferred calls are not counted.
+     */
+    void call_stats(const std::vector<Function*>& funcs)
+    {
+        std::string table = "_" + edl_->name_ + "_call_stats";
+        std::string n = to_str(funcs.size());
+        out() << "/**** Call counters. ****/";
+        if (funcs.empty())
+        {
+            out() << get_call_stats_prototype(edl_) << "{"
+                  << "    OE_UNUSED(stats);"
+                  << "    OE_UNUSED(count);"
+                  << "    return 0;"
+                  << "}"
+                  << ""
+                  << reset_call_stats_prototype(edl_) << "{"
+                  << "}"
+                  << "";
+            return;
+        }
+        out() << "static oe_call_stats_t " + table + "[] = {";
+        for (Function* f : funcs)
+            out() << "    { .name = \"" + f->name_ + "\" },";
+        out() << "};"
+              << ""
+              << get_call_stats_prototype(edl_) << "{"
+              << "    if (stats)"
+              << "        oe_call_stats_copy(stats, " + table + ", count < " +
+                     n + " ? count : " + n + ");"
+              << "    return " + n + ";"
+              << "}"
+              << ""
+              << reset_call_stats_prototype(edl_) << "{"
+              << "    oe_call_stats_reset(" + table + ", " + n + ");"
+              << "}"
+              << "";
     }
 
     void marshalling_struct(Function* f, bool ocall = false)
     {
         bool has_deep_copy_out_param = has_deep_copy_out(edl_, f);
         (void)ocall;
+        ArgsLayout layout = args_layout(edl_, f, options_);
         out() << "typedef struct _" + f->name_ + "_args_t"
               << "{"
-              << "    oe_result_t oe_result;"
-              << "    uint8_t* deepcopy_out_buffer;"
+              << "    oe_result_t oe_result;";
+        indent_ = "    ";
+        for (const ArgsField& field : layout.hole_)
+            out() << field.decl_ + ";";
+        indent_ = "";
+        out() << "    uint8_t* deepcopy_out_buffer;"
               << "    size_t deepcopy_out_buffer_size;";
         indent_ = "    ";
-        if (f->rtype_->tag_ != Void)
-            out() << atype_str(f->rtype_) + " oe_retval;";
-        for (Decl* p : f->params_)
-        {
-            out() << mdecl_str(p->name_, p->type_, p->dims_, p->attrs_) + ";";
-            if (p->attrs_ && (p->attrs_->string_ || p->attrs_->wstring_))
-                out() << "size_t " + p->name_ + "_len;";
-        }
-        if (f->errno_)
-            out() << "int ocall_errno;";
+        for (const ArgsField& field : layout.body_)
+            out() << field.decl_ + ";";
         indent_ = "";
         out() << "} " + f->name_ + "_args_t;"
               << "";
@@ -217,9 +430,22 @@ class CEmitter
     {
         out() << "oe_ecall_func_t oe_ecalls_table[] = {";
         size_t idx = 0;
+        size_t n = num_ecalls();
         for (Function* f : edl_->trusted_funcs_)
             out() << "    (oe_ecall_func_t) ecall_" + f->name_ +
-                         (++idx < edl_->trusted_funcs_.size() ? "," : "");
+                         (++idx < n ? "," : "");
+        for (Function* f : edl_->trusted_funcs_)
+            if (f->batchable_)
+                out() << "    (oe_ecall_func_t) ecall_" + f->name_ + "_batch" +
+                             (++idx < n ? "," : "");
+        for (Function* f : edl_->trusted_funcs_)
+            for (Decl* p : f->params_)
+                if (is_chunked(p))
+                    out() << "    (oe_ecall_func_t) ecall_" + f->name_ + "_" +
+                                 p->name_ + "_chunk" + (++idx < n ? "," : "");
+        for (Channel* c : edl_->channels_)
+            out() << "    (oe_ecall_func_t) ecall_oe_channel_" + c->name_ +
+                         (++idx < n ? "," : "");
         out() << "};"
               << ""
               << "size_t oe_ecalls_table_size = "
@@ -233,6 +459,8 @@ class CEmitter
                      "_ocall_function_table[] = {";
         for (Function* f : edl_->untrusted_funcs_)
             out() << "    (oe_ocall_func_t) ocall_" + f->name_ + ",";
+        if (has_deferred(edl_))
+            out() << "    (oe_ocall_func_t) ocall_oe_deferred_batch,";
         out() << "    NULL"
               << "};"
               << "";
@@ -240,12 +468,12 @@ class CEmitter
 
     void emit_forwarder(Function* f)
     {
-        FEmitter(edl_, file_).emit(f, gen_t_c_);
+        FEmitter(edl_, file_, options_).emit(f, gen_t_c_);
     }
 
     void emit_wrapper(Function* f, const std::string& prefix = "")
     {
-        WEmitter(edl_, file_).emit(f, !gen_t_c_, prefix);
+        WEmitter(edl_, file_, options_).emit(f, !gen_t_c_, prefix);
     }
 };
 
@@ -0,0 +1,648 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef D_EMITTER_H
+#define D_EMITTER_H
+
+#include <fstream>
+#include <set>
+
+#include "ast.h"
+#include "options.h"
+#include "utils.h"
+
+/*
+ * Emits one static helper per deep-copyable struct type and direction. The
+ * wrappers and forwarders call them for each deep-copied parameter instead
+ * of expanding the nested pointers of the type inline.
+ *
+ * Every helper handles _count consecutive elements and visits their nested
+ * pointers in the same order, which defines the layout of the nested blocks
+ * in the marshalling buffers.
+ */
+class DEmitter
+{
+    Edl* edl_;
+    std::ofstream& file_;
+    const Options& options_;
+    bool gen_t_;
+
+    std::set<UserType*> size_types_;
+    std::set<UserType*> serialize_types_;
+    std::set<UserType*> fixup_types_;
+    std::set<UserType*> fixup_table_types_;
+    std::set<UserType*> serialize_out_types_;
+    std::set<UserType*> free_types_;
+
+  public:
+    typedef DEmitter& R;
+    R out()
+    {
+        return *this;
+    }
+
+    template <typename T>
+    R operator<<(const T& t)
+    {
+        file_ << t << "\n";
+        return out();
+    }
+
+  public:
+    DEmitter(Edl* edl, std::ofstream& file, const Options& options)
+        : edl_(edl), file_(file), options_(options), gen_t_(false)
+    {
+    }
+
+    /*
+     * Emit the helpers used by the forwarders of the forwarded functions and
+     * by the wrappers of the wrapped functions.
+     */
+    void emit(
+        const std::vector<Function*>& forwarded,
+        const std::vector<Function*>& wrapped,
+        bool gen_t)
+    {
+        gen_t_ = gen_t;
+        for (Function* f : forwarded)
+        {
+            for (Decl* p : f->params_)
+            {
+                UserType* ut = get_user_type_for_deep_copy(edl_, p);
+                if (!ut)
+                    continue;
+                if (p->attrs_->in_ || p->attrs_->inout_)
+                    collect(ut, fixup_types_);
+                else if (p->attrs_->out_)
+                {
+                    collect(ut, size_types_);
+                    collect(ut, serialize_out_types_);
+                    collect_free(ut);
+                }
+            }
+        }
+        for (Function* f : wrapped)
+        {
+            for (Decl* p : f->params_)
+            {
+                UserType* ut = get_user_type_for_deep_copy(edl_, p);
+                if (ut && (p->attrs_->in_ || p->attrs_->inout_))
+                {
+                    collect(ut, size_types_);
+                    collect(ut, serialize_types_);
+                }
+            }
+        }
+        /* The fixup tables replace the per-type fixup helpers. */
+        if (options_.deepcopy_offsets_)
+            fixup_table_types_.swap(fixup_types_);
+        if (size_types_.empty() && serialize_types_.empty() &&
+            fixup_types_.empty() && fixup_table_types_.empty() &&
+            serialize_out_types_.empty() && free_types_.empty())
+            return;
+
+        /* Prototypes first since the types can nest in any order. */
+        out() << "/**** Deep-copy helpers. ****/"
+              << "";
+        for (UserType* ut : edl_->types_)
+        {
+            if (size_types_.count(ut))
+                out() << size_prototype(ut) + ";";
+            if (serialize_types_.count(ut))
+                out() << serialize_prototype(ut) + ";";
+            if (fixup_types_.count(ut))
+                out() << fixup_prototype(ut) + ";";
+            if (serialize_out_types_.count(ut))
+                out() << serialize_out_prototype(ut) + ";";
+            if (free_types_.count(ut))
+                out() << free_prototype(ut) + ";";
+        }
+        out() << "";
+        for (UserType* ut : edl_->types_)
+        {
+            if (size_types_.count(ut))
+                emit_size(ut);
+            if (serialize_types_.count(ut))
+                emit_serialize(ut);
+            if (fixup_types_.count(ut))
+                emit_fixup(ut);
+            if (serialize_out_types_.count(ut))
+                emit_serialize_out(ut);
+            if (free_types_.count(ut))
+                emit_free(ut);
+        }
+        if (!fixup_table_types_.empty())
+            emit_fixup_tables();
+    }
+
+  private:
+    void collect(UserType* ut, std::set<UserType*>& types)
+    {
+        if (!ut || !types.insert(ut).second)
+            return;
+        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+            collect(get_user_type_for_deep_copy(edl_, prop), types);
+        });
+    }
+
+    void collect_free(UserType* ut)
+    {
+        if (!ut || !free_types_.insert(ut).second)
+            return;
+        iterate_freeable_fields(
+            ut, [&](Decl* field) { collect_free(nested_type(field)); });
+    }
+
+    /* Only the pointers owned by the user function are freed. */
+    template <typename Action>
+    void iterate_freeable_fields(UserType* ut, Action&& action)
+    {
+        for (Decl* field : ut->fields_)
+        {
+            if (field->type_->tag_ != Ptr || !field->attrs_ ||
+                field->attrs_->user_check_ || field->attrs_->is_size_or_count_)
+                continue;
+            action(field);
+        }
+    }
+
+    UserType* nested_type(Decl* prop)
+    {
+        return get_user_type_for_deep_copy(edl_, prop);
+    }
+
+    static std::string nested_count(Decl* prop)
+    {
+        std::string count = count_attr_str(prop->attrs_->count_, "_p[_i].");
+        return count.empty() ? "1" : count;
+    }
+
+    std::string size_prototype(UserType* ut)
+    {
+        return "static oe_result_t " + deepcopy_helper_name("size", ut) +
+               "(\n    const " + ut->name_ +
+               "* _p,\n    size_t _count,\n    size_t* _size)";
+    }
+
+    std::string serialize_prototype(UserType* ut)
+    {
+        return "static oe_result_t " + deepcopy_helper_name("serialize", ut) +
+               "(\n    " + ut->name_ + "* _dst,\n    const " + ut->name_ +
+               "* _src,\n    size_t _count,\n    uint8_t* _buffer,\n"
+               "    size_t* _offset)";
+    }
+
+    std::string fixup_prototype(UserType* ut)
+    {
+        return "static oe_result_t " + deepcopy_helper_name("fixup", ut) +
+               "(\n    " + ut->name_ +
+               "* _p,\n    size_t _count,\n    uint8_t* _buffer,\n"
+               "    size_t _buffer_size,\n    size_t* _offset)";
+    }
+
+    std::string serialize_out_prototype(UserType* ut)
+    {
+        return "static oe_result_t " +
+               deepcopy_helper_name("serialize_out", ut) + "(\n    const " +
+               ut->name_ +
+               "* _p,\n    size_t _count,\n    uint8_t* _buffer,\n"
+               "    size_t* _offset)";
+    }
+
+    std::string free_prototype(UserType* ut)
+    {
+        return "static void " + deepcopy_helper_name("free", ut) + "(\n    " +
+               ut->name_ + "* _p,\n    size_t _count)";
+    }
+
+    void begin(const std::string& prototype)
+    {
+        out() << prototype << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    for (size_t _i = 0; _i < _count; _i++)"
+              << "    {";
+    }
+
+    void end()
+    {
+        out() << "    }"
+              << ""
+              << "    _result = OE_OK;"
+              << ""
+              << "done:"
+              << "    return _result;"
+              << "}"
+              << "";
+    }
+
+    /*
+     * Call the helper of the given kind on a nested pointer that has a
+     * user-defined type.
+     */
+    void call(
+        const std::string& kind,
+        Decl* prop,
+        const std::vector<std::string>& args)
+    {
+        UserType* ut = nested_type(prop);
+        if (!ut)
+            return;
+        out() << deepcopy_helper_call(
+            "            ", deepcopy_helper_name(kind, ut), args);
+    }
+
+    /*
+     * Add the sizes of the nested blocks, not including the elements.
+     */
+    void emit_size(UserType* ut)
+    {
+        begin(size_prototype(ut));
+        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+            std::string expr = "_p[_i]." + prop->name_;
+            out() << "        if (" + expr + ")"
+                  << "        {"
+                  << "            OE_ADD_ARG_SIZE(*_size, " +
+                         pcount(prop, "_p[_i].") + ", " +
+                         psize(prop, "_p[_i].") + ");";
+            call("size", prop, {expr, nested_count(prop), "_size"});
+            out() << "        }";
+        });
+        end();
+    }
+
+    /*
+     * Copy the nested blocks of _src into the buffer and set the nested
+     * pointers of _dst, the copy of _src in the buffer, to their offsets, so
+     * that no address of the sender is passed to the other side.
+     */
+    void emit_serialize(UserType* ut)
+    {
+        std::string memcpy_fn = gen_t_ ? "oe_memcpy_with_barrier" : "memcpy";
+        begin(serialize_prototype(ut));
+        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+            std::string dst = "_dst[_i]." + prop->name_;
+            std::string src = "_src[_i]." + prop->name_;
+            std::string mt = mtype_str(prop);
+            out() << "        if (" + src + ")"
+                  << "        {"
+                  << "            size_t _size = 0;"
+                  << "            OE_COMPUTE_ARG_SIZE(_size, " +
+                         pcount(prop, "_src[_i].") + ", " +
+                         psize(prop, "_src[_i].") + ");"
+                  << "            " + dst + " = (" + mt +
+                         ")(_buffer + *_offset);"
+                  << "            OE_ADD_SIZE(*_offset, _size);"
+                  << "            " + memcpy_fn + "((void*)" + dst + ", " +
+                         src + ", _size);";
+            UserType* prop_ut = nested_type(prop);
+            if (prop_ut)
+            {
+                std::string count =
+                    count_attr_str(prop->attrs_->count_, "_src[_i].");
+                call(
+                    "serialize",
+                    prop,
+                    {"(" + prop_ut->name_ + "*)" + dst,
+                     src,
+                     count.empty() ? "1" : count,
+                     "_buffer",
+                     "_offset"});
+            }
+
+            /* The nested blocks are written through the pointer, so it is
+             * only replaced by its offset once they are all written. */
+            std::string offset = "(" + mt + ")(uintptr_t)((const uint8_t*)" +
+                                 dst + " - _buffer)";
+            if (gen_t_)
+                out() << "            " + mt + " _ptr = " + offset + ";"
+                      << "            oe_memcpy_with_barrier((void*)&" + dst +
+                             ", &_ptr, sizeof(_ptr));";
+            else
+                out() << "            " + dst + " = " + offset + ";";
+            out() << "        }";
+        });
+        end();
+    }
+
+    /*
+     * Point the nested pointers of the elements, which live in the buffer,
+     * at their blocks. Make sure that the buffer has enough space.
+     */
+    void emit_fixup(UserType* ut)
+    {
+        begin(fixup_prototype(ut));
+        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+            std::string expr = "_p[_i]." + prop->name_;
+            out() << "        if (" + expr + ")"
+                  << "        {"
+                  << "            " + expr + " = (" + mtype_str(prop) +
+                         ")(_buffer + *_offset);"
+                  << "            OE_ADD_ARG_SIZE(*_offset, " +
+                         pcount(prop, "_p[_i].") + ", " +
+                         psize(prop, "_p[_i].") + ");"
+                  << "            if (*_offset > _buffer_size)"
+                  << "            {"
+                  << "                _result = OE_BUFFER_TOO_SMALL;"
+                  << "                goto done;"
+                  << "            }";
+            UserType* prop_ut = nested_type(prop);
+            if (prop_ut)
+                call(
+                    "fixup",
+                    prop,
+                    {"(" + prop_ut->name_ + "*)" + expr,
+                     nested_count(prop),
+                     "_buffer",
+                     "_buffer_size",
+                     "_offset"});
+            out() << "        }";
+        });
+        end();
+    }
+
+    /*
+     * The count or size of a nested block as the offset and width of the
+     * field of the element that holds it, or as a constant.
+     */
+    static std::string fixup_value(
+        UserType* ut,
+        const Token& attr,
+        const std::string& constant)
+    {
+        if (attr.is_name())
+        {
+            std::string field = attr;
+            return "OE_OFFSETOF(" + ut->name_ + ", " + field +
+                   "),\n     sizeof(((" + ut->name_ + "*)0)->" + field +
+                   "),\n     0";
+        }
+        return "0,\n     0,\n     " + constant;
+    }
+
+    /*
+     * Emit one table per type that lists its nested pointers, and a single
+     * function that walks the tables. Each nested pointer holds the offset
+     * of its block, which is checked against the end of the previous block
+     * and the end of the buffer before the pointer is set.
+     */
+    void emit_fixup_tables()
+    {
+        out() << "typedef struct _oe_deepcopy_fixup"
+              << "{"
+              << "    size_t offset;"
+              << "    size_t count_offset;"
+              << "    size_t count_width;"
+              << "    size_t count;"
+              << "    size_t size_offset;"
+              << "    size_t size_width;"
+              << "    size_t size;"
+              << "    size_t type;"
+              << "} _oe_deepcopy_fixup_t;"
+              << ""
+              << "typedef struct _oe_deepcopy_fixup_type"
+              << "{"
+              << "    size_t size;"
+              << "    const _oe_deepcopy_fixup_t* fixups;"
+              << "    size_t num_fixups;"
+              << "} _oe_deepcopy_fixup_type_t;"
+              << ""
+              << "enum"
+              << "{"
+              << "    _oe_deepcopy_no_type,";
+        for (UserType* ut : edl_->types_)
+            if (fixup_table_types_.count(ut))
+                out() << "    " + deepcopy_type_id(ut) + ",";
+        out() << "};"
+              << "";
+
+        std::vector<std::string> types{"    {0, NULL, 0},"};
+        for (UserType* ut : edl_->types_)
+        {
+            if (!fixup_table_types_.count(ut))
+                continue;
+            std::string fixups = "_oe_deepcopy_fixups_" + ut->name_;
+            size_t num_fixups = 0;
+            out() << "static const _oe_deepcopy_fixup_t " + fixups + "[] = {";
+            iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+                UserType* prop_ut = nested_type(prop);
+                std::string count =
+                    fixup_value(ut, prop->attrs_->count_, pcount(prop));
+                std::string size = fixup_value(
+                    ut,
+                    prop->attrs_->size_,
+                    prop->attrs_->size_.is_empty()
+                        ? psize(prop)
+                        : std::string(prop->attrs_->size_));
+                out() << "    {OE_OFFSETOF(" + ut->name_ + ", " +
+                             prop->name_ + "),"
+                      << "     " + count + ","
+                      << "     " + size + ","
+                      << "     " +
+                             (prop_ut ? deepcopy_type_id(prop_ut)
+                                      : "_oe_deepcopy_no_type") +
+                             "},";
+                num_fixups++;
+            });
+            out() << "};"
+                  << "";
+            types.push_back(
+                "    {sizeof(" + ut->name_ + "), " + fixups + ", " +
+                to_str(num_fixups) + "},");
+        }
+        out() << "static const _oe_deepcopy_fixup_type_t "
+                 "_oe_deepcopy_fixup_types[] = {";
+        for (const std::string& t : types)
+            out() << t;
+        out() << "};"
+              << "";
+
+        out() << "static oe_result_t _oe_deepcopy_fixup_value("
+              << "    const uint8_t* _p,"
+              << "    size_t _offset,"
+              << "    size_t _width,"
+              << "    size_t _constant,"
+              << "    size_t* _value)"
+              << "{"
+              << "    uint8_t _u8 = 0;"
+              << "    uint16_t _u16 = 0;"
+              << "    uint32_t _u32 = 0;"
+              << "    uint64_t _u64 = 0;"
+              << ""
+              << "    switch (_width)"
+              << "    {"
+              << "        case 0:"
+              << "            *_value = _constant;"
+              << "            return OE_OK;"
+              << "        case 1:"
+              << "            memcpy(&_u8, _p + _offset, sizeof(_u8));"
+              << "            *_value = _u8;"
+              << "            return OE_OK;"
+              << "        case 2:"
+              << "            memcpy(&_u16, _p + _offset, sizeof(_u16));"
+              << "            *_value = _u16;"
+              << "            return OE_OK;"
+              << "        case 4:"
+              << "            memcpy(&_u32, _p + _offset, sizeof(_u32));"
+              << "            *_value = _u32;"
+              << "            return OE_OK;"
+              << "        case 8:"
+              << "            memcpy(&_u64, _p + _offset, sizeof(_u64));"
+              << "            if (sizeof(_u64) > sizeof(size_t) &&"
+              << "                _u64 > OE_SIZE_MAX)"
+              << "                return OE_INVALID_PARAMETER;"
+              << "            *_value = (size_t)_u64;"
+              << "            return OE_OK;"
+              << "    }"
+              << "    return OE_INVALID_PARAMETER;"
+              << "}"
+              << "";
+
+        out() << "static oe_result_t _oe_deepcopy_fixup_offsets("
+              << "    size_t _type,"
+              << "    uint8_t* _p,"
+              << "    size_t _count,"
+              << "    uint8_t* _buffer,"
+              << "    size_t _buffer_size,"
+              << "    size_t* _offset)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << "    const _oe_deepcopy_fixup_type_t* _t ="
+              << "        &_oe_deepcopy_fixup_types[_type];"
+              << ""
+              << "    for (size_t _i = 0; _i < _count; _i++)"
+              << "    {"
+              << "        uint8_t* _elem = _p + _i * _t->size;"
+              << ""
+              << "        for (size_t _j = 0; _j < _t->num_fixups; _j++)"
+              << "        {"
+              << "            const _oe_deepcopy_fixup_t* _f = &_t->fixups[_j];"
+              << "            void* _ptr = NULL;"
+              << "            size_t _nested_count = 0;"
+              << "            size_t _nested_size = 0;"
+              << "            size_t _size = 0;"
+              << "            size_t _arg_offset = 0;"
+              << ""
+              << "            memcpy(&_ptr, _elem + _f->offset, sizeof(_ptr));"
+              << "            if (!_ptr)"
+              << "                continue;"
+              << ""
+              << "            if ((_result = _oe_deepcopy_fixup_value("
+              << "                     _elem,"
+              << "                     _f->count_offset,"
+              << "                     _f->count_width,"
+              << "                     _f->count,"
+              << "                     &_nested_count)) != OE_OK ||"
+              << "                (_result = _oe_deepcopy_fixup_value("
+              << "                     _elem,"
+              << "                     _f->size_offset,"
+              << "                     _f->size_width,"
+              << "                     _f->size,"
+              << "                     &_nested_size)) != OE_OK)"
+              << "                goto done;"
+              << "            OE_COMPUTE_ARG_SIZE("
+                 "_size, _nested_count, _nested_size);"
+              << ""
+              << "            /* The nested elements must fit in the block. */"
+              << "            if (_f->type &&"
+              << "                _nested_count > _size / "
+                 "_oe_deepcopy_fixup_types[_f->type].size)"
+              << "            {"
+              << "                _result = OE_INVALID_PARAMETER;"
+              << "                goto done;"
+              << "            }"
+              << ""
+              << "            /* The blocks follow each other without "
+                 "overlapping. */"
+              << "            _arg_offset = (size_t)(uintptr_t)_ptr;"
+              << "            if (_arg_offset < *_offset)"
+              << "            {"
+              << "                _result = OE_INVALID_PARAMETER;"
+              << "                goto done;"
+              << "            }"
+              << "            if (_arg_offset > _buffer_size ||"
+              << "                _size > _buffer_size - _arg_offset)"
+              << "            {"
+              << "                _result = OE_BUFFER_TOO_SMALL;"
+              << "                goto done;"
+              << "            }"
+              << ""
+              << "            _ptr = _buffer + _arg_offset;"
+              << "            memcpy(_elem + _f->offset, &_ptr, sizeof(_ptr));"
+              << "            *_offset = _arg_offset;"
+              << "            OE_ADD_SIZE(*_offset, _size);"
+              << ""
+              << "            if (_f->type &&"
+              << "                (_result = _oe_deepcopy_fixup_offsets("
+              << "                     _f->type,"
+              << "                     _buffer + _arg_offset,"
+              << "                     _nested_count,"
+              << "                     _buffer,"
+              << "                     _buffer_size,"
+              << "                     _offset)) != OE_OK)"
+              << "                goto done;"
+              << "        }"
+              << "    }"
+              << ""
+              << "    _result = OE_OK;"
+              << ""
+              << "done:"
+              << "    return _result;"
+              << "}"
+              << "";
+    }
+
+    /*
+     * Copy the nested blocks of the elements into the deep-copy out buffer.
+     */
+    void emit_serialize_out(UserType* ut)
+    {
+        begin(serialize_out_prototype(ut));
+        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+            std::string expr = "_p[_i]." + prop->name_;
+            out() << "        if (" + expr + ")"
+                  << "        {"
+                  << "            size_t _size = 0;"
+                  << "            OE_COMPUTE_ARG_SIZE(_size, " +
+                         pcount(prop, "_p[_i].") + ", " +
+                         psize(prop, "_p[_i].") + ");"
+                  << "            memcpy(_buffer + *_offset, " + expr +
+                         ", _size);"
+                  << "            OE_ADD_SIZE(*_offset, _size);";
+            call(
+                "serialize_out",
+                prop,
+                {expr, nested_count(prop), "_buffer", "_offset"});
+            out() << "        }";
+        });
+        end();
+    }
+
+    /*
+     * Free the nested pointers of the elements, not the elements.
+     */
+    void emit_free(UserType* ut)
+    {
+        out() << free_prototype(ut) << "{"
+              << "    for (size_t _i = 0; _i < _count; _i++)"
+              << "    {";
+        iterate_freeable_fields(ut, [&](Decl* field) {
+            std::string expr = "_p[_i]." + field->name_;
+            UserType* field_ut = nested_type(field);
+            if (field_ut)
+            {
+                std::string helper = deepcopy_helper_name("free", field_ut);
+                out() << "        if (" + expr + ")"
+                      << "            " + helper + "((" + field_ut->name_ +
+                             "*)" + expr + ", " + pcount(field, "_p[_i].") +
+                             ");";
+            }
+            out() << "        free(" + expr + ");";
+        });
+        out() << "    }"
+              << "}"
+              << "";
+    }
+};
+
+#endif // D_EMITTER_H
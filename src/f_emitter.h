@@ -7,12 +7,15 @@
 #include <fstream>
 
 #include "ast.h"
+#include "layout.h"
+#include "options.h"
 #include "utils.h"
 
 class FEmitter
 {
     Edl* edl_;
     std::ofstream& file_;
+    const Options& options_;
     bool ecall_;
     bool has_deep_copy_out_;
 
@@ -31,8 +34,8 @@ class FEmitter
     }
 
   public:
-    FEmitter(Edl* edl, std::ofstream& file)
-        : edl_(edl), file_(file), ecall_(true)
+    FEmitter(Edl* edl, std::ofstream& file, const Options& options)
+        : edl_(edl), file_(file), options_(options), ecall_(true)
     {
         (void)edl_;
     }
@@ -43,6 +46,8 @@ class FEmitter
         has_deep_copy_out_ = has_deep_copy_out(edl_, f);
         std::string pfx = ecall_ ? "ecall_" : "ocall_";
         std::string args_t = f->name_ + "_args_t";
+        /* OCALL forwarders receive the wrapper's aligned buffers. */
+        std::string align = ecall_ ? buffer_align_str(f) : "";
         out() << "static void " + pfx + f->name_ + "("
               << "    uint8_t* input_buffer,"
               << "    size_t input_buffer_size,"
@@ -58,8 +63,10 @@ class FEmitter
               << "    " + args_t + "* _pargs_in = (" + args_t +
                      "*)input_buffer;"
               << "    " + args_t + "* _pargs_out = (" + args_t +
-                     "*)output_buffer;"
-              << "";
+                     "*)output_buffer;";
+        if (!align.empty())
+            out() << "    uint8_t* _unaligned_output_buffer = output_buffer;";
+        out() << "";
         if (has_deep_copy_out_)
         {
             out() << "    uint8_t* _deepcopy_out_buffer = NULL;"
@@ -68,11 +75,15 @@ class FEmitter
                   << "";
         }
         out() << "    size_t _input_buffer_offset = 0;"
-              << "    size_t _output_buffer_offset = 0;"
-              << "    OE_ADD_SIZE(_input_buffer_offset, sizeof(*_pargs_in));"
+              << "    size_t _output_buffer_offset = 0;";
+        if (has_variable_length(f))
+            out() << "    size_t _variable_output_offset = 0;";
+        out() << "    OE_ADD_SIZE(_input_buffer_offset, sizeof(*_pargs_in));"
               << "    OE_ADD_SIZE(_output_buffer_offset, sizeof(*_pargs_out));"
-              << ""
-              << "    if (input_buffer_size < sizeof(*_pargs_in) || "
+              << "";
+        if (options_.instrument_)
+            out() << trace_begin_str(f, edl_, ecall_) << "";
+        out() << "    if (input_buffer_size < sizeof(*_pargs_in) || "
                  "output_buffer_size < sizeof(*_pargs_in))"
               << "        goto done;"
               << "";
@@ -80,11 +91,19 @@ class FEmitter
             ecall_buffer_checks();
         else
             ocall_buffer_checks();
+        if (!align.empty())
+            out() << "    /* Align the buffers to " + align +
+                         " bytes, in the room reserved by the wrapper. */"
+                  << "    OE_ALIGN_ECALL_BUFFERS(" + align + ");"
+                  << "    _pargs_in = (" + args_t + "*)input_buffer;"
+                  << "    _pargs_out = (" + args_t + "*)output_buffer;"
+                  << "";
         out() << "    /* Set in and in-out pointers. */";
         set_in_in_out_pointers(f);
         out() << "    /* Set out and in-out pointers. */"
               << "    /* In-out parameters are copied to output buffer. */";
         set_out_in_out_pointers(f);
+        clear_chunked_pointers(f);
         if (ecall_)
         {
             out() << "    /* Check that in/in-out strings are null terminated. "
@@ -94,8 +113,13 @@ class FEmitter
                   << "    oe_lfence();"
                   << "";
         }
+        if (options_.instrument_)
+            out() << trace_point_str(f, edl_, "UNMARSHALLED", "") << "";
         out() << "    /* Call user function. */";
         call_user_function(f);
+        if (options_.instrument_)
+            out() << trace_point_str(f, edl_, "RETURNED", "") << "";
+        pack_variable_length_params(f);
         if (has_deep_copy_out_)
         {
             out() << "    /* Compute the size for the deep-copy out buffer. */";
@@ -136,6 +160,16 @@ class FEmitter
                   << "    _pargs_out->deepcopy_out_buffer_size = 0;"
                   << "";
         propagate_errno(f);
+        if (options_.instrument_)
+            out() << trace_point_str(f, edl_, "MARSHALLED", "") << "";
+        /* The padding is only counted, like the rounding of the args struct,
+         * so that the written size matches the computed one. */
+        if (options_.compact_layout_)
+            out() << "    /* The compact layout pads the end of the output "
+                     "buffer. */"
+                  << "    OE_ALIGN_SIZE_COMPACT(_output_buffer_offset, "
+                     "OE_EDGER8R_BUFFER_ALIGNMENT);"
+                  << "";
         out() << "    /* Success. */"
               << "    _result = OE_OK;"
               << "    *output_bytes_written = _output_buffer_offset;"
@@ -154,14 +188,420 @@ class FEmitter
                 << "";
             out() << "    /* Free nested buffers allocated by the user "
                      "function. */";
-            free_deep_copy_out(f, "_pargs_in->", "_pargs_in->", "    ");
+            free_deep_copy_out(f);
             out() << "";
         }
         write_result();
+        if (!align.empty())
+            out() << ""
+                  << "    /* Move the output back to where the runtime copies "
+                     "it from. */"
+                  << "    OE_UNALIGN_ECALL_OUTPUT_BUFFER("
+                     "_unaligned_output_buffer);";
+        if (options_.instrument_)
+            out() << trace_end_str(f, edl_);
+        out() << "}"
+              << "";
+    }
+
+    /*
+     * Emit the forwarder of the batch of a batchable ECALL, which calls the
+     * user function once for each arg struct that follows the batch header.
+     */
+    void emit_batch(Function* f)
+    {
+        ecall_ = true;
+        std::string args_t = f->name_ + "_args_t";
+        std::string header_t = edl_->name_ + "_batch_header_t";
+        out() << "static void ecall_" + f->name_ + "_batch("
+              << "    uint8_t* input_buffer,"
+              << "    size_t input_buffer_size,"
+              << "    uint8_t* output_buffer,"
+              << "    size_t output_buffer_size,"
+              << "    size_t* output_bytes_written)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    /* Prepare parameters. */"
+              << "    " + header_t + "* _pheader_in = (" + header_t +
+                     "*)input_buffer;"
+              << "    " + header_t + "* _pheader_out = (" + header_t +
+                     "*)output_buffer;"
+              << "    " + args_t + "* _pargs_in = (" + args_t +
+                     "*)(_pheader_in + 1);"
+              << "    " + args_t + "* _pargs_out = (" + args_t +
+                     "*)(_pheader_out + 1);"
+              << "    size_t _count = 0;"
+              << "    size_t _buffer_size = 0;"
+              << "    size_t _i = 0;"
+              << ""
+              << "    if (input_buffer_size < sizeof(*_pheader_in) || "
+                 "output_buffer_size < sizeof(*_pheader_in))"
+              << "        goto done;"
+              << "";
+        ecall_buffer_checks();
+        out() << "    /* Both buffers must hold the arg structs of all the "
+                 "calls. */"
+              << "    _count = _pheader_in->count;"
+              << "    OE_ADD_SIZE(_buffer_size, sizeof(*_pheader_in));"
+              << "    OE_ADD_ARG_SIZE(_buffer_size, _count, "
+                 "sizeof(*_pargs_in));"
+              << "    if (input_buffer_size < _buffer_size || "
+                 "output_buffer_size < _buffer_size)"
+              << "        goto done;"
+              << ""
+              << "    /* lfence after checks. */"
+              << "    oe_lfence();"
+              << ""
+              << "    /* Call user function for each entry. */"
+              << "    for (_i = 0; _i < _count; _i++)"
+              << "    {";
+        std::string retstr = (f->rtype_->tag_ != Void)
+                                 ? "_pargs_out[_i].oe_retval = "
+                                 : "";
+        out() << "        " + retstr + f->name_ + "(";
+        size_t idx = 0;
+        for (Decl* p : f->params_)
+            out() << "            _pargs_in[_i]." + p->name_ +
+                         (++idx < f->params_.size() ? "," : ");");
+        if (idx == 0)
+            out() << "        );";
+        out() << "        _pargs_out[_i].oe_result = OE_OK;"
+              << "    }"
+              << ""
+              << "    /* There is no deep-copyable out parameter. */"
+              << "    _pheader_out->deepcopy_out_buffer = NULL;"
+              << "    _pheader_out->deepcopy_out_buffer_size = 0;"
+              << "    _pheader_out->count = _count;"
+              << ""
+              << "    /* Success. */"
+              << "    _result = OE_OK;"
+              << "    *output_bytes_written = _buffer_size;"
+              << ""
+              << "done:"
+              << "    if (output_buffer_size >= sizeof(*_pheader_out) &&"
+              << "        oe_is_within_enclave(_pheader_out, "
+                 "output_buffer_size))"
+              << "        _pheader_out->oe_result = _result;"
+              << "}"
+              << "";
+    }
+
+    /*
+     * Emit the forwarder of the ECALL that carries one chunk of a chunked
+     * parameter, which passes the chunk to the sink of an in parameter or
+     * fills it from the source of an out parameter. The chunk flags make it
+     * begin the call first or abort it instead.
+     */
+    void emit_chunk(Function* f, Decl* p)
+    {
+        ecall_ = true;
+        bool in = p->attrs_->in_;
+        std::string header_t = edl_->name_ + "_chunk_header_t";
+        std::string args_t = f->name_ + "_args_t";
+        std::string type = chunk_type_str(p);
+        std::string buffer = in ? "input_buffer" : "output_buffer";
+        std::string callback = f->name_ + "_" + p->name_;
+        std::vector<std::string> args;
+        for (Decl* q : f->params_)
+            if (is_by_value(q))
+                args.push_back("_args." + q->name_);
+        std::vector<std::string> chunk_args = args;
+        chunk_args.push_back(
+            "(" + std::string(in ? "const " : "") + type + "*)(" + buffer +
+            " + _chunk_offset)");
+        chunk_args.push_back("(size_t)_offset");
+        chunk_args.push_back("(size_t)_count");
+        out() << "static void ecall_" + callback + "_chunk("
+              << "    uint8_t* input_buffer,"
+              << "    size_t input_buffer_size,"
+              << "    uint8_t* output_buffer,"
+              << "    size_t output_buffer_size,"
+              << "    size_t* output_bytes_written)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    /* Prepare parameters. */"
+              << "    " + header_t + "* _pheader_in = (" + header_t +
+                     "*)input_buffer;"
+              << "    " + header_t + "* _pheader_out = (" + header_t +
+                     "*)output_buffer;"
+              << "    " + args_t + " _args;"
+              << "    uint64_t _flags = 0;"
+              << "    uint64_t _offset = 0;"
+              << "    uint64_t _count = 0;"
+              << "    size_t _input_buffer_offset = 0;";
+        if (!in)
+            out() << "    size_t _output_buffer_offset = 0;";
+        out() << "    size_t _args_offset = 0;"
+              << "    size_t _chunk_offset = 0;"
+              << ""
+              << "    if (input_buffer_size < sizeof(*_pheader_in) || "
+                 "output_buffer_size < sizeof(*_pheader_in))"
+              << "        goto done;"
+              << "";
+        ecall_buffer_checks();
+        out() << "    /* The args struct follows the header in the input "
+                 "buffer, and the chunk"
+              << "       follows " + std::string(in ? "it" : "the header") +
+                     " in the " + std::string(in ? "input" : "output") +
+                     " buffer. */"
+              << "    _flags = _pheader_in->flags;"
+              << "    _offset = _pheader_in->offset;"
+              << "    _count = _pheader_in->count;"
+              << "    if (_count > " + chunk_count_str(p) + ")"
+              << "        goto done;"
+              << "    OE_ADD_SIZE(_input_buffer_offset, sizeof(*_pheader_in));"
+              << "    _args_offset = _input_buffer_offset;"
+              << "    OE_ADD_SIZE(_input_buffer_offset, sizeof(_args));";
+        if (!in)
+            out() << "    if (_input_buffer_offset > input_buffer_size)"
+                  << "        goto done;"
+                  << "    OE_ADD_SIZE(_output_buffer_offset, "
+                     "sizeof(*_pheader_in));";
+        out() << "    _chunk_offset = _" + buffer + "_offset;"
+              << "    OE_ADD_ARG_SIZE(_" + buffer + "_offset, _count, sizeof(" +
+                     type + "));"
+              << "    if (_" + buffer + "_offset > " + buffer + "_size)"
+              << "        goto done;"
+              << "    memcpy(&_args, input_buffer + _args_offset, "
+                 "sizeof(_args));"
+              << ""
+              << "    /* lfence after checks. */"
+              << "    oe_lfence();"
+              << ""
+              << "    /* Call user functions. */"
+              << "    if (_flags & OE_CHUNK_ABORT)"
+              << "        " + callback + "_abort" +
+                     replace(args_str(args, "()"), "\n", "\n        ") + ";"
+              << "    else"
+              << "    {"
+              << "        if (_flags & OE_CHUNK_BEGIN)"
+              << "            " + callback + "_begin" +
+                     replace(args_str(args, "()"), "\n", "\n            ") +
+                     ";"
+              << "        " + callback + (in ? "_sink" : "_source") +
+                     replace(args_str(chunk_args), "\n", "\n        ") + ";"
+              << "    }"
+              << ""
+              << "    /* There is no deep-copyable out parameter. */"
+              << "    _pheader_out->deepcopy_out_buffer = NULL;"
+              << "    _pheader_out->deepcopy_out_buffer_size = 0;"
+              << ""
+              << "    /* Success. */"
+              << "    _result = OE_OK;"
+              << "    *output_bytes_written = " +
+                     std::string(
+                         in ? "sizeof(*_pheader_out)"
+                            : "_output_buffer_offset") +
+                     ";"
+              << ""
+              << "done:"
+              << "    if (output_buffer_size >= sizeof(*_pheader_out) &&"
+              << "        oe_is_within_enclave(_pheader_out, "
+                 "output_buffer_size))"
+              << "        _pheader_out->oe_result = _result;"
+              << "}"
+              << "";
+    }
+
+    /*
+     * Emit the enclave side of a channel: its state, the forwarder of the
+     * ECALL that attaches the ring allocated by the host, and the function
+     * that moves records through the ring in the direction of the channel.
+     */
+    void emit_channel(Channel* c)
+    {
+        ecall_ = true;
+        std::string args_t = edl_->name_ + "_channel_args_t";
+        std::string channel = "_" + edl_->name_ + "_" + c->name_ + "_channel";
+        out() << "static oe_channel_t " + channel + " = {"
+              << "    NULL,"
+              << "    " + channel_capacity_str(c) + ","
+              << "    sizeof(" + atype_str(c->type_) + "),"
+              << "    0,"
+              << "    0};"
+              << ""
+              << "static void ecall_oe_channel_" + c->name_ + "("
+              << "    uint8_t* input_buffer,"
+              << "    size_t input_buffer_size,"
+              << "    uint8_t* output_buffer,"
+              << "    size_t output_buffer_size,"
+              << "    size_t* output_bytes_written)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    /* Prepare parameters. */"
+              << "    " + args_t + "* _pargs_in = (" + args_t +
+                     "*)input_buffer;"
+              << "    " + args_t + "* _pargs_out = (" + args_t +
+                     "*)output_buffer;"
+              << "    oe_channel_ring_t* _ring = NULL;"
+              << ""
+              << "    if (input_buffer_size < sizeof(*_pargs_in) || "
+                 "output_buffer_size < sizeof(*_pargs_in))"
+              << "        goto done;"
+              << "";
+        ecall_buffer_checks();
+        out() << "    /* The whole ring must lie outside the enclave. A null "
+                 "ring closes the channel. */"
+              << "    _ring = _pargs_in->ring;"
+              << "    if (_ring && !oe_is_outside_enclave(_ring, "
+                 "oe_channel_ring_size(&" +
+                     channel + ")))"
+              << "    {"
+              << "        _result = OE_INVALID_PARAMETER;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    /* lfence after checks. */"
+              << "    oe_lfence();"
+              << ""
+              << "    /* Both indexes start over with the new ring. */"
+              << "    " + channel + ".ring = _ring;"
+              << "    " + channel + ".head = 0;"
+              << "    " + channel + ".tail = 0;"
+              << ""
+              << "    /* There is no deep-copyable out parameter. */"
+              << "    _pargs_out->deepcopy_out_buffer = NULL;"
+              << "    _pargs_out->deepcopy_out_buffer_size = 0;"
+              << ""
+              << "    /* Success. */"
+              << "    _result = OE_OK;"
+              << "    *output_bytes_written = sizeof(*_pargs_out);"
+              << ""
+              << "done:"
+              << "    if (output_buffer_size >= sizeof(*_pargs_out) &&"
+              << "        oe_is_within_enclave(_pargs_out, "
+                 "output_buffer_size))"
+              << "        _pargs_out->oe_result = _result;"
+              << "}"
+              << "";
+        if (channel_sends(c, false))
+            out() << channel_send_prototype(c, false) << "{"
+                  << "    return oe_channel_send(&" + channel +
+                         ", records, count);"
+                  << "}"
+                  << "";
+        else
+            out() << "/* Records are copied into the enclave before use. */"
+                  << channel_receive_prototype(c, false) << "{"
+                  << "    return oe_channel_receive(&" + channel +
+                         ", records, count);"
+                  << "}"
+                  << "";
+    }
+
+    /*
+     * Emit the host-side forwarder that replays the records of a flushed
+     * deferred OCALL buffer through the forwarders of the deferred OCALLs.
+     */
+    void emit_deferred_batch(const std::vector<Function*>& funcs)
+    {
+        ecall_ = false;
+        std::string args_t = edl_->name_ + "_deferred_batch_args_t";
+        std::string record_t = edl_->name_ + "_deferred_record_t";
+        out() << "static void ocall_oe_deferred_batch("
+              << "    uint8_t* input_buffer,"
+              << "    size_t input_buffer_size,"
+              << "    uint8_t* output_buffer,"
+              << "    size_t output_buffer_size,"
+              << "    size_t* output_bytes_written)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    /* Prepare parameters. */"
+              << "    " + args_t + "* _pargs_in = (" + args_t +
+                     "*)input_buffer;"
+              << "    " + args_t + "* _pargs_out = (" + args_t +
+                     "*)output_buffer;"
+              << "    " + record_t + "* _record = NULL;"
+              << "    size_t _record_bytes_written = 0;"
+              << ""
+              << "    size_t _input_buffer_offset = 0;"
+              << "    size_t _output_buffer_offset = 0;"
+              << "    OE_ADD_SIZE(_input_buffer_offset, sizeof(*_pargs_in));"
+              << "    OE_ADD_SIZE(_output_buffer_offset, sizeof(*_pargs_out));"
+              << ""
+              << "    if (input_buffer_size < sizeof(*_pargs_in) || "
+                 "output_buffer_size < sizeof(*_pargs_in))"
+              << "        goto done;"
+              << "";
+        ocall_buffer_checks();
+        out() << "    /* Call the host functions in the order of the records. "
+                 "*/"
+              << "    while (_input_buffer_offset < input_buffer_size)"
+              << "    {"
+              << "        _record = (" + record_t +
+                     "*)(input_buffer + _input_buffer_offset);"
+              << "        OE_ADD_SIZE(_input_buffer_offset, sizeof(*_record));"
+              << "        if (_input_buffer_offset > input_buffer_size)"
+              << "            goto done;"
+              << "        OE_ADD_SIZE(_input_buffer_offset, _record->size);"
+              << "        if (_input_buffer_offset > input_buffer_size)"
+              << "            goto done;"
+              << ""
+              << "        switch (_record->function_id)"
+              << "        {";
+        for (Function* f : funcs)
+        {
+            if (!f->deferred_)
+                continue;
+            std::string f_args_t = f->name_ + "_args_t";
+            out() << "            case " + edl_->name_ + "_fcn_id_" +
+                         f->name_ + ":"
+                  << "            {"
+                  << "                " + f_args_t + " _args_out;"
+                  << "                ocall_" + f->name_ + "("
+                  << "                    (uint8_t*)(_record + 1),"
+                  << "                    (size_t)_record->size,"
+                  << "                    (uint8_t*)&_args_out,"
+                  << "                    sizeof(_args_out),"
+                  << "                    &_record_bytes_written);"
+                  << "                if ((_result = _args_out.oe_result) != "
+                     "OE_OK)"
+                  << "                    goto done;"
+                  << "                break;"
+                  << "            }";
+        }
+        out() << "            default:"
+              << "                _result = OE_NOT_FOUND;"
+              << "                goto done;"
+              << "        }"
+              << "    }"
+              << ""
+              << "    /* There is no deep-copyable out parameter. */"
+              << "    _pargs_out->deepcopy_out_buffer = NULL;"
+              << "    _pargs_out->deepcopy_out_buffer_size = 0;"
+              << ""
+              << "    /* Success. */"
+              << "    _result = OE_OK;"
+              << "    *output_bytes_written = _output_buffer_offset;"
+              << ""
+              << "done:";
+        write_result();
         out() << "}"
               << "";
     }
 
+    /* Never pass the host's pointer of a chunked parameter to the enclave. */
+    void clear_chunked_pointers(Function* f)
+    {
+        bool empty = true;
+        for (Decl* p : f->params_)
+        {
+            if (!is_chunked(p))
+                continue;
+            if (empty)
+                out() << "    /* Chunked parameters are streamed before or "
+                         "after the call. */";
+            out() << "    _pargs_in->" + p->name_ + " = NULL;";
+            empty = false;
+        }
+        if (!empty)
+            out() << "";
+    }
+
     void ecall_buffer_checks()
     {
         out() << "    /* Make sure input and output buffers lie within the "
@@ -248,10 +688,25 @@ class FEmitter
         {
             if (!p->attrs_ || !(p->attrs_->in_ || p->attrs_->inout_))
                 continue;
+            if (in_place(p) || is_host_memory(p) || is_chunked(p))
+                continue;
+            /* Inline in-out parameters are copied to the output buffer. */
+            if (inline_param(p))
+            {
+                if (!p->attrs_->inout_)
+                    out() << "    if (_pargs_in->" + p->name_ + ")"
+                          << "        OE_SET_INLINE_IN_POINTER(" + p->name_ +
+                                 ", " + mtype_str(p) + ");";
+                empty = false;
+                continue;
+            }
             std::string argcount = pcount(p, "_pargs_in->");
             std::string argsize = psize(p, "_pargs_in->");
-            std::string cmd = (p->attrs_->inout_) ? "OE_SET_IN_OUT_POINTER"
-                                                  : "OE_SET_IN_POINTER";
+            std::string cmd = macro(
+                p,
+                p->attrs_->inout_ ? "OE_SET_IN_OUT_POINTER"
+                                  : "OE_SET_IN_POINTER");
+            align_offset(p, "_input_buffer_offset");
             out() << "    if (_pargs_in->" + p->name_ + ")"
                   << "        " + cmd + "(" + p->name_ + ", " + argcount +
                          ", " + argsize + ", " + mtype_str(p) + ");";
@@ -263,42 +718,110 @@ class FEmitter
 
             std::string count =
                 count_attr_str(p->attrs_->count_, "_pargs_in->");
-
-            if (count == "1" || count == "")
+            std::vector<std::string> args{
+                "_pargs_in->" + p->name_,
+                count == "" ? "1" : count,
+                "input_buffer",
+                "input_buffer_size",
+                "&_input_buffer_offset"};
+            std::string helper = deepcopy_helper_name("fixup", ut);
+            if (options_.deepcopy_offsets_)
             {
-                std::string cond = "_pargs_in->" + p->name_;
-                std::string expr = p->name_;
-                set_pointers_deep_copy(cond, expr, cmd, p, 2, "    ");
-            }
-            else
-            {
-                std::string cond = "_pargs_in->" + p->name_;
-                std::string expr = p->name_ + "[_i_1]";
-                out() << "    for (size_t _i_1 = 0; _i_1 < " + count +
-                             "; _i_1++)"
-                      << "    {";
-                set_pointers_deep_copy(cond, expr, cmd, p, 2, "        ");
-                out() << "    }";
+                helper = "_oe_deepcopy_fixup_offsets";
+                args[0] = "(uint8_t*)" + args[0];
+                args.insert(args.begin(), deepcopy_type_id(ut));
             }
+
+            out() << "    if (_pargs_in->" + p->name_ + ")"
+                  << "    {"
+                  << deepcopy_helper_call("        ", helper, args)
+                  << "    }";
         }
         if (empty)
             out() << "    /* There were no in nor in-out parameters. */";
         out() << "";
     }
 
+    bool in_place(Decl* p)
+    {
+        return is_in_place_in_out(edl_, options_, ecall_, p);
+    }
+
+    bool inline_param(Decl* p)
+    {
+        return is_inline_param(edl_, options_, p);
+    }
+
+    /* Pad the offset to the alignment of the parameter. */
+    void align_offset(Decl* p, const std::string& offset)
+    {
+        std::string align = align_offset_str(edl_, options_, p, offset);
+        if (!align.empty())
+            out() << "    " + align;
+    }
+
+    /* The variant of a marshalling macro for the layout of a parameter. */
+    std::string macro(Decl* p, const std::string& name)
+    {
+        return layout_macro(edl_, options_, p, name);
+    }
+
+    void set_in_place_pointers(Function* f)
+    {
+        bool empty = true;
+        for (Decl* p : f->params_)
+        {
+            if (!in_place(p))
+                continue;
+            if (empty)
+                out() << "    /* In-place in-out parameters lead the output "
+                         "buffer. */";
+            std::string argcount = pcount(p, "_pargs_in->");
+            std::string argsize = psize(p, "_pargs_in->");
+            align_offset(p, "_output_buffer_offset");
+            out() << "    if (_pargs_in->" + p->name_ + ")"
+                  << "        " + macro(p, "OE_SET_IN_PLACE_POINTER") + "(" +
+                         p->name_ + ", " + argcount + ", " + argsize + ", " +
+                         mtype_str(p) + ");";
+            empty = false;
+        }
+    }
+
     void set_out_in_out_pointers(Function* f)
     {
         bool empty = true;
+        set_in_place_pointers(f);
         for (Decl* p : f->params_)
         {
             if (!p->attrs_ || !(p->attrs_->out_ || p->attrs_->inout_))
                 continue;
+            if (is_host_memory(p) || is_chunked(p) || is_variable_length(p))
+                continue;
+            if (in_place(p))
+            {
+                empty = false;
+                continue;
+            }
+            if (inline_param(p))
+            {
+                out() << "    if (_pargs_in->" + p->name_ + ")"
+                      << "        " +
+                             std::string(
+                                 p->attrs_->inout_
+                                     ? "OE_COPY_AND_SET_INLINE_IN_OUT_POINTER("
+                                     : "OE_SET_INLINE_OUT_POINTER(") +
+                             p->name_ + ", " + mtype_str(p) + ");";
+                empty = false;
+                continue;
+            }
 
             std::string argcount = pcount(p, "_pargs_in->");
             std::string argsize = psize(p, "_pargs_in->");
-            std::string cmd = (p->attrs_->inout_)
-                                  ? "OE_COPY_AND_SET_IN_OUT_POINTER"
-                                  : "OE_SET_OUT_POINTER";
+            std::string cmd = macro(
+                p,
+                p->attrs_->inout_ ? "OE_COPY_AND_SET_IN_OUT_POINTER"
+                                  : "OE_SET_OUT_POINTER");
+            align_offset(p, "_output_buffer_offset");
             out() << "    if (_pargs_in->" + p->name_ + ")"
                   << "        " + cmd + "(" + p->name_ + ", " + argcount +
                          ", " + argsize + ", " + mtype_str(p) + ");";
@@ -332,62 +855,62 @@ class FEmitter
                 out() << "    }";
             }
         }
+        if (has_variable_length(f))
+        {
+            out() << "    /* Variable-length out parameters come last. */"
+                  << "    _variable_output_offset = _output_buffer_offset;";
+            empty = false;
+        }
+        for (Decl* p : f->params_)
+        {
+            if (!is_variable_length(p))
+                continue;
+            align_offset(p, "_output_buffer_offset");
+            out() << "    if (_pargs_in->" + p->name_ + ")"
+                  << "        " + macro(p, "OE_SET_OUT_POINTER") + "(" +
+                         p->name_ + ", " + pcount(p, "_pargs_in->") + ", " +
+                         psize(p, "_pargs_in->") + ", " + mtype_str(p) + ");";
+        }
         if (empty)
             out() << "    /* There were no out nor in-out parameters. */";
         out() << "";
     }
 
-    void add_size_deep_copy(
-        const std::string& parent_condition,
-        const std::string& parent_expr,
-        const std::string& buffer_size,
-        Decl* parent_prop,
-        int level,
-        std::string indent = "    ")
+    /* Move the produced part of each variable-length out parameter down so
+     * that only it is copied back. */
+    void pack_variable_length_params(Function* f)
     {
-        UserType* ut = get_user_type_for_deep_copy(edl_, parent_prop);
-        if (!ut)
+        if (!has_variable_length(f))
             return;
-        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
-            std::string op = *parent_expr.rbegin() == ']' ? "." : "->";
-            std::string expr = parent_expr + op + prop->name_;
-            std::string argcount = pcount(prop, parent_expr + op);
-            std::string argsize = psize(prop, parent_expr + op);
-            std::string cond = parent_condition + " && " + expr;
-            out() << indent + "if (" + cond + ")"
-                  << indent + "    OE_ADD_ARG_SIZE(" + buffer_size + ", " +
-                         argcount + ", " + argsize + ");";
-
-            UserType* ut = get_user_type_for_deep_copy(edl_, prop);
-            if (!ut)
-                return;
-
-            std::string count =
-                count_attr_str(prop->attrs_->count_, parent_expr + op);
-
-            if (count == "1" || count == "")
-            {
-                add_size_deep_copy(
-                    cond, expr, buffer_size, prop, level + 1, indent);
-            }
-            else
-            {
-                std::string idx = "_i_" + to_str(level);
-                std::string expr =
-                    parent_expr + op + prop->name_ + "[" + idx + "]";
-                out() << indent + "for (size_t " + idx + " = 0; " + idx +
-                             " < " + count + "; " + idx + "++)"
-                      << indent + "{";
-                add_size_deep_copy(
-                    cond, expr, buffer_size, prop, level + 1, indent + "    ");
-                out() << indent + "}";
-            }
-        });
+        out() << "    /* Pack the produced part of the variable-length out "
+                 "parameters. */"
+              << "    _output_buffer_offset = _variable_output_offset;";
+        for (Decl* p : f->params_)
+        {
+            if (!is_variable_length(p))
+                continue;
+            align_offset(p, "_output_buffer_offset");
+            out() << "    " + macro(p, "OE_PACK_OUT_PARAM") + "("
+                  << "        " + p->name_ + ","
+                  << "        " + length_value_str(p, "_pargs_in->") + ","
+                  << "        " + length_capacity_str(p, "_pargs_in->") + ","
+                  << "        " + length_unit_str(p, "_pargs_in->") + ");";
+        }
+        out() << "";
     }
 
     void compute_buffer_size_deep_copy_out(Function* f)
     {
-        std::string buffer_size = "_deepcopy_out_buffer_size";
+        call_deep_copy_out_helper(f, "size", {"&_deepcopy_out_buffer_size"});
+    }
+
+    /* Call the helper of the given kind for each deep-copyable out-only
+     * parameter. */
+    void call_deep_copy_out_helper(
+        Function* f,
+        const std::string& kind,
+        const std::vector<std::string>& args)
+    {
         std::string prefix = "_pargs_in->";
         for (Decl* p : f->params_)
         {
@@ -401,23 +924,16 @@ class FEmitter
                 continue;
 
             std::string count = count_attr_str(p->attrs_->count_, prefix);
-
-            if (count == "1" || count == "")
-            {
-                std::string cond = prefix + p->name_;
-                std::string expr = prefix + p->name_;
-                add_size_deep_copy(cond, expr, buffer_size, p, 2, "    ");
-            }
-            else
-            {
-                std::string cond = prefix + p->name_;
-                std::string expr = prefix + p->name_ + "[_i_1]";
-                out() << "    for (size_t _i_1 = 0; _i_1 < " + count +
-                             "; _i_1++)"
-                      << "    {";
-                add_size_deep_copy(cond, expr, buffer_size, p, 2, "        ");
-                out() << "    }";
-            }
+            std::vector<std::string> helper_args{
+                prefix + p->name_, count == "" ? "1" : count};
+            helper_args.insert(helper_args.end(), args.begin(), args.end());
+            out() << "    if (" + prefix + p->name_ + ")"
+                  << "    {"
+                  << deepcopy_helper_call(
+                         "        ",
+                         deepcopy_helper_name(kind, ut),
+                         helper_args)
+                  << "    }";
         }
     }
 
@@ -472,154 +988,18 @@ class FEmitter
         out() << "";
     }
 
-    void serialize_pointers_deep_copy(
-        const std::string& parent_condition,
-        const std::string& parent_expr,
-        const std::string& cmd,
-        Decl* parent_prop,
-        int level,
-        std::string indent = "    ")
-    {
-        UserType* ut = get_user_type_for_deep_copy(edl_, parent_prop);
-        if (!ut)
-            return;
-        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
-            std::string op = *parent_expr.rbegin() == ']' ? "." : "->";
-            std::string expr = parent_expr + op + prop->name_;
-            std::string argcount = pcount(prop, parent_expr + op);
-            std::string argsize = psize(prop, parent_expr + op);
-            std::string cond = parent_condition + " && " + expr;
-            out() << indent + "if (" + cond + ")"
-                  << indent + "    " + cmd + "(" + expr + ", " + argcount +
-                         ", " + argsize + ");";
-
-            UserType* ut = get_user_type_for_deep_copy(edl_, prop);
-            if (!ut)
-                return;
-
-            std::string count =
-                count_attr_str(prop->attrs_->count_, parent_expr + op);
-
-            if (count == "1" || count == "")
-            {
-                serialize_pointers_deep_copy(
-                    cond, expr, cmd, prop, level + 1, indent);
-            }
-            else
-            {
-                std::string idx = "_i_" + to_str(level);
-                std::string expr =
-                    parent_expr + op + prop->name_ + "[" + idx + "]";
-                out() << indent + "for (size_t " + idx + " = 0; " + idx +
-                             " < " + count + "; " + idx + "++)"
-                      << indent + "{";
-                serialize_pointers_deep_copy(
-                    cond, expr, cmd, prop, level + 1, indent + "    ");
-                out() << indent + "}";
-            }
-        });
-    }
-
     void serialize_buffer_deep_copy_out(Function* f)
     {
-        std::string prefix = "_pargs_in->";
-        for (Decl* p : f->params_)
-        {
-            if (!p->attrs_)
-                continue;
-
-            /* Skip the nested pointers if the parameter is neither
-             * deep-copyable nor has the out-only attribute. */
-            UserType* ut = get_user_type_for_deep_copy(edl_, p);
-            if (!ut || !p->attrs_->out_ || p->attrs_->inout_)
-                continue;
-
-            std::string count = count_attr_str(p->attrs_->count_, prefix);
-            std::string cmd = "OE_WRITE_DEEPCOPY_OUT_PARAM";
-            std::string mt = mtype_str(p);
-
-            if (count == "1" || count == "")
-            {
-                std::string cond = prefix + p->name_;
-                std::string expr = prefix + p->name_;
-                serialize_pointers_deep_copy(cond, expr, cmd, p, 2, "    ");
-            }
-            else
-            {
-                std::string cond = prefix + p->name_;
-                std::string expr = prefix + p->name_ + "[_i_1]";
-                out() << "    for (size_t _i_1 = 0; _i_1 < " + count +
-                             "; _i_1++)"
-                      << "    {";
-                serialize_pointers_deep_copy(cond, expr, cmd, p, 2, "        ");
-                out() << "    }";
-            }
-        }
+        call_deep_copy_out_helper(
+            f,
+            "serialize_out",
+            {"_deepcopy_out_buffer", "&_deepcopy_out_buffer_offset"});
         out() << "";
     }
 
-    void free_pointers_deep_copy(
-        Decl* p,
-        std::string parent_lhs_expr,
-        std::string parent_rhs_expr,
-        const std::string& indent,
-        int level = 1)
-    {
-        std::string cmd = "free";
-        std::string lhs_expr = parent_lhs_expr + p->name_;
-        std::string rhs_expr = parent_rhs_expr + p->name_;
-        UserType* ut = get_user_type_for_deep_copy(edl_, p);
-        if (!ut)
-            return;
-
-        /*
-         * Deep copied structure. Unmarshal individual fields.
-         */
-        out() << indent + "if (" + lhs_expr + ")" << indent + "{";
-        {
-            std::string count = pcount(p, parent_rhs_expr);
-            std::string idx = "_i_" + to_str(level);
-
-            out() << indent + "    for (size_t " + idx + " = 0; " + idx +
-                         " < " + count + "; " + idx + "++)"
-                  << indent + "    {";
-
-            for (Decl* field : ut->fields_)
-            {
-                if (field->type_->tag_ != Ptr || !field->attrs_ ||
-                    field->attrs_->user_check_ ||
-                    field->attrs_->is_size_or_count_)
-                    continue;
-
-                std::string lhs_val =
-                    lhs_expr + "[" + idx + "]." + field->name_;
-                std::string rhs_val =
-                    rhs_expr + "[" + idx + "]." + field->name_;
-                std::string ptr_prefix = "_l_" + std::to_string(level) + "_";
-                UserType* field_ut = get_user_type_for_deep_copy(edl_, field);
-                if (field_ut)
-                {
-                    /* Free the nested pointers first. */
-                    free_pointers_deep_copy(
-                        field,
-                        lhs_expr + "[" + idx + "].",
-                        rhs_expr + "[" + idx + "].",
-                        indent + "        ",
-                        level + 1);
-                }
-                out() << indent + "        " + cmd + "(" + lhs_val + ");";
-            }
-            out() << indent + "    }";
-        }
-        out() << indent + "}";
-    }
-
-    void free_deep_copy_out(
-        Function* f,
-        std::string lhs_prefix,
-        std::string rhs_prefix,
-        const std::string& indent)
+    void free_deep_copy_out(Function* f)
     {
+        std::string prefix = "_pargs_in->";
         for (Decl* p : f->params_)
         {
             if (p->attrs_ && p->attrs_->out_ && !p->attrs_->inout_)
@@ -627,7 +1007,10 @@ class FEmitter
                 UserType* ut = get_user_type_for_deep_copy(edl_, p);
                 if (!ut)
                     continue;
-                free_pointers_deep_copy(p, lhs_prefix, rhs_prefix, indent, 1);
+                out() << "    if (" + prefix + p->name_ + ")"
+                      << "        " + deepcopy_helper_name("free", ut) + "(" +
+                             prefix + p->name_ + ", " + pcount(p, prefix) +
+                             ");";
             }
         }
     }
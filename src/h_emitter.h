@@ -6,10 +6,13 @@
 
 #include <fstream>
 #include "ast.h"
+#include "options.h"
+#include "utils.h"
 
 class HEmitter
 {
     Edl* edl_;
+    const Options& options_;
     bool gen_t_h_;
     std::ofstream file_;
     std::string indent_;
@@ -36,7 +39,8 @@ class HEmitter
     }
 
   public:
-    HEmitter(Edl* edl) : edl_(edl), gen_t_h_(false), file_(), indent_()
+    HEmitter(Edl* edl, const Options& options)
+        : edl_(edl), options_(options), gen_t_h_(false), file_(), indent_()
     {
     }
 
@@ -66,8 +70,10 @@ class HEmitter
         std::string inc = (gen_t_h_ ? "enclave" : "host");
         header(out(), guard);
         out() << ""
-              << "#include <openenclave/" + inc + ".h>"
-              << ""
+              << "#include <openenclave/" + inc + ".h>";
+        if (options_.stats_)
+            out() << "#include <openenclave/edger8r/common.h>";
+        out() << ""
               << "#include \"" + edl_->name_ + "_args.h\""
               << ""
               << "OE_EXTERNC_BEGIN"
@@ -82,6 +88,14 @@ class HEmitter
         trusted_prototypes(prefix);
         out() << "/**** OCALL prototypes. ****/";
         untrusted_prototypes();
+        if (!edl_->channels_.empty())
+            channel_prototypes();
+        // The counters of the calls this side makes.
+        if (options_.stats_)
+            out() << "/**** Call counters. ****/"
+                  << get_call_stats_prototype(edl_) + ";"
+                  << reset_call_stats_prototype(edl_) + ";"
+                  << "";
         out() << "OE_EXTERNC_END"
               << "";
         footer(out(), guard);
@@ -91,8 +105,24 @@ class HEmitter
     {
         // Prefix is generated, if specified, only in _u.h.
         for (Function* f : edl_->trusted_funcs_)
-            out() << prototype(f, true, gen_t_h_, prefix) + ";"
+        {
+            out() << prototype(
+                         f,
+                         true,
+                         gen_t_h_,
+                         prefix,
+                         has_deepcopy_out_arena(edl_, options_, f)) +
+                         ";"
                   << "";
+            if (gen_t_h_)
+                chunk_callback_decls(f);
+            if (!gen_t_h_)
+            {
+                free_out_prototype_decl(f, prefix);
+                batch_decls(f, prefix);
+                async_prototype_decl(f, prefix);
+            }
+        }
         if (edl_->trusted_funcs_.empty())
             out() << "";
     }
@@ -100,10 +130,103 @@ class HEmitter
     void untrusted_prototypes()
     {
         for (Function* f : edl_->untrusted_funcs_)
-            out() << prototype(f, false, gen_t_h_) + ";"
+        {
+            out() << prototype(
+                         f,
+                         false,
+                         gen_t_h_,
+                         "",
+                         has_deepcopy_out_arena(edl_, options_, f)) +
+                         ";"
                   << "";
+            if (gen_t_h_)
+                free_out_prototype_decl(f);
+        }
         if (edl_->untrusted_funcs_.empty())
             out() << "";
+        // Deferred OCALLs are delivered to the host when the buffer of the
+        // thread fills up, before a synchronous OCALL, or by
+        // <edl>_flush_deferred, which also releases the buffer.
+        if (gen_t_h_ && has_deferred(edl_))
+            out() << flush_deferred_prototype(edl_) + ";"
+                  << "";
+    }
+
+    // The host opens each channel on an enclave, then records stream through
+    // it without calls. Each side gets only the end of the channel that its
+    // direction gives it.
+    void channel_prototypes()
+    {
+        out() << "/**** Channels. ****/";
+        for (Channel* c : edl_->channels_)
+        {
+            if (!gen_t_h_)
+                out() << "typedef struct _" + c->name_ + "_channel " +
+                             c->name_ + "_channel_t;"
+                      << ""
+                      << channel_open_prototype(c) + ";"
+                      << ""
+                      << channel_close_prototype(c) + ";"
+                      << "";
+            if (channel_sends(c, !gen_t_h_))
+                out() << channel_send_prototype(c, !gen_t_h_) + ";"
+                      << "";
+            else
+                out() << channel_receive_prototype(c, !gen_t_h_) + ";"
+                      << "";
+        }
+    }
+
+    // The enclave implements a sink or source for each chunked parameter,
+    // and is told when a call begins streaming it and when a call aborts.
+    void chunk_callback_decls(Function* f)
+    {
+        for (Decl* p : f->params_)
+            if (is_chunked(p))
+                for (const char* suffix :
+                     {"_begin", p->attrs_->in_ ? "_sink" : "_source", "_abort"})
+                    out() << chunk_callback_prototype(f, p, suffix) + ";"
+                          << "";
+    }
+
+    // The caller releases deep-copied out parameters via <function>_free_out.
+    void free_out_prototype_decl(Function* f, const std::string& prefix = "")
+    {
+        if (has_deepcopy_out_arena(edl_, options_, f))
+            out() << free_out_prototype(f, prefix) + ";"
+                  << "";
+    }
+
+    // The caller completes <function>_async via oe_call_wait.
+    void async_prototype_decl(Function* f, const std::string& prefix = "")
+    {
+        if (f->async_)
+            out() << async_prototype(
+                         f, prefix, has_deepcopy_out_arena(edl_, options_, f)) +
+                         ";"
+                  << "";
+    }
+
+    // The host submits the calls of a batchable ECALL via <function>_batch.
+    void batch_decls(Function* f, const std::string& prefix = "")
+    {
+        if (!f->batchable_)
+            return;
+        std::string batch_args_t = prefix + f->name_ + "_batch_args_t";
+        out() << "typedef struct _" + batch_args_t << "{";
+        indent_ = "    ";
+        if (f->rtype_->tag_ != Void)
+            out() << atype_str(f->rtype_) + " oe_retval;";
+        for (Decl* p : f->params_)
+            out() << mdecl_str(p->name_, p->type_, p->dims_, p->attrs_) + ";";
+        /* C does not allow empty structs. */
+        if (f->rtype_->tag_ == Void && f->params_.empty())
+            out() << "uint8_t oe_unused;";
+        indent_ = "";
+        out() << "} " + batch_args_t + ";"
+              << ""
+              << batch_prototype(f, prefix, prefix) + ";"
+              << "";
     }
 };
 
@@ -0,0 +1,353 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ast.h"
+#include "options.h"
+#include "utils.h"
+
+/*
+ * The size and alignment of a type in the generated code on the LP64 targets
+ * that enclaves are built for. Foreign types and arrays whose dimensions are
+ * macros have no known layout.
+ */
+struct Layout
+{
+    uint64_t size_;
+    uint64_t align_;
+    bool known_;
+};
+
+inline uint64_t align_up(uint64_t offset, uint64_t align)
+{
+    return (offset + align - 1) / align * align;
+}
+
+inline Layout type_layout(const std::vector<UserType*>& types, Type* t);
+
+inline Layout decl_layout(
+    const std::vector<UserType*>& types,
+    Type* t,
+    Dims* dims)
+{
+    Layout l = type_layout(types, t);
+    if (!dims)
+        return l;
+    for (const std::string& dim : *dims)
+    {
+        if (dim.empty() ||
+            dim.find_first_not_of("0123456789") != std::string::npos)
+            return Layout{0, 1, false};
+        l.size_ *= std::stoull(dim);
+    }
+    return l;
+}
+
+inline Layout user_type_layout(
+    const std::vector<UserType*>& types,
+    UserType* ut)
+{
+    if (ut->tag_ == Enum)
+        return Layout{4, 4, true};
+
+    Layout l{0, 1, true};
+    for (Decl* field : ut->fields_)
+    {
+        Layout f = decl_layout(types, field->type_, field->dims_);
+        if (!f.known_)
+            return f;
+        l.align_ = std::max(l.align_, f.align_);
+        if (ut->tag_ == Union)
+            l.size_ = std::max(l.size_, f.size_);
+        else
+            l.size_ = align_up(l.size_, f.align_) + f.size_;
+    }
+    l.size_ = align_up(l.size_, l.align_);
+    return l;
+}
+
+inline Layout type_layout(const std::vector<UserType*>& types, Type* t)
+{
+    switch (t->tag_)
+    {
+    case Bool:
+    case Char:
+    case Int8:
+    case UInt8:
+        return Layout{1, 1, true};
+    case Short:
+    case Int16:
+    case UInt16:
+        return Layout{2, 2, true};
+    case Int:
+    case Int32:
+    case UInt32:
+    case Float:
+    case WChar:
+        return Layout{4, 4, true};
+    case Long:
+    case LLong:
+    case Double:
+    case Int64:
+    case UInt64:
+    case SizeT:
+    case Ptr:
+        return Layout{8, 8, true};
+    case LDouble:
+        return Layout{16, 16, true};
+    case Const:
+    case Unsigned:
+        return type_layout(types, t->t_);
+    case Enum:
+    case Struct:
+    case Union:
+    case Foreign:
+    {
+        UserType* ut = get_user_type(types, t->name_);
+        if (ut)
+            return user_type_layout(types, ut);
+        if (t->tag_ == Enum)
+            return Layout{4, 4, true};
+        return Layout{0, 1, false};
+    }
+    default:
+        return Layout{0, 1, false};
+    }
+}
+
+inline Layout type_layout(Edl* edl, Type* t)
+{
+    return type_layout(edl->types_, t);
+}
+
+inline Layout decl_layout(Edl* edl, Type* t, Dims* dims)
+{
+    return decl_layout(edl->types_, t, dims);
+}
+
+/* The largest pointee that --inline-params stores in a marshalling struct. */
+const uint64_t max_inline_param_size = 64;
+
+/* The fixed number of elements of a pointer, or 0 if it depends on a value. */
+inline uint64_t fixed_count(Decl* p)
+{
+    if (p->attrs_->count_.is_empty())
+        return 1;
+    std::string count = p->attrs_->count_;
+    if (count.empty() ||
+        count.find_first_not_of("0123456789") != std::string::npos)
+        return 0;
+    return std::stoull(count);
+}
+
+/* The layout of the elements of a pointer with a fixed count. */
+inline Layout pointee_layout(Edl* edl, Decl* p)
+{
+    Layout l = type_layout(edl, p->type_->t_);
+    l.size_ *= fixed_count(p);
+    return l;
+}
+
+/*
+ * With --inline-params, the pointee of a plain in, out or in-out pointer with
+ * a fixed size is stored in the <param>_inline field of the marshalling
+ * struct. The pointer itself is still passed to tell null pointers apart.
+ */
+inline bool is_inline_param(Edl* edl, const Options& options, Decl* p)
+{
+    if (!options.inline_params_ || !p->attrs_ || p->dims_ ||
+        p->type_->tag_ != Ptr)
+        return false;
+    Attrs* attrs = p->attrs_;
+    if (!(attrs->in_ || attrs->out_ || attrs->inout_) || attrs->string_ ||
+        attrs->wstring_ || attrs->user_check_ || !attrs->size_.is_empty())
+        return false;
+    if (is_host_memory(p) || is_chunked(p) || is_variable_length(p) ||
+        !param_align_str(p).empty())
+        return false;
+    /* In-place in-out parameters keep their place in the output buffer. */
+    if (options.in_place_in_out_ && attrs->inout_)
+        return false;
+    if (get_user_type_for_deep_copy(edl, p))
+        return false;
+    Layout l = pointee_layout(edl, p);
+    return l.known_ && l.size_ && l.size_ <= max_inline_param_size;
+}
+
+/* The declaration of the inline storage of a parameter. */
+inline std::string inline_param_decl(Decl* p)
+{
+    Type* t = p->type_->t_;
+    return atype_str(t->tag_ == Const ? t->t_ : t) + " " + p->name_ +
+           "_inline[" + to_str(fixed_count(p)) + "]";
+}
+
+/*
+ * With --compact-layout, the sub-buffer of a parameter is aligned to its
+ * elements and its size is not rounded. Deep-copied parameters and elements
+ * of unknown layout are aligned to 16 bytes, and their nested buffers keep
+ * the default layout.
+ */
+inline bool is_compact_param(Edl* edl, const Options& options, Decl* p)
+{
+    return options.compact_layout_ && !get_user_type_for_deep_copy(edl, p);
+}
+
+inline uint64_t compact_align(Edl* edl, Decl* p)
+{
+    Layout l{0, 1, false};
+    if (get_user_type_for_deep_copy(edl, p))
+        return 16;
+    if (p->dims_)
+        l = type_layout(edl, p->type_);
+    else if (p->type_->tag_ == Ptr)
+        l = type_layout(edl, p->type_->t_);
+    return l.known_ ? l.align_ : 16;
+}
+
+/* The statement that pads an offset before the sub-buffer of a parameter. */
+inline std::string align_offset_str(
+    Edl* edl,
+    const Options& options,
+    Decl* p,
+    const std::string& offset)
+{
+    std::string align = param_align_str(p);
+    if (!options.compact_layout_)
+        return align.empty() ? ""
+                             : "OE_ALIGN_SIZE(" + offset + ", " + align + ");";
+    uint64_t compact = compact_align(edl, p);
+    if (!align.empty())
+        compact = std::max(compact, (uint64_t)std::stoull(align));
+    if (compact == 1)
+        return "";
+    return "OE_ALIGN_SIZE_COMPACT(" + offset + ", " + to_str(compact) + ");";
+}
+
+/* The variant of a marshalling macro for the layout of a parameter. */
+inline std::string layout_macro(
+    Edl* edl,
+    const Options& options,
+    Decl* p,
+    const std::string& macro)
+{
+    return is_compact_param(edl, options, p) ? macro + "_COMPACT" : macro;
+}
+
+/* A field of a <function>_args_t marshalling struct. */
+struct ArgsField
+{
+    std::string decl_;
+    Layout layout_;
+};
+
+/*
+ * The fields that follow the oe_result, deepcopy_out_buffer and
+ * deepcopy_out_buffer_size header, in the order of the parameters.
+ */
+inline std::vector<ArgsField> args_fields(
+    Edl* edl,
+    Function* f,
+    const Options& options)
+{
+    std::vector<ArgsField> fields;
+    Layout pointer{8, 8, true};
+    if (f->rtype_->tag_ != Void)
+        fields.push_back({atype_str(f->rtype_) + " oe_retval",
+                          type_layout(edl, f->rtype_)});
+    for (Decl* p : f->params_)
+    {
+        /* Arrays, foreign arrays and foreign pointers are passed as
+         * pointers. */
+        Layout l = pointer;
+        if (!p->dims_ &&
+            !(p->type_->tag_ == Foreign && p->attrs_ &&
+              (p->attrs_->isary_ || p->attrs_->isptr_)))
+            l = type_layout(edl, p->type_);
+        fields.push_back(
+            {mdecl_str(p->name_, p->type_, p->dims_, p->attrs_), l});
+        if (p->attrs_ && (p->attrs_->string_ || p->attrs_->wstring_))
+            fields.push_back({"size_t " + p->name_ + "_len", pointer});
+        if (is_inline_param(edl, options, p))
+            fields.push_back({inline_param_decl(p), pointee_layout(edl, p)});
+    }
+    if (f->errno_)
+        fields.push_back({"int ocall_errno", Layout{4, 4, true}});
+    return fields;
+}
+
+/*
+ * The fields of a marshalling struct, split around the deepcopy_out_buffer
+ * and deepcopy_out_buffer_size fields. The fields in the hole after the
+ * 4-byte oe_result come before them.
+ */
+struct ArgsLayout
+{
+    std::vector<ArgsField> hole_;
+    std::vector<ArgsField> body_;
+    bool known_;
+};
+
+/* The size of the struct with the given fields after the header. */
+inline uint64_t args_size(const ArgsLayout& layout)
+{
+    uint64_t offset = 4;
+    uint64_t align = 8;
+    for (const ArgsField& field : layout.hole_)
+        offset = align_up(offset, field.layout_.align_) + field.layout_.size_;
+    offset = align_up(offset, 8) + 16;
+    for (const ArgsField& field : layout.body_)
+    {
+        offset = align_up(offset, field.layout_.align_) + field.layout_.size_;
+        align = std::max(align, field.layout_.align_);
+    }
+    return align_up(offset, align);
+}
+
+/*
+ * The layout of the marshalling struct of a function. With --reorder-args, the
+ * hole after oe_result is filled first and the other fields follow by
+ * decreasing alignment, which leaves padding only at the end. The order
+ * only depends on the EDL, so both sides agree on it. The fields of a
+ * function with a field of unknown layout keep the parameter order.
+ */
+inline ArgsLayout args_layout(Edl* edl, Function* f, const Options& options)
+{
+    ArgsLayout layout{{}, args_fields(edl, f, options), true};
+    for (const ArgsField& field : layout.body_)
+        layout.known_ = layout.known_ && field.layout_.known_;
+    if (!options.reorder_args_ || !layout.known_)
+        return layout;
+
+    std::vector<ArgsField> fields = layout.body_;
+    std::stable_sort(
+        fields.begin(),
+        fields.end(),
+        [](const ArgsField& a, const ArgsField& b) {
+            return a.layout_.align_ > b.layout_.align_;
+        });
+    layout.body_.clear();
+    uint64_t offset = 4;
+    for (const ArgsField& field : fields)
+    {
+        uint64_t end =
+            align_up(offset, field.layout_.align_) + field.layout_.size_;
+        if (end <= 8)
+        {
+            layout.hole_.push_back(field);
+            offset = end;
+        }
+        else
+            layout.body_.push_back(field);
+    }
+    return layout;
+}
+
+#endif // LAYOUT_H
@@ -8,7 +8,10 @@
 #include "args_h_emitter.h"
 #include "c_emitter.h"
 #include "h_emitter.h"
+#include "layout.h"
+#include "options.h"
 #include "parser.h"
+#include "report_emitter.h"
 
 #ifdef __linux__
 #include <filesystem>
@@ -26,6 +29,16 @@ static Warning parse_warning_option(std::string& warning)
         return Warning::ForeignTypePtr;
     else if (warning == "non-portable-type")
         return Warning::NonPortableType;
+    else if (warning == "perf-deep-copy-depth")
+        return Warning::PerfDeepCopyDepth;
+    else if (warning == "perf-in-out")
+        return Warning::PerfInOut;
+    else if (warning == "perf-large-by-value")
+        return Warning::PerfLargeByValue;
+    else if (warning == "perf-small-ptr-params")
+        return Warning::PerfSmallPtrParams;
+    else if (warning == "perf-unbounded-string")
+        return Warning::PerfUnboundedString;
     else if (warning == "ptr-in-struct")
         return Warning::PtrInStruct;
     else if (warning == "ptr-in-function")
@@ -83,6 +96,37 @@ static void _ensure_directory(const std::string& dir)
 #endif
 }
 
+/* Print the bytes that --reorder-args saves in each marshalling struct. */
+static void _report_reordered_args(Edl* edl, const Options& options)
+{
+    Options in_order = options;
+    in_order.reorder_args_ = false;
+    uint64_t saved = 0;
+    for (auto funcs : {&edl->trusted_funcs_, &edl->untrusted_funcs_})
+    {
+        for (Function* f : *funcs)
+        {
+            ArgsLayout layout = args_layout(edl, f, in_order);
+            if (!layout.known_)
+                continue;
+            uint64_t size = args_size(layout);
+            uint64_t reordered = args_size(args_layout(edl, f, options));
+            if (reordered >= size)
+                continue;
+            printf(
+                "Reordered `%s_args_t': %llu bytes instead of %llu.\n",
+                f->name_.c_str(),
+                (unsigned long long)reordered,
+                (unsigned long long)size);
+            saved += size - reordered;
+        }
+    }
+    printf(
+        "Reordering the marshalling structs of `%s' saves %llu bytes.\n",
+        edl->name_.c_str(),
+        (unsigned long long)saved);
+}
+
 const char* usage =
     "usage: oeedger8r [options] <file> ...\n"
     "\n"
@@ -110,10 +154,50 @@ const char* usage =
     "-Wptr-in-struct        Warn if a struct includes a pointer type as a "
     "member\n"
     "-Wreturn-ptr           Warn if a function returns a pointer type\n"
+    "-Wperf-large-by-value  Warn if a value of more than 64 bytes is passed or "
+    "returned\n"
+    "                       by value\n"
+    "-Wperf-in-out          Warn if an in-out pointer points to const data\n"
+    "-Wperf-deep-copy-depth Warn if a deep copy nests more than 2 levels of "
+    "buffers\n"
+    "-Wperf-unbounded-string\n"
+    "                       Warn if a switchless, batchable or deferred "
+    "function\n"
+    "                       takes a string\n"
+    "-Wperf-small-ptr-params\n"
+    "                       Warn if a function takes more than 3 pointers to "
+    "values\n"
+    "                       of at most 16 bytes\n"
     "-Wno-<warning>         Disable the specified warning\n"
-    "-Wall                  Enable all the available warnings\n"
+    "-Wall                  Enable all the available warnings except "
+    "-Wperf-*\n"
     "-Werror                Turn warnings into errors\n"
     "-Werror=<warning>      Turn the specified warning into an error\n"
+    "--in-place-in-out      Marshal in-out parameters of OCALLs in a single "
+    "region\n"
+    "                       of the output buffer\n"
+    "--deepcopy-out-arena   Keep the nested pointers of deep-copied out "
+    "parameters\n"
+    "                       in one block freed by <function>_free_out\n"
+    "--deepcopy-offsets     Check and convert the nested pointers of "
+    "deep-copied\n"
+    "                       in parameters from their offsets with per-type "
+    "tables\n"
+    "--instrument           Call the oe_edger8r_trace_* hooks from the "
+    "wrappers\n"
+    "                       and forwarders\n"
+    "--stats                Count the calls of each function in the wrappers\n"
+    "--reorder-args         Order the fields of the marshalling structs to "
+    "minimize\n"
+    "                       padding\n"
+    "--inline-params        Store small fixed-size pointer parameters in the\n"
+    "                       marshalling structs\n"
+    "--compact-layout       Align the parameters in the marshalling buffers "
+    "only to\n"
+    "                       their elements\n"
+    "--layout-report <file> Write the marshalling layout and cost of every "
+    "function\n"
+    "                       to a JSON file\n"
     "--experimental         Enable experimental features\n"
     "--help                 Print this help message\n"
     "\n"
@@ -127,8 +211,10 @@ int main(int argc, char** argv)
     bool gen_untrusted = false;
     bool gen_trusted = false;
     bool experimental = false;
+    Options options;
     std::string untrusted_dir = ".";
     std::string trusted_dir = ".";
+    std::string layout_report;
     std::vector<std::string> files;
     std::vector<std::string> defines;
     std::unordered_map<Warning, WarningState, WarningHash> warnings;
@@ -153,6 +239,17 @@ int main(int argc, char** argv)
         return fix_path_separators(argv[i]);
     };
 
+    auto get_file = [argc, argv](int i) {
+        if (i == argc)
+        {
+            fprintf(
+                stderr, "error: missing file name after %s\n", argv[i - 1]);
+            fprintf(stderr, "%s\n", usage);
+            exit(1);
+        }
+        return fix_path_separators(argv[i]);
+    };
+
     /* Initialize the warning options. */
     set_default_warning_options(warnings);
 
@@ -175,6 +272,24 @@ int main(int argc, char** argv)
             untrusted_dir = get_dir(i++);
         else if (a == "--experimental")
             experimental = true;
+        else if (a == "--in-place-in-out")
+            options.in_place_in_out_ = true;
+        else if (a == "--deepcopy-out-arena")
+            options.deepcopy_out_arena_ = true;
+        else if (a == "--deepcopy-offsets")
+            options.deepcopy_offsets_ = true;
+        else if (a == "--instrument")
+            options.instrument_ = true;
+        else if (a == "--stats")
+            options.stats_ = true;
+        else if (a == "--reorder-args")
+            options.reorder_args_ = true;
+        else if (a == "--inline-params")
+            options.inline_params_ = true;
+        else if (a == "--compact-layout")
+            options.compact_layout_ = true;
+        else if (a == "--layout-report")
+            layout_report = get_file(i++);
         else if (a.rfind("-D", 0) == 0)
         {
             std::string define = a.substr(2);
@@ -272,27 +387,34 @@ int main(int argc, char** argv)
     if (untrusted_dir != std::string(".") + sep)
         _ensure_directory(untrusted_dir);
 
+    std::vector<Edl*> edls;
     for (std::string& file : files)
     {
         Parser p(file, searchpaths, defines, warnings, experimental);
         Edl* edl = p.parse();
+        edls.push_back(edl);
+        if (options.reorder_args_)
+            _report_reordered_args(edl, options);
 
         if (gen_trusted)
         {
             ArgsHEmitter(edl).emit(trusted_dir);
-            HEmitter(edl).emit_t_h(trusted_dir);
+            HEmitter(edl, options).emit_t_h(trusted_dir);
             if (!header_only)
-                CEmitter(edl).emit_t_c(trusted_dir);
+                CEmitter(edl, options).emit_t_c(trusted_dir);
         }
         if (gen_untrusted)
         {
             std::string prefix = use_prefix ? (edl->name_ + "_") : "";
             ArgsHEmitter(edl).emit(untrusted_dir);
-            HEmitter(edl).emit_u_h(untrusted_dir, prefix);
+            HEmitter(edl, options).emit_u_h(untrusted_dir, prefix);
             if (!header_only)
-                CEmitter(edl).emit_u_c(untrusted_dir, prefix);
+                CEmitter(edl, options).emit_u_c(untrusted_dir, prefix);
         }
     }
 
+    if (!layout_report.empty())
+        ReportEmitter(edls, options).emit(layout_report);
+
     printf("Success.\n");
 }
@@ -0,0 +1,67 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+/*
+ * Code generation options that alter the layout of the marshalling buffers.
+ * Both the trusted and untrusted code must be generated with the same options
+ * since the wrappers on one side and the forwarders on the other side must
+ * agree on the layout.
+ */
+struct Options
+{
+    /* Place the in-out parameters of OCALLs only in the output buffer. */
+    bool in_place_in_out_ = false;
+
+    /*
+     * Carve the nested pointers of deep-copied out parameters from a single
+     * block that is released by the generated <function>_free_out helper.
+     * This only affects the caller side.
+     */
+    bool deepcopy_out_arena_ = false;
+
+    /*
+     * Convert the nested pointers of deep-copied in and in-out parameters,
+     * which the sender always stores as offsets into the input buffer, by
+     * one table-driven pass that checks each offset against the buffer
+     * instead of by the per-type fixup helpers. This only affects the
+     * receiving side.
+     */
+    bool deepcopy_offsets_ = false;
+
+    /*
+     * Call the oe_edger8r_trace_* hooks from the wrappers and forwarders.
+     * This does not change the layout, so the two sides may differ.
+     */
+    bool instrument_ = false;
+
+    /*
+     * Count the calls, failures, bytes and latencies of each function in the
+     * wrappers, and emit <edl>_get_call_stats and <edl>_reset_call_stats.
+     * This only affects the caller side.
+     */
+    bool stats_ = false;
+
+    /*
+     * Order the fields of the <function>_args_t marshalling structs by
+     * decreasing alignment instead of by parameter, to minimize padding.
+     */
+    bool reorder_args_ = false;
+
+    /*
+     * Store the pointees of in, out and in-out pointers with a fixed size of
+     * at most 64 bytes in the marshalling structs instead of in their own
+     * sub-buffers of the input and output buffers.
+     */
+    bool inline_params_ = false;
+
+    /*
+     * Align the sub-buffer of each parameter only to its elements instead of
+     * rounding every sub-buffer to OE_EDGER8R_BUFFER_ALIGNMENT.
+     */
+    bool compact_layout_ = false;
+};
+
+#endif // OPTIONS_H
@@ -6,6 +6,7 @@
 #include <cstddef>
 #include <map>
 
+#include "layout.h"
 #include "parser.h"
 #include "preprocessor.h"
 #include "utils.h"
@@ -285,6 +286,10 @@ Edl* Parser::parse_body()
             parse_struct_or_union(t == "struct");
         else if (t == "from")
             parse_from_import();
+        else if (t == '[')
+            parse_channel();
+        else if (t == "channel")
+            ERROR("expecting `[in]' or `[out]' before `channel'");
         else
         {
             ERROR("unexpected token %s\n", static_cast<std::string>(t).c_str());
@@ -296,9 +301,14 @@ Edl* Parser::parse_body()
 
     append(trusted_funcs_, imported_trusted_funcs_);
     append(untrusted_funcs_, imported_untrusted_funcs_);
-
-    return new Edl{
-        basename_, includes_, types_, trusted_funcs_, untrusted_funcs_};
+    check_generated_names();
+
+    return new Edl{basename_,
+                   includes_,
+                   types_,
+                   trusted_funcs_,
+                   untrusted_funcs_,
+                   channels_};
 }
 
 void Parser::parse_include()
@@ -572,6 +582,138 @@ void Parser::parse_untrusted()
     expect(";");
 }
 
+/* Whether records of the type would carry pointers across the channel. */
+static bool has_pointers(const std::vector<UserType*>& types, Type* t)
+{
+    if (t->tag_ == Ptr)
+        return true;
+    if (t->tag_ == Const)
+        return has_pointers(types, t->t_);
+    if (t->tag_ != Struct && t->tag_ != Union && t->tag_ != Foreign)
+        return false;
+
+    UserType* ut = get_user_type(types, t->name_);
+    if (!ut)
+        return false;
+    for (Decl* field : ut->fields_)
+        if (has_pointers(types, field->type_))
+            return true;
+    return false;
+}
+
+/*
+ * The calls and functions generated for batchable and deferred functions,
+ * chunked parameters and channels are named after them, so their names must
+ * not be taken by a user function or by another generated name.
+ */
+void Parser::check_generated_names()
+{
+    std::map<std::string, std::string> names;
+    auto add = [&names](const std::string& name, const std::string& what) {
+        auto it = names.find(name);
+        if (it != names.end())
+        {
+            fprintf(
+                stderr,
+                "error: `%s' is both %s and %s.\n",
+                name.c_str(),
+                it->second.c_str(),
+                what.c_str());
+            exit(1);
+        }
+        names[name] = what;
+    };
+
+    for (Function* f : trusted_funcs_)
+        add(f->name_, "function `" + f->name_ + "'");
+    for (Function* f : untrusted_funcs_)
+        add(f->name_, "function `" + f->name_ + "'");
+
+    for (Function* f : trusted_funcs_)
+    {
+        if (f->batchable_)
+            add(f->name_ + "_batch",
+                "the batch ECALL of function `" + f->name_ + "'");
+        for (Decl* p : f->params_)
+        {
+            if (!is_chunked(p))
+                continue;
+            std::string what = "parameter `" + p->name_ + "' of function `" +
+                               f->name_ + "'";
+            add(f->name_ + "_" + p->name_ + "_chunk",
+                "the chunk ECALL of " + what);
+            for (const char* suffix :
+                 {"_begin", p->attrs_->in_ ? "_sink" : "_source", "_abort"})
+                add(f->name_ + "_" + p->name_ + suffix,
+                    "a chunk callback of " + what);
+        }
+    }
+    for (Function* f : untrusted_funcs_)
+        if (f->deferred_)
+        {
+            add("oe_deferred_batch", "the OCALL of the deferred functions");
+            break;
+        }
+    for (Channel* c : channels_)
+    {
+        std::string what = " of channel `" + c->name_ + "'";
+        add("oe_channel_" + c->name_, "the ECALL" + what);
+        for (const char* suffix : {"_open", "_close", "_send", "_receive"})
+            add(c->name_ + suffix, "a function" + what);
+    }
+}
+
+void Parser::parse_channel()
+{
+    // [in|out] channel<type, size [KB|MB|GB]> name;
+    Token direction = next();
+    if (direction != "in" && direction != "out")
+        ERROR(
+            "expecting channel direction `in' or `out', got %s",
+            static_cast<std::string>(direction).c_str());
+    expect("]");
+    expect("channel");
+    expect("<");
+    Type* type = parse_atype();
+    expect(",");
+    Token size = next();
+    if (!size.is_int())
+        ERROR(
+            "expecting channel size, got %s",
+            static_cast<std::string>(size).c_str());
+    uint64_t bytes = std::stoull(static_cast<std::string>(size));
+    if (peek() == "KB")
+        (next(), bytes <<= 10);
+    else if (peek() == "MB")
+        (next(), bytes <<= 20);
+    else if (peek() == "GB")
+        (next(), bytes <<= 30);
+    expect(">");
+    Token name = next();
+    if (!name.is_name())
+        ERROR(
+            "expecting channel name, got %s",
+            static_cast<std::string>(name).c_str());
+    expect(";");
+
+    if (type->tag_ == Void || type->tag_ == Const ||
+        has_pointers(types_, type))
+        ERROR(
+            "channel `%s': the records must be of a non-const type without "
+            "pointers",
+            static_cast<std::string>(name).c_str());
+    if (bytes == 0)
+        ERROR(
+            "channel `%s': the size must not be zero",
+            static_cast<std::string>(name).c_str());
+    if (lookup(channels_, name))
+        ERROR(
+            "Duplicate channel definition detected for %s",
+            static_cast<std::string>(name).c_str());
+
+    channels_.push_back(new Channel{name, type, bytes, direction == "in"});
+}
+
 void Parser::parse_allow_list(bool trusted, const std::string& fname)
 {
     if (peek() == "allow")
@@ -602,7 +744,7 @@ void Parser::parse_allow_list(bool trusted, const std::string& fname)
 Function* Parser::parse_function_decl(bool trusted)
 {
     in_function_ = true;
-    Function* f = new Function{{}, {}, {}, false, false};
+    Function* f = new Function{{}, {}, {}, false, false, false, false, false};
     f->rtype_ = parse_atype();
     Token name = next();
     if (!name.is_name())
@@ -620,18 +762,22 @@ Function* Parser::parse_function_decl(bool trusted)
     if (peek() == "void" && peek1() == ")")
         next();
 
+    /* The names locate the -Wperf-* warnings. */
+    std::vector<Token> param_names;
     while (peek() != ')')
     {
-        Decl* decl = parse_decl();
+        Token param_name;
+        Decl* decl = parse_decl(&param_name);
         check_function_param(f->name_, decl);
         f->params_.push_back(decl);
+        param_names.push_back(param_name);
         if (peek() != ')')
             expect(",");
     }
     expect(")");
     parse_allow_list(trusted, f->name_);
 
-    for (int i = 0; i < 2; ++i)
+    for (int i = 0; i < 5; ++i)
     {
         if (peek() == "transition_using_threads" && !f->switchless_)
         {
@@ -643,6 +789,21 @@ Function* Parser::parse_function_decl(bool trusted)
             next();
             f->errno_ = true;
         }
+        else if (trusted && peek() == "batchable" && !f->batchable_)
+        {
+            next();
+            f->batchable_ = true;
+        }
+        else if (!trusted && peek() == "deferred" && !f->deferred_)
+        {
+            next();
+            f->deferred_ = true;
+        }
+        else if (peek() == "async" && !f->async_)
+        {
+            next();
+            f->async_ = true;
+        }
     }
     expect(";");
 
@@ -650,11 +811,19 @@ Function* Parser::parse_function_decl(bool trusted)
     error_size_count(f);
     check_size_count_decls(f->name_, f->params_);
     check_deep_copy_struct_by_value(f);
+    check_batchable(f);
+    check_deferred(f);
+    check_async(f, trusted);
+    check_host_memory(f, trusted);
+    check_chunked(f, trusted);
+    check_length(f);
+    check_align(f);
+    check_perf(f, &name, param_names);
     in_function_ = false;
     return f;
 }
 
-Decl* Parser::parse_decl()
+Decl* Parser::parse_decl(Token* name_token)
 {
     Decl* decl = new Decl{{}, {}, {}, nullptr};
     decl->attrs_ = parse_attributes();
@@ -665,6 +834,8 @@ Decl* Parser::parse_decl()
             "expecting identifier got %s",
             static_cast<std::string>(name).c_str());
     decl->name_ = name;
+    if (name_token)
+        *name_token = name;
     decl->dims_ = parse_dims();
     validate_attributes(decl);
     return decl;
@@ -690,6 +861,14 @@ Parser::AttrTok Parser::check_attribute(Token t)
         return TokWstring;
     if (t == "user_check")
         return TokUserCheck;
+    if (t == "host_memory")
+        return TokHostMemory;
+    if (t == "chunked")
+        return TokChunked;
+    if (t == "length")
+        return TokLength;
+    if (t == "align")
+        return TokAlign;
     if (t == "sizefunc")
         ERROR("The attribute 'sizefunc' is deprecated. Please use 'size' "
               "attribute instead.");
@@ -714,6 +893,10 @@ Attrs* Parser::parse_attributes()
         false,
         false,
         false,
+        false,
+        Token::empty(),
+        Token::empty(),
+        Token::empty(),
         Token::empty(),
         Token::empty()};
     attr_toks_.clear();
@@ -749,8 +932,36 @@ Attrs* Parser::parse_attributes()
             else
                 attrs->size_ = v;
         }
+        else if (atok == TokChunked)
+        {
+            expect("=");
+            Token v = next();
+            if (!v.is_int() || std::stoull(static_cast<std::string>(v)) == 0)
+                ERROR("expecting a positive chunk size");
+            attrs->chunked_ = v;
+        }
+        else if (atok == TokLength)
+        {
+            expect("=");
+            Token v = next();
+            if (!v.is_name())
+                ERROR("expecting a parameter name");
+            attrs->length_ = v;
+        }
+        else if (atok == TokAlign)
+        {
+            expect("=");
+            Token v = next();
+            uint64_t align =
+                v.is_int() ? std::stoull(static_cast<std::string>(v)) : 0;
+            if (!align || (align & (align - 1)) || align > 4096)
+                ERROR("expecting a power of two no larger than 4096");
+            attrs->align_ = v;
+        }
         else if (atok == TokUserCheck)
             attrs->user_check_ = true;
+        else if (atok == TokHostMemory)
+            attrs->host_memory_ = true;
         else if (atok == TokIn)
             *(attrs->out_ ? &attrs->inout_ : &attrs->in_) = true;
         else if (atok == TokOut)
@@ -931,9 +1142,10 @@ void Parser::warn_or_err(Warning option, Token* token, const char* format, ...)
         return;
 
     /* warnings_[Warning::All] == WarningState::Warning represents the -Wall
-     * option. */
+     * option, which leaves out the opt-in -Wperf-* warnings. */
     if (state != WarningState::Unknown ||
-        warnings_[Warning::All] == WarningState::Warning)
+        (warnings_[Warning::All] == WarningState::Warning &&
+         !is_perf_warning(option)))
     {
         /* Arguments forwarding. */
         const size_t MESSAGE_SIZE = 256;
@@ -1197,6 +1409,10 @@ void Parser::check_size_count_decls(
                         false,
                         false,
                         false,
+                        false,
+                        Token::empty(),
+                        Token::empty(),
+                        Token::empty(),
                         Token::empty(),
                         Token::empty()};
                 /*
@@ -1483,3 +1699,407 @@ void Parser::validate_attributes(Decl* d)
         }
     }
 }
+
+void Parser::check_batchable(Function* f)
+{
+    if (!f->batchable_)
+        return;
+
+    /* The calls of a batch are marshalled as an array of argument sets, so
+     * only parameters that are copied by value are supported. */
+    for (Decl* p : f->params_)
+    {
+        Attrs* attrs = p->attrs_;
+        if (p->dims_ ||
+            (attrs && (attrs->in_ || attrs->out_ || attrs->isary_)))
+        {
+            fprintf(
+                stderr,
+                "error: Function `%s': `batchable' requires all parameters "
+                "to be passed by value, `%s' is marshalled.\n",
+                f->name_.c_str(),
+                p->name_.c_str());
+            exit(1);
+        }
+    }
+}
+
+void Parser::check_deferred(Function* f)
+{
+    if (!f->deferred_)
+        return;
+
+    /* The enclave does not wait for a deferred call, so nothing can be
+     * passed back to it. */
+    if (f->rtype_->tag_ != Void || f->errno_)
+    {
+        fprintf(
+            stderr,
+            "error: Function `%s': `deferred' requires the void return type "
+            "and cannot be used with `propagate_errno'.\n",
+            f->name_.c_str());
+        exit(1);
+    }
+    for (Decl* p : f->params_)
+    {
+        /* [in, out] sets inout_ but not out_. */
+        if (p->attrs_ && (p->attrs_->out_ || p->attrs_->inout_))
+        {
+            fprintf(
+                stderr,
+                "error: Function `%s': `deferred' does not support the %s "
+                "parameter `%s'.\n",
+                f->name_.c_str(),
+                p->attrs_->inout_ ? "in-out" : "out",
+                p->name_.c_str());
+            exit(1);
+        }
+    }
+}
+
+void Parser::check_host_memory(Function* f, bool trusted)
+{
+    for (Decl* p : f->params_)
+    {
+        Attrs* attrs = p->attrs_;
+        if (!attrs || !attrs->host_memory_)
+            continue;
+
+        /* The pointer is passed to the host as is, so it must be a buffer
+         * of plain data that the enclave hands to an OCALL. */
+        const char* error = nullptr;
+        if (trusted)
+            error = "is only valid for the parameters of untrusted functions";
+        else if (!attrs->in_ && !attrs->out_ && !attrs->inout_)
+            error = "requires a pointer direction";
+        else if (attrs->string_ || attrs->wstring_ || p->dims_)
+            error = "cannot be used with strings or arrays";
+        else if (get_user_type_for_deep_copy(types_, p))
+            error = "cannot be used with deep-copied structs";
+        else if (f->deferred_)
+            error = "cannot be used with `deferred' since the buffer may "
+                    "change before the call is delivered";
+        if (error)
+        {
+            fprintf(
+                stderr,
+                "error: Function `%s': `host_memory' %s, parameter `%s'.\n",
+                f->name_.c_str(),
+                error,
+                p->name_.c_str());
+            exit(1);
+        }
+    }
+}
+
+void Parser::check_chunked(Function* f, bool trusted)
+{
+    for (Decl* p : f->params_)
+    {
+        Attrs* attrs = p->attrs_;
+        if (!attrs || attrs->chunked_.is_empty())
+            continue;
+
+        /* The buffer is streamed into the enclave or out of it one chunk
+         * per ECALL, so its size must be known before the call. */
+        const char* error = nullptr;
+        if (!trusted)
+            error = "is only valid for the parameters of trusted functions";
+        else if (attrs->inout_ || (!attrs->in_ && !attrs->out_))
+            error = "requires either the `in' or the `out' direction";
+        else if (p->type_->tag_ != Ptr || p->dims_ ||
+                 (attrs->size_.is_empty() && attrs->count_.is_empty()))
+            error = "requires a pointer with a `size' or `count'";
+        else if (get_user_type_for_deep_copy(types_, p))
+            error = "cannot be used with deep-copied structs";
+        else if (attrs->host_memory_ || attrs->user_check_)
+            error = "cannot be used with `host_memory' or `user_check'";
+        if (error)
+        {
+            fprintf(
+                stderr,
+                "error: Function `%s': `chunked' %s, parameter `%s'.\n",
+                f->name_.c_str(),
+                error,
+                p->name_.c_str());
+            exit(1);
+        }
+    }
+}
+
+/* The integer types that a `length' parameter may point to. */
+static bool is_integer_type(Type* t)
+{
+    switch (t->tag_)
+    {
+    case Char:
+    case Short:
+    case Int:
+    case Long:
+    case LLong:
+    case Int8:
+    case Int16:
+    case Int32:
+    case Int64:
+    case UInt8:
+    case UInt16:
+    case UInt32:
+    case UInt64:
+    case SizeT:
+    case Unsigned:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void Parser::check_length(Function* f)
+{
+    for (Decl* p : f->params_)
+    {
+        Attrs* attrs = p->attrs_;
+        if (!attrs || attrs->length_.is_empty())
+            continue;
+
+        /* Only the first `length' elements of the buffer are copied back,
+         * so the callee reports the length through another out parameter.
+         */
+        Decl* length = nullptr;
+        for (Decl* q : f->params_)
+            if (q->name_ == static_cast<std::string>(attrs->length_))
+                length = q;
+
+        const char* error = nullptr;
+        if (!attrs->out_ || attrs->inout_)
+            error = "requires the `out' direction";
+        else if (p->type_->tag_ != Ptr || p->dims_ ||
+                 (attrs->size_.is_empty() && attrs->count_.is_empty()))
+            error = "requires a pointer with a `size' or `count'";
+        else if (get_user_type_for_deep_copy(types_, p))
+            error = "cannot be used with deep-copied structs";
+        else if (attrs->host_memory_ || !attrs->chunked_.is_empty())
+            error = "cannot be used with `host_memory' or `chunked'";
+        else if (
+            !length || length == p || length->type_->tag_ != Ptr ||
+            !is_integer_type(length->type_->t_) || !length->attrs_ ||
+            !(length->attrs_->out_ || length->attrs_->inout_) ||
+            !length->attrs_->size_.is_empty() ||
+            !length->attrs_->count_.is_empty() ||
+            !length->attrs_->length_.is_empty() ||
+            length->attrs_->host_memory_ ||
+            !length->attrs_->chunked_.is_empty())
+            error = "must name an `out' pointer to an integer";
+        if (error)
+        {
+            fprintf(
+                stderr,
+                "error: Function `%s': `length' %s, parameter `%s'.\n",
+                f->name_.c_str(),
+                error,
+                p->name_.c_str());
+            exit(1);
+        }
+    }
+}
+
+void Parser::check_align(Function* f)
+{
+    for (Decl* p : f->params_)
+    {
+        Attrs* attrs = p->attrs_;
+        if (!attrs || attrs->align_.is_empty())
+            continue;
+
+        /* The alignment applies to the sub-buffer that the pointer is
+         * marshalled to, so the pointer must be copied as a whole. */
+        const char* error = nullptr;
+        if (!attrs->in_ && !attrs->out_ && !attrs->inout_)
+            error = "requires a pointer direction";
+        else if (get_user_type_for_deep_copy(types_, p))
+            error = "cannot be used with deep-copied structs";
+        else if (attrs->host_memory_ || !attrs->chunked_.is_empty())
+            error = "cannot be used with `host_memory' or `chunked'";
+        if (error)
+        {
+            fprintf(
+                stderr,
+                "error: Function `%s': `align' %s, parameter `%s'.\n",
+                f->name_.c_str(),
+                error,
+                p->name_.c_str());
+            exit(1);
+        }
+    }
+}
+
+void Parser::check_async(Function* f, bool trusted)
+{
+    /* An asynchronous call completes on a worker thread, so the errno of
+     * the caller cannot be set and a deferred call has nothing to wait for.
+     */
+    if (f->async_ && (f->errno_ || f->deferred_))
+    {
+        fprintf(
+            stderr,
+            "error: Function `%s': `async' cannot be used with "
+            "`propagate_errno' or `deferred'.\n",
+            f->name_.c_str());
+        exit(1);
+    }
+
+    /* The worker threads run in the host. An enclave cannot create threads
+     * to complete an OCALL while the caller keeps running. */
+    if (f->async_ && !trusted)
+    {
+        fprintf(
+            stderr,
+            "error: Function `%s': `async' is only valid for trusted "
+            "functions (ECALLs).\n",
+            f->name_.c_str());
+        exit(1);
+    }
+}
+
+/* The thresholds of the -Wperf-* warnings. */
+static const uint64_t max_by_value_size = 64;
+static const uint64_t max_deep_copy_depth = 2;
+static const uint64_t max_small_pointee_size = 16;
+static const size_t max_small_ptr_params = 3;
+
+/*
+ * The number of levels of nested buffers that deep-copying a struct
+ * allocates, or 0 if the struct is recursive.
+ */
+static uint64_t deep_copy_depth(
+    const std::vector<UserType*>& types,
+    UserType* ut,
+    std::vector<UserType*>& path)
+{
+    if (in(ut, path))
+        return 0;
+    path.push_back(ut);
+    uint64_t depth = 1;
+    iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+        UserType* nested = get_user_type_for_deep_copy(types, prop);
+        if (!nested || !depth)
+            return;
+        uint64_t d = deep_copy_depth(types, nested, path);
+        depth = d ? std::max(depth, d + 1) : 0;
+    });
+    path.pop_back();
+    return depth;
+}
+
+void Parser::check_perf(
+    Function* f,
+    Token* name,
+    const std::vector<Token>& param_names)
+{
+    const char* fname = f->name_.c_str();
+    if (f->rtype_->tag_ != Void)
+    {
+        Layout l = type_layout(types_, f->rtype_);
+        if (l.known_ && l.size_ > max_by_value_size)
+            warn_or_err(
+                Warning::PerfLargeByValue,
+                name,
+                "Function `%s': the return value is copied by value (%u "
+                "bytes, more than %u). Consider returning it through an "
+                "`out' pointer [-Wperf-large-by-value].",
+                fname,
+                (unsigned)l.size_,
+                (unsigned)max_by_value_size);
+    }
+
+    /* Only switchless, batchable and deferred calls are known to be hot. */
+    bool hot = f->switchless_ || f->batchable_ || f->deferred_;
+    size_t small_ptr_params = 0;
+    for (size_t i = 0; i < f->params_.size(); i++)
+    {
+        Decl* p = f->params_[i];
+        Token token = param_names[i];
+        const char* pname = p->name_.c_str();
+        Attrs* attrs = p->attrs_;
+        if (p->type_->tag_ != Ptr && !p->dims_)
+        {
+            Layout l = type_layout(types_, p->type_);
+            if (l.known_ && l.size_ > max_by_value_size)
+                warn_or_err(
+                    Warning::PerfLargeByValue,
+                    &token,
+                    "Function `%s': `%s' is copied by value (%u bytes, more "
+                    "than %u). Consider passing it through an `in' pointer "
+                    "[-Wperf-large-by-value].",
+                    fname,
+                    pname,
+                    (unsigned)l.size_,
+                    (unsigned)max_by_value_size);
+            continue;
+        }
+        if (!attrs || p->type_->tag_ != Ptr)
+            continue;
+
+        /* The callee cannot change a const pointee, so copying it back is
+         * wasted. */
+        if (attrs->inout_ && p->type_->t_->tag_ == Const)
+            warn_or_err(
+                Warning::PerfInOut,
+                &token,
+                "Function `%s': `%s' points to const data but is copied in "
+                "and out. Consider using `in' [-Wperf-in-out].",
+                fname,
+                pname);
+
+        if (hot && (attrs->string_ || attrs->wstring_))
+            warn_or_err(
+                Warning::PerfUnboundedString,
+                &token,
+                "Function `%s': `%s' is a string measured on every call of a "
+                "switchless, batchable or deferred function. Consider a "
+                "buffer with a `count' [-Wperf-unbounded-string].",
+                fname,
+                pname);
+
+        UserType* ut = get_user_type_for_deep_copy(types_, p);
+        if (ut)
+        {
+            std::vector<UserType*> path;
+            uint64_t depth = deep_copy_depth(types_, ut, path);
+            if (!depth || depth > max_deep_copy_depth)
+                warn_or_err(
+                    Warning::PerfDeepCopyDepth,
+                    &token,
+                    "Function `%s': `%s' is deep-copied through %s levels of "
+                    "nested buffers, more than %u. Consider flattening `%s' "
+                    "[-Wperf-deep-copy-depth].",
+                    fname,
+                    pname,
+                    depth ? to_str(depth).c_str() : "unbounded",
+                    (unsigned)max_deep_copy_depth,
+                    ut->name_.c_str());
+            continue;
+        }
+
+        if ((attrs->in_ || attrs->out_ || attrs->inout_) && !attrs->string_ &&
+            !attrs->wstring_ && attrs->size_.is_empty() &&
+            attrs->chunked_.is_empty() && attrs->length_.is_empty())
+        {
+            Layout l = type_layout(types_, p->type_->t_);
+            uint64_t count = fixed_count(p);
+            if (l.known_ && count && l.size_ * count <= max_small_pointee_size)
+                small_ptr_params++;
+        }
+    }
+
+    if (small_ptr_params > max_small_ptr_params)
+        warn_or_err(
+            Warning::PerfSmallPtrParams,
+            name,
+            "Function `%s': %u pointer parameters to at most %u bytes, more "
+            "than %u, are copied into separate buffers. Consider merging "
+            "them into one struct [-Wperf-small-ptr-params].",
+            fname,
+            (unsigned)small_ptr_params,
+            (unsigned)max_small_pointee_size,
+            (unsigned)max_small_ptr_params);
+}
@@ -42,6 +42,7 @@ class Parser
     std::vector<Function*> untrusted_funcs_;
     std::vector<Function*> imported_trusted_funcs_;
     std::vector<Function*> imported_untrusted_funcs_;
+    std::vector<Channel*> channels_;
 
     Preprocessor pp_;
     enum AttrTok
@@ -54,7 +55,11 @@ class Parser
         TokIsPtr,
         TokString,
         TokWstring,
-        TokUserCheck
+        TokUserCheck,
+        TokHostMemory,
+        TokChunked,
+        TokLength,
+        TokAlign
     };
     std::vector<std::pair<AttrTok, Token>> attr_toks_;
 
@@ -78,8 +83,9 @@ class Parser
     void parse_struct_or_union(bool is_struct);
     void parse_trusted();
     void parse_untrusted();
+    void parse_channel();
     Attrs* parse_attributes();
-    Decl* parse_decl();
+    Decl* parse_decl(Token* name_token = nullptr);
     void parse_allow_list(bool trusted, const std::string& fname);
     Function* parse_function_decl(bool trusted = true);
     Type* parse_atype();
@@ -120,6 +126,18 @@ class Parser
     AttrTok check_attribute(Token t);
     void validate_attributes(Decl* d);
     void check_deep_copy_struct_by_value(Function* f);
+    void check_batchable(Function* f);
+    void check_deferred(Function* f);
+    void check_async(Function* f, bool trusted);
+    void check_host_memory(Function* f, bool trusted);
+    void check_chunked(Function* f, bool trusted);
+    void check_length(Function* f);
+    void check_align(Function* f);
+    void check_perf(
+        Function* f,
+        Token* name,
+        const std::vector<Token>& param_names);
+    void check_generated_names();
 
   private:
     void expect(const char* str);
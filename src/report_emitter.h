@@ -0,0 +1,526 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef REPORT_EMITTER_H
+#define REPORT_EMITTER_H
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <vector>
+
+#include "ast.h"
+#include "layout.h"
+#include "options.h"
+#include "utils.h"
+
+/*
+ * Emits the --layout-report file, a JSON description of how every function
+ * of the EDL files is marshalled and what it costs, for reviewing EDL
+ * changes. Sizes are those of the LP64 targets and null stands for a size
+ * that depends on foreign types or macros.
+ *
+ * Size formulas use the names of the parameters, and of the fields for the
+ * nested buffers of deep-copied structs. roundN(x) rounds x up to a multiple
+ * of N and nested(T) is the size of the nested buffers of one T. The worst
+ * case counts the full capacity of variable-length out parameters and the
+ * largest alignment padding. The copies per byte only count the copies of
+ * the generated code, not those of the runtime across the trust boundary.
+ */
+class ReportEmitter
+{
+    const std::vector<Edl*>& edls_;
+    const Options& options_;
+    std::ofstream file_;
+    std::vector<bool> first_;
+    Edl* edl_;
+    bool ecall_;
+
+    /* The size of a marshalling buffer as fixed bytes and dynamic terms. */
+    struct BufferSize
+    {
+        uint64_t fixed_;
+        std::vector<std::string> dynamic_;
+    };
+
+    /* The nesting of the pointers of a deep-copied struct. */
+    struct DeepCopy
+    {
+        uint64_t depth_;
+        uint64_t fan_out_;
+        bool recursive_;
+    };
+
+  public:
+    ReportEmitter(const std::vector<Edl*>& edls, const Options& options)
+        : edls_(edls),
+          options_(options),
+          file_(),
+          first_(),
+          edl_(nullptr),
+          ecall_(false)
+    {
+    }
+
+    void emit(const std::string& path)
+    {
+        file_.open(path.c_str(), std::ios::out | std::ios::binary);
+        file_ << "{";
+        first_.push_back(true);
+        open("layout", "{");
+        boolean("reorder_args", options_.reorder_args_);
+        boolean("inline_params", options_.inline_params_);
+        boolean("compact_layout", options_.compact_layout_);
+        boolean("in_place_in_out", options_.in_place_in_out_);
+        close("}");
+        open("edls", "[");
+        for (Edl* edl : edls_)
+        {
+            edl_ = edl;
+            open("", "{");
+            string("name", edl->name_);
+            open("functions", "[");
+            ecall_ = true;
+            for (Function* f : edl->trusted_funcs_)
+                function(f);
+            ecall_ = false;
+            for (Function* f : edl->untrusted_funcs_)
+                function(f);
+            close("]");
+            deep_copy_types();
+            close("}");
+        }
+        close("]");
+        close("}");
+        file_ << "\n";
+        file_.close();
+    }
+
+  private:
+    static std::string quote(const std::string& s)
+    {
+        std::string q = "\"";
+        for (char c : s)
+        {
+            if (c == '"' || c == '\\')
+                q += '\\';
+            q += c == '\n' ? ' ' : c;
+        }
+        return q + "\"";
+    }
+
+    /* Start a member of the current object or an element of an array. */
+    void item(const std::string& key)
+    {
+        file_ << (first_.back() ? "\n" : ",\n")
+              << std::string(2 * first_.size(), ' ');
+        first_.back() = false;
+        if (!key.empty())
+            file_ << quote(key) << ": ";
+    }
+
+    void open(const std::string& key, const char* bracket)
+    {
+        item(key);
+        file_ << bracket;
+        first_.push_back(true);
+    }
+
+    void close(const char* bracket)
+    {
+        bool empty = first_.back();
+        first_.pop_back();
+        if (!empty)
+            file_ << "\n" << std::string(2 * first_.size(), ' ');
+        file_ << bracket;
+    }
+
+    void value(const std::string& key, const std::string& json)
+    {
+        item(key);
+        file_ << json;
+    }
+
+    void string(const std::string& key, const std::string& s)
+    {
+        value(key, quote(s));
+    }
+
+    void number(const std::string& key, uint64_t n, bool known = true)
+    {
+        value(key, known ? to_str(n) : "null");
+    }
+
+    void boolean(const std::string& key, bool b)
+    {
+        value(key, b ? "true" : "false");
+    }
+
+    static bool is_number(const std::string& s)
+    {
+        return !s.empty() &&
+               s.find_first_not_of("0123456789") == std::string::npos;
+    }
+
+    static bool is_pointer(Decl* p)
+    {
+        return p->type_->tag_ == Ptr || p->dims_ ||
+               (p->attrs_ && (p->attrs_->isptr_ || p->attrs_->isary_));
+    }
+
+    static std::string direction(Decl* p)
+    {
+        Attrs* a = p->attrs_;
+        if (a && a->inout_)
+            return "in-out";
+        if (a && a->in_)
+            return "in";
+        if (a && a->out_)
+            return "out";
+        return is_pointer(p) ? "user_check" : "value";
+    }
+
+    static bool has_in(Decl* p)
+    {
+        return p->attrs_ && (p->attrs_->in_ || p->attrs_->inout_);
+    }
+
+    static bool has_out(Decl* p)
+    {
+        return p->attrs_ && (p->attrs_->out_ || p->attrs_->inout_);
+    }
+
+    /* Whether the pointee of a parameter is copied by the generated code. */
+    static bool marshalled(Decl* p)
+    {
+        return (has_in(p) || has_out(p)) && !is_host_memory(p);
+    }
+
+    bool in_place(Decl* p)
+    {
+        return is_in_place_in_out(edl_, options_, ecall_, p);
+    }
+
+    /* Where the pointee of a parameter travels. */
+    std::string location(Decl* p)
+    {
+        if (is_host_memory(p))
+            return "host_memory";
+        if (!marshalled(p))
+            return direction(p) == "value" ? "args" : "none";
+        if (is_inline_param(edl_, options_, p))
+            return "args";
+        if (is_chunked(p))
+            return "chunks";
+        if (in_place(p) || !has_in(p))
+            return "output";
+        return p->attrs_->inout_ ? "input+output" : "input";
+    }
+
+    /*
+     * In-out parameters are copied to the input buffer, then to the output
+     * buffer and back. Variable-length out parameters are packed before they
+     * are copied back.
+     */
+    uint64_t copies_per_byte(Decl* p)
+    {
+        if (!marshalled(p))
+            return 0;
+        if (in_place(p) || is_variable_length(p))
+            return 2;
+        return p->attrs_->inout_ ? 3 : 1;
+    }
+
+    static std::string count_str(Decl* p)
+    {
+        if (p->attrs_ && p->attrs_->string_)
+            return "strlen(" + p->name_ + ") + 1";
+        if (p->attrs_ && p->attrs_->wstring_)
+            return "wcslen(" + p->name_ + ") + 1";
+        return pcount(p);
+    }
+
+    /* The fixed number of elements of a sub-buffer, or 0 if it varies. */
+    static uint64_t count_value(Decl* p)
+    {
+        std::string count = count_str(p);
+        return is_number(count) ? std::stoull(count) : 0;
+    }
+
+    /* The layout of the elements that the count of a parameter counts. */
+    Layout element_layout(Decl* p)
+    {
+        if (p->attrs_ && !p->attrs_->size_.is_empty())
+        {
+            std::string size = p->attrs_->size_;
+            return is_number(size) ? Layout{std::stoull(size), 1, true}
+                                   : Layout{0, 1, false};
+        }
+        if (p->dims_)
+            return decl_layout(edl_, p->type_, p->dims_);
+        if (p->type_->tag_ == Ptr)
+            return type_layout(edl_, p->type_->t_);
+        return Layout{0, 1, false};
+    }
+
+    static std::string bytes_str(Decl* p)
+    {
+        std::string count = count_str(p);
+        std::string size = psize(p);
+        if (count == "1")
+            return size;
+        if (count.find(' ') != std::string::npos)
+            count = "(" + count + ")";
+        return count + " * " + size;
+    }
+
+    DeepCopy deep_copy(UserType* ut, std::set<UserType*>& path)
+    {
+        if (!path.insert(ut).second)
+            return DeepCopy{0, 0, true};
+        DeepCopy d{1, 0, false};
+        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+            d.fan_out_++;
+            UserType* nested = get_user_type_for_deep_copy(edl_, prop);
+            if (!nested)
+                return;
+            DeepCopy n = deep_copy(nested, path);
+            d.depth_ = std::max(d.depth_, n.depth_ + 1);
+            d.recursive_ = d.recursive_ || n.recursive_;
+        });
+        path.erase(ut);
+        return d;
+    }
+
+    /*
+     * Add the sub-buffer of a parameter, or of a field of a deep-copied
+     * struct, and its nested buffers to the size of a buffer. The nested
+     * buffers keep the default layout.
+     */
+    void add_buffer(BufferSize& size, Decl* p, bool field, bool nested)
+    {
+        std::string align = field ? "" : param_align_str(p);
+        bool compact = !field && is_compact_param(edl_, options_, p);
+        if (!field && options_.compact_layout_)
+        {
+            uint64_t a = compact_align(edl_, p);
+            if (!align.empty())
+                a = std::max(a, (uint64_t)std::stoull(align));
+            size.fixed_ += a - 1;
+        }
+        else if (!align.empty())
+            size.fixed_ += std::stoull(align) - 16;
+
+        Layout l = element_layout(p);
+        uint64_t count = count_value(p);
+        if (count && l.known_)
+            size.fixed_ += compact ? count * l.size_
+                                   : align_up(count * l.size_, 16);
+        else
+            size.dynamic_.push_back(
+                compact ? bytes_str(p) : "round16(" + bytes_str(p) + ")");
+
+        UserType* ut = get_user_type_for_deep_copy(edl_, p);
+        if (ut && nested)
+            size.dynamic_.push_back(nested_str(p, ut));
+    }
+
+    static std::string nested_str(Decl* p, UserType* ut)
+    {
+        std::string count = count_str(p);
+        return (count == "1" ? "" : count + " * ") + "nested(" + ut->name_ +
+               ")";
+    }
+
+    BufferSize buffer_size(Function* f, bool input)
+    {
+        BufferSize size{0, {}};
+        ArgsLayout layout = args_layout(edl_, f, options_);
+        if (layout.known_)
+            size.fixed_ = align_up(args_size(layout), 16);
+        else
+            size.dynamic_.push_back("round16(sizeof(" + f->name_ + "_args_t))");
+        bool aligned_outputs = false;
+        for (Decl* p : f->params_)
+        {
+            if (!marshalled(p) || is_chunked(p) ||
+                is_inline_param(edl_, options_, p))
+                continue;
+            if (!param_align_str(p).empty() && has_out(p))
+                aligned_outputs = true;
+            if (input ? !has_in(p) || in_place(p) : !has_out(p))
+                continue;
+            /* The nested buffers of out-only parameters are returned in the
+             * deep-copy out buffer. */
+            add_buffer(size, p, false, has_in(p));
+        }
+        if (options_.compact_layout_)
+            size.fixed_ += 15;
+        if (input && aligned_outputs)
+            size.fixed_ +=
+                std::stoull(buffer_align_str(f)) -
+                (options_.compact_layout_ ? 1 : 16);
+        return size;
+    }
+
+    static std::string formula(const BufferSize& size)
+    {
+        std::string s = size.fixed_ ? to_str(size.fixed_) : "";
+        for (const std::string& term : size.dynamic_)
+            s += (s.empty() ? "" : " + ") + term;
+        return s.empty() ? "0" : s;
+    }
+
+    void buffer(const std::string& key, const BufferSize& size)
+    {
+        open(key, "{");
+        number("fixed", size.fixed_);
+        open("dynamic", "[");
+        for (const std::string& term : size.dynamic_)
+            string("", term);
+        close("]");
+        string("worst_case", formula(size));
+        close("}");
+    }
+
+    void function(Function* f)
+    {
+        open("", "{");
+        string("name", f->name_);
+        string("kind", ecall_ ? "ecall" : "ocall");
+
+        ArgsLayout layout = args_layout(edl_, f, options_);
+        uint64_t payload = 4 + 16;
+        for (auto fields : {&layout.hole_, &layout.body_})
+            for (const ArgsField& field : *fields)
+                payload += field.layout_.size_;
+        uint64_t size = layout.known_ ? args_size(layout) : 0;
+        open("args_t", "{");
+        number("size", size, layout.known_);
+        number("padding", size - payload, layout.known_);
+        close("}");
+
+        BufferSize input = buffer_size(f, true);
+        BufferSize output = buffer_size(f, false);
+        buffer("input_buffer", input);
+        buffer("output_buffer", output);
+        BufferSize total{input.fixed_ + output.fixed_, input.dynamic_};
+        total.dynamic_.insert(
+            total.dynamic_.end(),
+            output.dynamic_.begin(),
+            output.dynamic_.end());
+        string("worst_case_size", formula(total));
+
+        std::vector<std::string> deep_copy_out;
+        for (Decl* p : f->params_)
+        {
+            UserType* ut = get_user_type_for_deep_copy(edl_, p);
+            if (ut && !has_in(p))
+                deep_copy_out.push_back(nested_str(p, ut));
+        }
+        if (!deep_copy_out.empty())
+        {
+            open("deep_copy_out_buffer", "[");
+            for (const std::string& term : deep_copy_out)
+                string("", term);
+            close("]");
+        }
+
+        open("params", "[");
+        for (Decl* p : f->params_)
+            param(p);
+        close("]");
+        close("}");
+    }
+
+    void param(Decl* p)
+    {
+        open("", "{");
+        string("name", p->name_);
+        string("decl", decl_str(p->name_, p->type_, p->dims_));
+        string("direction", direction(p));
+        string("location", location(p));
+        if (!marshalled(p))
+        {
+            Layout l = type_layout(edl_, p->type_);
+            if (is_pointer(p))
+                l = Layout{8, 8, true};
+            number("bytes", l.size_, l.known_);
+        }
+        else
+        {
+            Layout l = element_layout(p);
+            uint64_t count = count_value(p);
+            string("count", count_str(p));
+            number("element_size", l.size_, l.known_);
+            string("element_size_expr", psize(p));
+            number("bytes", count * l.size_, count && l.known_);
+        }
+        number("copies_per_byte", copies_per_byte(p));
+        if (is_variable_length(p))
+            string("length", p->attrs_->length_);
+        if (!param_align_str(p).empty())
+            number("align", std::stoull(param_align_str(p)));
+        if (is_chunked(p))
+            string("chunk_size", p->attrs_->chunked_);
+        if (is_inline_param(edl_, options_, p))
+            boolean("inline", true);
+        if (in_place(p))
+            boolean("in_place", true);
+        UserType* ut = get_user_type_for_deep_copy(edl_, p);
+        if (ut && marshalled(p))
+        {
+            std::set<UserType*> path;
+            DeepCopy d = deep_copy(ut, path);
+            open("deep_copy", "{");
+            string("type", ut->name_);
+            number("depth", d.depth_, !d.recursive_);
+            number("fan_out", d.fan_out_);
+            boolean("recursive", d.recursive_);
+            close("}");
+        }
+        close("}");
+    }
+
+    /* The size of the nested buffers of each deep-copied struct type. */
+    void deep_copy_types()
+    {
+        std::vector<UserType*> types;
+        std::set<UserType*> seen;
+        for (auto funcs : {&edl_->trusted_funcs_, &edl_->untrusted_funcs_})
+            for (Function* f : *funcs)
+                for (Decl* p : f->params_)
+                    if (marshalled(p))
+                        collect(
+                            get_user_type_for_deep_copy(edl_, p), types, seen);
+        if (types.empty())
+            return;
+        open("deep_copy_types", "[");
+        for (UserType* ut : types)
+        {
+            BufferSize size{0, {}};
+            iterate_deep_copyable_fields(
+                ut, [&](Decl* prop) { add_buffer(size, prop, true, true); });
+            open("", "{");
+            string("name", ut->name_);
+            string("nested", formula(size));
+            close("}");
+        }
+        close("]");
+    }
+
+    void collect(
+        UserType* ut,
+        std::vector<UserType*>& types,
+        std::set<UserType*>& seen)
+    {
+        if (!ut || !seen.insert(ut).second)
+            return;
+        types.push_back(ut);
+        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
+            collect(get_user_type_for_deep_copy(edl_, prop), types, seen);
+        });
+    }
+};
+
+#endif // REPORT_EMITTER_H
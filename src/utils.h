@@ -4,11 +4,13 @@
 #ifndef UTILS_H
 #define UTILS_H
 
+#include <cstdint>
 #include <ostream>
 #include <sstream>
 #include <string>
 
 #include "ast.h"
+#include "options.h"
 
 template <typename A, typename C>
 bool in(const A& a, const C& c)
@@ -151,28 +153,13 @@ inline std::string mdecl_str(
     return replace(decl, "const ", "");
 }
 
-inline std::string prototype(
-    const Function* f,
-    bool ecall = true,
-    bool gen_t = true,
-    const std::string& prefix = "")
+inline std::string args_str(
+    const std::vector<std::string>& args,
+    const std::string& empty = "(void)")
 {
-    std::string retstr =
-        (ecall != gen_t) ? "oe_result_t" : atype_str(f->rtype_);
-
-    std::vector<std::string> args;
-    if (ecall && !gen_t)
-        args.push_back("oe_enclave_t* enclave");
-
-    if (ecall != gen_t && f->rtype_->tag_ != Void)
-        args.push_back(atype_str(f->rtype_) + "* _retval");
-
-    for (Decl* p : f->params_)
-        args.push_back(decl_str(p->name_, p->type_, p->dims_));
-
     std::string argsstr;
     if (args.empty())
-        argsstr = gen_t && !ecall ? "(\n    )" : "(void)";
+        argsstr = empty;
     else if (args.size() == 1)
         argsstr = "(" + args[0] + ")";
     else
@@ -182,7 +169,77 @@ inline std::string prototype(
             argsstr += ",\n    " + args[i];
         argsstr += ")";
     }
-    return retstr + " " + prefix + f->name_ + argsstr;
+    return argsstr;
+}
+
+/*
+ * With deepcopy_out_arena, the wrapper returns the block that holds the
+ * nested out pointers through an extra argument.
+ */
+inline std::vector<std::string> prototype_args(
+    const Function* f,
+    bool ecall,
+    bool gen_t,
+    bool deepcopy_out_arena = false)
+{
+    std::vector<std::string> args;
+    if (ecall && !gen_t)
+        args.push_back("oe_enclave_t* enclave");
+
+    if (ecall != gen_t && f->rtype_->tag_ != Void)
+        args.push_back(atype_str(f->rtype_) + "* _retval");
+
+    for (Decl* p : f->params_)
+        args.push_back(decl_str(p->name_, p->type_, p->dims_));
+    if (deepcopy_out_arena && ecall != gen_t)
+        args.push_back("void** _deepcopy_out_arena");
+    return args;
+}
+
+inline std::string prototype(
+    const Function* f,
+    bool ecall = true,
+    bool gen_t = true,
+    const std::string& prefix = "",
+    bool deepcopy_out_arena = false)
+{
+    std::string retstr =
+        (ecall != gen_t) ? "oe_result_t" : atype_str(f->rtype_);
+    std::string empty = gen_t && !ecall ? "(\n    )" : "(void)";
+    return retstr + " " + prefix + f->name_ +
+           args_str(
+               prototype_args(f, ecall, gen_t, deepcopy_out_arena), empty);
+}
+
+/* The prototype of the <function>_async variant of a wrapper. */
+/* Only ECALLs have an asynchronous variant, which the host wrapper posts. */
+inline std::string async_prototype(
+    const Function* f,
+    const std::string& prefix = "",
+    bool deepcopy_out_arena = false)
+{
+    return "oe_call_handle_t " + prefix + f->name_ + "_async" +
+           args_str(prototype_args(f, true, false, deepcopy_out_arena));
+}
+
+inline std::string free_out_prototype(
+    const Function* f,
+    const std::string& prefix = "")
+{
+    return "void " + prefix + f->name_ + "_free_out(void* _deepcopy_out_arena)";
+}
+
+inline std::string batch_prototype(
+    const Function* f,
+    const std::string& prefix = "",
+    const std::string& name_prefix = "")
+{
+    return "oe_result_t " + name_prefix + f->name_ +
+           "_batch(\n"
+           "    oe_enclave_t* enclave,\n"
+           "    size_t n,\n    " +
+           prefix + f->name_ + "_batch_args_t* calls,\n" +
+           "    oe_result_t* results)";
 }
 
 inline std::string create_prototype(const std::string& ename)
@@ -364,6 +421,313 @@ inline bool has_deep_copy_out(Edl* edl, Function* f)
     return result;
 }
 
+/*
+ * With --deepcopy-out-arena, the wrappers of the functions with deep-copied
+ * out parameters return the block that holds the nested out pointers, which
+ * the caller releases with <function>_free_out.
+ */
+inline bool has_deepcopy_out_arena(
+    Edl* edl,
+    const Options& options,
+    Function* f)
+{
+    return options.deepcopy_out_arena_ && has_deep_copy_out(edl, f);
+}
+
+inline std::string deepcopy_helper_name(
+    const std::string& kind,
+    UserType* ut)
+{
+    return "_oe_deepcopy_" + kind + "_" + ut->name_;
+}
+
+/*
+ * The index of the fixup table of a type, used with --deepcopy-offsets.
+ */
+inline std::string deepcopy_type_id(UserType* ut)
+{
+    return "_oe_deepcopy_type_" + ut->name_;
+}
+
+/*
+ * Call a deep-copy helper and bail out on failure. The result goes through a
+ * local, so checks that later jump to done without setting _result still
+ * fail.
+ */
+inline std::string deepcopy_helper_call(
+    const std::string& indent,
+    const std::string& helper,
+    const std::vector<std::string>& args)
+{
+    std::string s = indent + "oe_result_t _helper_result = " + helper + "(";
+    for (size_t i = 0; i < args.size(); i++)
+        s += "\n" + indent + "    " + args[i] +
+             (i + 1 < args.size() ? "," : ");");
+    return s + "\n" + indent + "if (_helper_result != OE_OK)\n" + indent +
+           "{\n" + indent + "    _result = _helper_result;\n" + indent +
+           "    goto done;\n" + indent + "}";
+}
+
+/*
+ * In-out parameters of OCALLs without nested pointers can live in a single
+ * region of the output buffer since the host reads and writes the
+ * marshalling buffer directly. ECALL buffers are copied across the trust
+ * boundary separately, so ECALLs always use the two-region layout.
+ */
+inline bool is_in_place_in_out(
+    Edl* edl,
+    const Options& options,
+    bool ecall,
+    Decl* p)
+{
+    if (!options.in_place_in_out_ || ecall)
+        return false;
+    if (!p->attrs_ || !p->attrs_->inout_ || p->attrs_->host_memory_)
+        return false;
+    return get_user_type_for_deep_copy(edl, p) == nullptr;
+}
+
+/*
+ * Parameters of OCALLs that already point to host memory are checked to lie
+ * outside the enclave and passed to the host as is, without a copy.
+ */
+inline bool is_host_memory(Decl* p)
+{
+    return p->attrs_ && p->attrs_->host_memory_;
+}
+
+/*
+ * Chunked ECALL parameters are streamed to <function>_<param>_sink or from
+ * <function>_<param>_source in the enclave, one chunk per ECALL, and the
+ * function itself gets null for them. <function>_<param>_begin comes with the
+ * first chunk of a call and <function>_<param>_abort follows a call that
+ * failed after it.
+ */
+inline bool is_chunked(Decl* p)
+{
+    return p->attrs_ && !p->attrs_->chunked_.is_empty();
+}
+
+inline bool has_chunked(Edl* edl)
+{
+    for (Function* f : edl->trusted_funcs_)
+        for (Decl* p : f->params_)
+            if (is_chunked(p))
+                return true;
+    return false;
+}
+
+/* The type of the elements of a chunked parameter. */
+inline std::string chunk_type_str(Decl* p)
+{
+    Type* t = p->type_->t_;
+    return atype_str(t->tag_ == Const ? t->t_ : t);
+}
+
+/* The most elements of a chunked parameter that one chunk holds. */
+inline std::string chunk_count_str(Decl* p)
+{
+    std::string n = static_cast<std::string>(p->attrs_->chunked_);
+    std::string size = "sizeof(" + chunk_type_str(p) + ")";
+    return "(" + n + " < " + size + " ? 1 : " + n + " / " + size + ")";
+}
+
+/*
+ * The chunk callbacks get the parameters that the function takes by value,
+ * which tell the calls that run at the same time apart.
+ */
+inline bool is_by_value(Decl* p)
+{
+    return p->type_->tag_ != Ptr && !p->dims_ &&
+           !(p->attrs_ && (p->attrs_->isptr_ || p->attrs_->isary_));
+}
+
+/* A name for a chunk argument that no by-value parameter takes. */
+inline std::string chunk_arg_name(Function* f, const std::string& name)
+{
+    for (Decl* p : f->params_)
+        if (is_by_value(p) && p->name_ == name)
+            return chunk_arg_name(f, "_" + name);
+    return name;
+}
+
+inline std::string chunk_callback_prototype(
+    Function* f,
+    Decl* p,
+    const std::string& suffix)
+{
+    std::vector<std::string> args;
+    for (Decl* q : f->params_)
+        if (is_by_value(q))
+            args.push_back(decl_str(q->name_, q->type_, q->dims_));
+    if (suffix == "_sink" || suffix == "_source")
+    {
+        args.push_back(
+            (p->attrs_->in_ ? "const " : "") + chunk_type_str(p) + "* " +
+            chunk_arg_name(f, "chunk"));
+        args.push_back("size_t " + chunk_arg_name(f, "offset"));
+        args.push_back("size_t " + chunk_arg_name(f, "count"));
+    }
+    return "void " + f->name_ + "_" + p->name_ + suffix + args_str(args);
+}
+
+/*
+ * Only the produced part of an out parameter with a `length' attribute is
+ * copied back. The length counts elements when the parameter has a count and
+ * bytes otherwise, and such parameters follow the others in the output buffer.
+ */
+inline bool is_variable_length(Decl* p)
+{
+    return p->attrs_ && !p->attrs_->length_.is_empty();
+}
+
+inline bool has_variable_length(Function* f)
+{
+    for (Decl* p : f->params_)
+        if (is_variable_length(p))
+            return true;
+    return false;
+}
+
+/* The most elements or bytes that a variable-length parameter holds. */
+inline std::string length_capacity_str(Decl* p, const std::string& prefix)
+{
+    return p->attrs_->count_.is_empty() ? psize(p, prefix) : pcount(p, prefix);
+}
+
+/* The size of the units that the length of a parameter counts. */
+inline std::string length_unit_str(Decl* p, const std::string& prefix)
+{
+    return p->attrs_->count_.is_empty() ? "1" : psize(p, prefix);
+}
+
+/* The produced length, or zero when the length pointer is null. */
+inline std::string length_value_str(Decl* p, const std::string& prefix)
+{
+    std::string length = prefix + static_cast<std::string>(p->attrs_->length_);
+    return "(" + length + " ? *" + length + " : 0)";
+}
+
+/*
+ * The sub-buffer of a parameter with an `align' attribute starts at a
+ * multiple of the alignment, and the wrapper aligns the marshalling buffer to
+ * the largest one of the function.
+ */
+inline std::string param_align_str(Decl* p)
+{
+    if (!p->attrs_ || p->attrs_->align_.is_empty())
+        return "";
+    return p->attrs_->align_;
+}
+
+inline std::string buffer_align_str(Function* f)
+{
+    uint64_t align = 0;
+    std::string s;
+    for (Decl* p : f->params_)
+    {
+        std::string a = param_align_str(p);
+        if (!a.empty() && std::stoull(a) > align)
+        {
+            align = std::stoull(a);
+            s = a;
+        }
+    }
+    return s;
+}
+
+inline bool has_deferred(Edl* edl)
+{
+    for (Function* f : edl->untrusted_funcs_)
+        if (f->deferred_)
+            return true;
+    return false;
+}
+
+inline std::string flush_deferred_prototype(Edl* edl)
+{
+    return "oe_result_t " + edl->name_ + "_flush_deferred(void)";
+}
+
+/* Calls of the trace hooks emitted with --instrument. */
+inline std::string trace_begin_str(Function* f, Edl* edl, bool ecall)
+{
+    return "    oe_edger8r_trace_begin(" + edl->name_ + "_fcn_id_" + f->name_ +
+           ", \"" + f->name_ + "\", " + (ecall ? "true" : "false") + ");";
+}
+
+inline std::string trace_point_str(
+    Function* f,
+    Edl* edl,
+    const std::string& point,
+    const std::string& prefix)
+{
+    return "    oe_edger8r_trace_point(\n        " + edl->name_ + "_fcn_id_" +
+           f->name_ + ",\n        OE_EDGER8R_TRACE_" + point +
+           ",\n        " + prefix + "input_buffer_size,\n        " + prefix +
+           "output_buffer_size);";
+}
+
+inline std::string trace_end_str(Function* f, Edl* edl)
+{
+    return "    oe_edger8r_trace_end(" + edl->name_ + "_fcn_id_" + f->name_ +
+           ", _result);";
+}
+
+/* Accessors of the call counters emitted with --stats. */
+inline std::string get_call_stats_prototype(Edl* edl)
+{
+    return "size_t " + edl->name_ +
+           "_get_call_stats(oe_call_stats_t* stats, size_t count)";
+}
+
+inline std::string reset_call_stats_prototype(Edl* edl)
+{
+    return "void " + edl->name_ + "_reset_call_stats(void)";
+}
+
+/* The number of records that fit in the ring of a channel. */
+inline std::string channel_capacity_str(Channel* c)
+{
+    return "(" + to_str(c->size_) + " / sizeof(" + atype_str(c->type_) + "))";
+}
+
+inline std::string channel_open_prototype(Channel* c)
+{
+    return "oe_result_t " + c->name_ + "_open(\n" +
+           "    oe_enclave_t* enclave,\n    " + c->name_ +
+           "_channel_t** channel)";
+}
+
+inline std::string channel_close_prototype(Channel* c)
+{
+    return "oe_result_t " + c->name_ + "_close(" + c->name_ +
+           "_channel_t* channel)";
+}
+
+/* The host sends into [in] channels and the enclave into [out] channels. */
+inline bool channel_sends(Channel* c, bool host)
+{
+    return c->in_ == host;
+}
+
+/* The host passes the channel it opened, the enclave has just one. */
+inline std::string channel_send_prototype(Channel* c, bool host)
+{
+    return "size_t " + c->name_ + "_send(\n" +
+           (host ? "    " + c->name_ + "_channel_t* channel,\n" : "") +
+           "    const " + atype_str(c->type_) + "* records,\n" +
+           "    size_t count)";
+}
+
+inline std::string channel_receive_prototype(Channel* c, bool host)
+{
+    return "size_t " + c->name_ + "_receive(\n" +
+           (host ? "    " + c->name_ + "_channel_t* channel,\n" : "") +
+           "    " + atype_str(c->type_) + "* records,\n" +
+           "    size_t count)";
+}
+
 inline const char* path_sep()
 {
 #if _WIN32
@@ -7,12 +7,15 @@
 #include <fstream>
 
 #include "ast.h"
+#include "layout.h"
+#include "options.h"
 #include "utils.h"
 
 class WEmitter
 {
     Edl* edl_;
     std::ofstream& file_;
+    const Options& options_;
     bool ecall_;
     bool has_deep_copy_out_;
 
@@ -31,8 +34,8 @@ class WEmitter
     }
 
   public:
-    WEmitter(Edl* edl, std::ofstream& file)
-        : edl_(edl), file_(file), ecall_(true)
+    WEmitter(Edl* edl, std::ofstream& file, const Options& options)
+        : edl_(edl), file_(file), options_(options), ecall_(true)
     {
     }
 
@@ -76,6 +79,11 @@ class WEmitter
 
     void emit(Function* f, bool ecall, const std::string& prefix = "")
     {
+        if (!ecall && f->deferred_)
+        {
+            emit_deferred(f);
+            return;
+        }
         ecall_ = ecall;
         has_deep_copy_out_ = has_deep_copy_out(edl_, f);
         std::string alloc_fcn;
@@ -95,15 +103,32 @@ class WEmitter
          * linker.
          */
         std::string _prefix = ecall ? edl_->name_ + "_" + prefix : prefix;
-        out() << prototype(f, ecall, gen_t(), _prefix) << "{"
+        bool arena = has_deepcopy_out_arena(edl_, options_, f);
+        out() << prototype(f, ecall, gen_t(), _prefix, arena) << "{"
               << "    oe_result_t _result = OE_FAILURE;"
               << "";
         if (!gen_t())
         {
-            out() << "    static uint64_t global_id = OE_GLOBAL_ECALL_ID_NULL;"
-                  << "";
+            out() << "    static uint64_t global_id = OE_GLOBAL_ECALL_ID_NULL;";
+            for (Decl* p : f->params_)
+                if (is_chunked(p))
+                    out() << "    static uint64_t _" + p->name_ +
+                                 "_global_id = OE_GLOBAL_ECALL_ID_NULL;";
+            out() << "";
         }
         enclave_status_check();
+        if (gen_t() && has_deferred(edl_))
+            out() << "    /* Deliver the deferred OCALLs first to keep the "
+                     "call order. */"
+                  << "    if ((_result = _" + edl_->name_ +
+                         "_deferred_deliver()) != OE_OK)"
+                  << "        return _result;"
+                  << "";
+        if (arena)
+            out() << "    if (!_deepcopy_out_arena)"
+                  << "        return OE_INVALID_PARAMETER;"
+                  << "    *_deepcopy_out_arena = NULL;"
+                  << "";
         out() << "    /* Marshalling struct. */"
               << "    " + args_t +
                      " _args, *_pargs_in = NULL, *_pargs_out = NULL;";
@@ -125,10 +150,25 @@ class WEmitter
                   << "    size_t _deepcopy_out_buffer_size = 0;"
                   << "    size_t _deepcopy_out_buffer_offset = 0;";
         }
+        for (Decl* p : f->params_)
+            if (is_chunked(p))
+            {
+                out() << "    size_t _chunked_size = 0;";
+                break;
+            }
+        for (Decl* p : f->params_)
+            if (is_chunked(p) && p->attrs_->in_)
+                out() << "    int _" + p->name_ + "_pending = 0;";
+        if (options_.stats_)
+            out() << "    uint64_t _call_stats_begin = oe_call_stats_begin();";
+        if (options_.instrument_)
+            out() << "" << trace_begin_str(f, edl_, ecall);
         out() << ""
               << "    /* Fill marshalling struct. */"
               << "    memset(&_args, 0, sizeof(_args));";
         fill_marshalling_struct(f);
+        check_host_memory_params(f);
+        stream_chunks(f, true);
         out() << ""
               << "    /* Compute input buffer size. Include in and in-out "
                  "parameters. */";
@@ -137,14 +177,38 @@ class WEmitter
               << "    /* Compute output buffer size. Include out and in-out "
                  "parameters. */";
         compute_output_buffer_size(f);
+        std::string align = buffer_align_str(f);
+        /* The ECALL forwarder moves each buffer up to the alignment, into
+         * room reserved after it. */
+        std::string slack = !gen_t() && !align.empty() ? " + " + align : "";
+        if (align.empty())
+            out() << "    "
+                  << "    /* Allocate marshalling buffer. */"
+                  << "    _total_buffer_size = _input_buffer_size;"
+                  << "    OE_ADD_SIZE(_total_buffer_size, _output_buffer_size);"
+                  << "    _buffer = (uint8_t*)" + alloc_fcn +
+                         "(_total_buffer_size);"
+                  << "    _input_buffer = _buffer;"
+                  << "    _output_buffer = _buffer + _input_buffer_size;";
+        else
+        {
+            out() << "    "
+                  << "    /* Allocate marshalling buffer, with room to align "
+                     "it to " + align + " bytes. */"
+                  << "    _total_buffer_size = _input_buffer_size;"
+                  << "    OE_ADD_SIZE(_total_buffer_size, _output_buffer_size);"
+                  << "    OE_ADD_SIZE(_total_buffer_size, " + align + ");";
+            if (!slack.empty())
+                out() << "    OE_ADD_SIZE(_total_buffer_size, 2 * " + align +
+                             ");";
+            out() << "    _buffer = (uint8_t*)" + alloc_fcn +
+                         "(_total_buffer_size);"
+                  << "    _input_buffer = OE_ALIGN_POINTER(_buffer, " + align +
+                         ");"
+                  << "    _output_buffer = _input_buffer + _input_buffer_size" +
+                         slack + ";";
+        }
         out()
-            << "    "
-            << "    /* Allocate marshalling buffer. */"
-            << "    _total_buffer_size = _input_buffer_size;"
-            << "    OE_ADD_SIZE(_total_buffer_size, _output_buffer_size);"
-            << "    _buffer = (uint8_t*)" + alloc_fcn + "(_total_buffer_size);"
-            << "    _input_buffer = _buffer;"
-            << "    _output_buffer = _buffer + _input_buffer_size;"
             << "    if (_buffer == NULL)"
             << "    {"
             << "        _result = OE_OUT_OF_MEMORY;"
@@ -160,6 +224,8 @@ class WEmitter
         else /* use the hardened version of memcpy for host writes */
             out() << "    oe_memcpy_with_barrier(_pargs_in, &_args, "
                      "sizeof(*_pargs_in));";
+        if (options_.instrument_)
+            out() << trace_point_str(f, edl_, "MARSHALLED", "_");
         out() << ""
               << "    /* Call " + other + " function. */"
               << "    if ((_result = " + call + "(";
@@ -175,20 +241,32 @@ class WEmitter
             out() << "             " + fcn_id + ",";
         }
         out() << "             _input_buffer,"
-              << "             _input_buffer_size,"
+              << "             _input_buffer_size" + slack + ","
               << "             _output_buffer,"
-              << "             _output_buffer_size,"
+              << "             _output_buffer_size" + slack + ","
               << "             &_output_bytes_written)) != OE_OK)"
               << "        goto done;"
-              << ""
-              << "    /* Currently exactly _output_buffer_size bytes must be "
-                 "written. */"
-              << "    if (_output_bytes_written != _output_buffer_size)"
-              << "    {"
+              << "";
+        if (options_.instrument_)
+            out() << trace_point_str(f, edl_, "RETURNED", "_") << "";
+        bool variable_length = has_variable_length(f);
+        if (variable_length)
+            out() << "    /* The variable-length out parameters may leave the "
+                     "end of the buffer unwritten. */"
+                  << "    if (_output_bytes_written > _output_buffer_size ||"
+                  << "        _output_bytes_written < sizeof(" + args_t + "))";
+        else
+            out() << "    /* Currently exactly _output_buffer_size bytes must "
+                     "be written. */"
+                  << "    if (_output_bytes_written != _output_buffer_size)";
+        out() << "    {"
               << "        _result = OE_FAILURE;"
               << "        goto done;"
               << "    }"
               << "";
+        /* Only the written part of the output buffer is read. */
+        std::string read_size =
+            variable_length ? "_output_bytes_written" : "_output_buffer_size";
         if (gen_t())
             out() << "    /* Allocate an enclave buffer for reading the host "
                      "buffer */"
@@ -202,16 +280,16 @@ class WEmitter
                   << "            goto done;"
                   << "        }"
                   << ""
-                  << "        /* _output_buffer and _output_buffer_size should "
-                     "be always 8-byte aligned */"
+                  << "        /* _output_buffer and " + read_size +
+                         " should be always 8-byte aligned */"
                   << "        if (((uint64_t)_output_buffer % 8) != 0 || "
-                     "(_output_buffer_size % 8) != 0)"
+                     "(" + read_size + " % 8) != 0)"
                   << "        {"
                   << "            _result = OE_FAILURE;"
                   << "            goto done;"
                   << "        }"
                   << "        oe_memcpy_aligned(_output_buffer_trusted, "
-                     "_output_buffer, _output_buffer_size);"
+                     "_output_buffer, " + read_size + ");"
                   << ""
                   << "        /* Now _output_buffer points to the enclave "
                      "memory */"
@@ -224,8 +302,9 @@ class WEmitter
               << ""
               << "    /* Check if the call succeeded. */"
               << "    if ((_result = _pargs_out->oe_result) != OE_OK)"
-              << "        goto done;"
-              << ""
+              << "        goto done;";
+        take_chunks(f);
+        out() << ""
               << "    /* Unmarshal return value and out, in-out parameters. */";
         if (f->rtype_->tag_ != Void)
             out() << "    *_retval = _pargs_out->oe_retval;";
@@ -251,6 +330,17 @@ class WEmitter
         }
         unmarshal_outputs(f);
         out() << "";
+        if (variable_length && options_.compact_layout_)
+            out() << "    OE_ALIGN_SIZE_COMPACT(_output_buffer_offset, "
+                     "OE_EDGER8R_BUFFER_ALIGNMENT);";
+        if (variable_length)
+            out() << "    if (_output_buffer_offset != _output_bytes_written)"
+                  << "    {"
+                  << "        _result = OE_FAILURE;"
+                  << "        goto done;"
+                  << "    }"
+                  << "";
+        stream_chunks(f, false);
         if (has_deep_copy_out_)
             out() << "    if (_deepcopy_out_buffer_offset != "
                      "_deepcopy_out_buffer_size)"
@@ -260,22 +350,54 @@ class WEmitter
                   << "    }"
                   << "";
         propagate_errno(f);
+        if (options_.instrument_)
+            out() << trace_point_str(f, edl_, "UNMARSHALLED", "_") << "";
+        if (arena)
+            out() << "    *_deepcopy_out_arena = _deepcopy_out_buffer;";
         out() << "    _result = OE_OK;"
               << ""
-              << "done:"
-              << "    if (_buffer)"
+              << "done:";
+        abort_chunks(f);
+        out() << "    if (_buffer)"
               << "        " + free_fcn + "(_buffer);"
               << "";
         if (gen_t())
             out() << "    if (_output_buffer_trusted)"
                   << "        oe_free(_output_buffer_trusted);"
                   << "";
-        if (has_deep_copy_out_)
+        if (arena)
+        {
+            out() << "    /* The nested out pointers are carved from "
+                     "_deepcopy_out_buffer, which is"
+                  << "       returned through _deepcopy_out_arena and "
+                     "released by"
+                  << "       " + f->name_ +
+                         "_free_out. Free it here only on failure. */"
+                  << "    if (_deepcopy_out_buffer && _result != OE_OK)"
+                  << "        oe_free(_deepcopy_out_buffer);"
+                  << "";
+        }
+        else if (has_deep_copy_out_)
         {
             out() << "    if (_deepcopy_out_buffer)"
                   << "        oe_free(_deepcopy_out_buffer);"
                   << "";
         }
+        if (options_.stats_)
+            out() << "    oe_call_stats_end("
+                  << "        &_" + edl_->name_ + "_call_stats[" + fcn_id + "],"
+                  << "        _call_stats_begin,"
+                  << "        _result,"
+                  << "        _input_buffer_size,"
+                  << "        _output_buffer_size,"
+                  << "        " +
+                         std::string(
+                             has_deep_copy_out_ ? "_deepcopy_out_buffer_size"
+                                                : "0") +
+                         ");"
+                  << "";
+        if (options_.instrument_)
+            out() << trace_end_str(f, edl_);
         out() << "    return _result;"
               << "}"
               << "";
@@ -283,6 +405,656 @@ class WEmitter
             out() << "OE_WEAK_ALIAS(" + _prefix + f->name_ + ", " + prefix +
                          f->name_ + ");"
                   << "";
+        if (arena)
+            emit_free_out(f, prefix, _prefix);
+        if (f->async_)
+            emit_async(f, prefix, _prefix);
+    }
+
+    /*
+     * Emit the <function>_async variant of an ECALL wrapper. It captures the
+     * arguments and posts a call of the wrapper to a host worker thread, so
+     * the buffers passed to it must stay valid until oe_call_wait returns.
+     */
+    void emit_async(
+        Function* f,
+        const std::string& prefix,
+        const std::string& _prefix)
+    {
+        std::string context_t = f->name_ + "_async_context_t";
+        std::string call = "_" + f->name_ + "_async_call";
+        bool arena = has_deepcopy_out_arena(edl_, options_, f);
+        std::vector<std::string> args{"enclave"};
+        out() << "typedef struct _" + context_t << "{"
+              << "    oe_enclave_t* enclave;";
+        if (f->rtype_->tag_ != Void)
+        {
+            out() << "    " + atype_str(f->rtype_) + "* _retval;";
+            args.push_back("_retval");
+        }
+        for (Decl* p : f->params_)
+        {
+            out() << "    " + async_member_str(p) + ";";
+            args.push_back(p->name_);
+        }
+        if (arena)
+        {
+            out() << "    void** _deepcopy_out_arena;";
+            args.push_back("_deepcopy_out_arena");
+        }
+        out() << "} " + context_t + ";"
+              << ""
+              << "static oe_result_t " + call + "(void* context)"
+              << "{"
+              << "    " + context_t + "* _context = (" + context_t +
+                     "*)context;"
+              << "    oe_result_t _result = " + _prefix + f->name_ + "(";
+        for (size_t i = 0; i < args.size(); i++)
+            out() << "        _context->" + args[i] +
+                         (i + 1 < args.size() ? "," : ");");
+        out() << ""
+              << "    oe_free(_context);"
+              << "    return _result;"
+              << "}"
+              << ""
+              << async_prototype(f, _prefix, arena) << "{"
+              << "    oe_call_handle_t _handle = NULL;"
+              << "    " + context_t + "* _context = (" + context_t +
+                     "*)oe_malloc(sizeof(" + context_t + "));"
+              << ""
+              << "    if (_context == NULL)"
+              << "        return NULL;"
+              << ""
+              << "    _context->enclave = enclave;";
+        if (f->rtype_->tag_ != Void)
+            out() << "    _context->_retval = _retval;";
+        for (Decl* p : f->params_)
+            out() << "    _context->" + p->name_ + " = " +
+                         (is_array(p) ? "(void*)" : "") + p->name_ + ";";
+        if (arena)
+            out() << "    _context->_deepcopy_out_arena = _deepcopy_out_arena;";
+        out() << ""
+              << "    /* The worker frees _context once the call completes. "
+                 "*/"
+              << "    _handle = oe_call_post(" + call + ", _context);"
+              << "    if (_handle == NULL)"
+              << "        oe_free(_context);"
+              << ""
+              << "    return _handle;"
+              << "}"
+              << ""
+              << "OE_WEAK_ALIAS(" + _prefix + f->name_ + "_async, " + prefix +
+                     f->name_ + "_async);"
+              << "";
+    }
+
+    static bool is_array(Decl* p)
+    {
+        return p->dims_ ||
+               (p->type_->tag_ == Foreign && p->attrs_ && p->attrs_->isary_);
+    }
+
+    /* Arrays decay to pointers when passed to the wrapper. */
+    static std::string async_member_str(Decl* p)
+    {
+        if (is_array(p))
+            return "void* " + p->name_;
+        Type* t = p->type_->tag_ == Const ? p->type_->t_ : p->type_;
+        return decl_str(p->name_, t, nullptr);
+    }
+
+    /* Release the block returned through _deepcopy_out_arena. */
+    void emit_free_out(
+        Function* f,
+        const std::string& prefix,
+        const std::string& _prefix)
+    {
+        out() << free_out_prototype(f, _prefix) << "{"
+              << "    oe_free(_deepcopy_out_arena);"
+              << "}"
+              << "";
+        if (!gen_t())
+            out() << "OE_WEAK_ALIAS(" + _prefix + f->name_ + "_free_out, " +
+                         prefix + f->name_ + "_free_out);"
+                  << "";
+    }
+
+    /*
+     * Emit the host-side <function>_batch wrapper of a batchable ECALL. The
+     * argument sets of all the calls are marshalled as an array of
+     * <function>_args_t that follows a batch header in a single buffer and
+     * submitted with one enclave transition.
+     */
+    void emit_batch(Function* f, const std::string& prefix = "")
+    {
+        ecall_ = true;
+        std::string alloc_fcn;
+        std::string free_fcn;
+        std::string call;
+        get_functions(f, alloc_fcn, free_fcn, call);
+        std::string fcn_id = edl_->name_ + "_fcn_id_" + f->name_ + "_batch";
+        std::string args_t = f->name_ + "_args_t";
+        std::string header_t = edl_->name_ + "_batch_header_t";
+        std::string _prefix = edl_->name_ + "_" + prefix;
+        out() << batch_prototype(f, prefix, _prefix) << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    static uint64_t global_id = OE_GLOBAL_ECALL_ID_NULL;"
+              << ""
+              << "    /* Marshalling structs. */"
+              << "    " + header_t +
+                     " *_pheader_in = NULL, *_pheader_out = NULL;"
+              << "    " + args_t + " *_pargs_in = NULL, *_pargs_out = NULL;"
+              << "    /* Marshalling buffer and sizes. */"
+              << "    size_t _input_buffer_size = 0;"
+              << "    size_t _output_buffer_size = 0;"
+              << "    size_t _total_buffer_size = 0;"
+              << "    uint8_t* _buffer = NULL;"
+              << "    uint8_t* _input_buffer = NULL;"
+              << "    uint8_t* _output_buffer = NULL;"
+              << "    size_t _output_bytes_written = 0;"
+              << "    size_t _i = 0;"
+              << ""
+              << "    if (n && (!calls || !results))"
+              << "    {"
+              << "        _result = OE_INVALID_PARAMETER;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    /* Compute buffer sizes. Both buffers hold the header "
+                 "and n arg structs. */"
+              << "    OE_ADD_SIZE(_input_buffer_size, sizeof(" + header_t +
+                     "));"
+              << "    OE_ADD_ARG_SIZE(_input_buffer_size, n, sizeof(" +
+                     args_t + "));"
+              << "    _output_buffer_size = _input_buffer_size;"
+              << ""
+              << "    /* Allocate marshalling buffer. */"
+              << "    _total_buffer_size = _input_buffer_size;"
+              << "    OE_ADD_SIZE(_total_buffer_size, _output_buffer_size);"
+              << "    _buffer = (uint8_t*)" + alloc_fcn +
+                     "(_total_buffer_size);"
+              << "    _input_buffer = _buffer;"
+              << "    _output_buffer = _buffer + _input_buffer_size;"
+              << "    if (_buffer == NULL)"
+              << "    {"
+              << "        _result = OE_OUT_OF_MEMORY;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    /* Serialize the header and the arg struct of each call. "
+                 "*/"
+              << "    memset(_input_buffer, 0, _input_buffer_size);"
+              << "    _pheader_in = (" + header_t + "*)_input_buffer;"
+              << "    _pheader_in->count = n;"
+              << "    _pargs_in = (" + args_t + "*)(_pheader_in + 1);";
+        if (f->params_.empty())
+            out() << "    OE_UNUSED(_pargs_in);";
+        else
+        {
+            out() << "    for (_i = 0; _i < n; _i++)"
+                  << "    {";
+            for (Decl* p : f->params_)
+                out() << "        _pargs_in[_i]." + p->name_ +
+                             " = calls[_i]." + p->name_ + ";";
+            out() << "    }";
+        }
+        out() << ""
+              << "    /* Call enclave function. */"
+              << "    if ((_result = " + call + "("
+              << "             enclave,"
+              << "             &global_id,"
+              << "             _" + edl_->name_ + "_ecall_info_table[" +
+                     fcn_id + "].name,"
+              << "             _input_buffer,"
+              << "             _input_buffer_size,"
+              << "             _output_buffer,"
+              << "             _output_buffer_size,"
+              << "             &_output_bytes_written)) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    /* Currently exactly _output_buffer_size bytes must be "
+                 "written. */"
+              << "    if (_output_bytes_written != _output_buffer_size)"
+              << "    {"
+              << "        _result = OE_FAILURE;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    /* Check if the batch succeeded. */"
+              << "    _pheader_out = (" + header_t + "*)_output_buffer;"
+              << "    if ((_result = _pheader_out->oe_result) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    /* Unmarshal the result and return value of each call. */"
+              << "    _pargs_out = (" + args_t + "*)(_pheader_out + 1);"
+              << "    for (_i = 0; _i < n; _i++)"
+              << "    {"
+              << "        results[_i] = _pargs_out[_i].oe_result;";
+        if (f->rtype_->tag_ != Void)
+            out() << "        if (results[_i] == OE_OK)"
+                  << "            calls[_i].oe_retval = "
+                     "_pargs_out[_i].oe_retval;";
+        out() << "    }"
+              << ""
+              << "    _result = OE_OK;"
+              << ""
+              << "done:"
+              << "    if (_buffer)"
+              << "        " + free_fcn + "(_buffer);"
+              << ""
+              << "    return _result;"
+              << "}"
+              << ""
+              << "OE_WEAK_ALIAS(" + _prefix + f->name_ + "_batch, " + prefix +
+                     f->name_ + "_batch);"
+              << "";
+    }
+
+    /*
+     * Emit the host side of the channels. Each open allocates the ring in
+     * host memory and passes it to the enclave with one ECALL; after that
+     * the records flow through the ring without enclave transitions.
+     */
+    void emit_channels()
+    {
+        ecall_ = true;
+        std::string args_t = edl_->name_ + "_channel_args_t";
+        std::string attach = "_" + edl_->name_ + "_attach_channel";
+        out() << "static oe_result_t " + attach + "("
+              << "    oe_enclave_t* enclave,"
+              << "    uint64_t* global_id,"
+              << "    uint32_t function_id,"
+              << "    oe_channel_ring_t* ring)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << "    " + args_t + " _args_in;"
+              << "    " + args_t + " _args_out;"
+              << "    size_t _output_bytes_written = 0;"
+              << ""
+              << "    memset(&_args_in, 0, sizeof(_args_in));"
+              << "    memset(&_args_out, 0, sizeof(_args_out));"
+              << "    _args_in.ring = ring;"
+              << ""
+              << "    /* Call enclave function. */"
+              << "    if ((_result = oe_call_enclave_function("
+              << "             enclave,"
+              << "             global_id,"
+              << "             _" + edl_->name_ +
+                     "_ecall_info_table[function_id].name,"
+              << "             &_args_in,"
+              << "             sizeof(_args_in),"
+              << "             &_args_out,"
+              << "             sizeof(_args_out),"
+              << "             &_output_bytes_written)) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    /* Exactly the args struct must be written. */"
+              << "    if (_output_bytes_written != sizeof(_args_out))"
+              << "    {"
+              << "        _result = OE_FAILURE;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    _result = _args_out.oe_result;"
+              << ""
+              << "done:"
+              << "    return _result;"
+              << "}"
+              << "";
+        for (Channel* c : edl_->channels_)
+            emit_channel(c, attach);
+    }
+
+    void emit_channel(Channel* c, const std::string& attach)
+    {
+        std::string channel_t = c->name_ + "_channel_t";
+        std::string global_id =
+            "_" + edl_->name_ + "_" + c->name_ + "_global_id";
+        std::string fcn_id = edl_->name_ + "_fcn_id_oe_channel_" + c->name_;
+        out() << "struct _" + c->name_ + "_channel"
+              << "{"
+              << "    oe_enclave_t* enclave;"
+              << "    oe_channel_t channel;"
+              << "};"
+              << ""
+              << "static uint64_t " + global_id +
+                     " = OE_GLOBAL_ECALL_ID_NULL;"
+              << ""
+              << channel_open_prototype(c) << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << "    " + channel_t + "* _channel = NULL;"
+              << "    oe_channel_t _init = {"
+              << "        NULL,"
+              << "        " + channel_capacity_str(c) + ","
+              << "        sizeof(" + atype_str(c->type_) + "),"
+              << "        0,"
+              << "        0};"
+              << ""
+              << "    if (!enclave || !channel)"
+              << "    {"
+              << "        _result = OE_INVALID_PARAMETER;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    /* Allocate the ring. Only its header needs to be "
+                 "cleared. */"
+              << "    _channel = (" + channel_t +
+                     "*)oe_malloc(sizeof(*_channel));"
+              << "    if (_channel == NULL)"
+              << "    {"
+              << "        _result = OE_OUT_OF_MEMORY;"
+              << "        goto done;"
+              << "    }"
+              << "    _channel->enclave = enclave;"
+              << "    _channel->channel = _init;"
+              << "    _channel->channel.ring = "
+                 "(oe_channel_ring_t*)oe_malloc(oe_channel_ring_size(&_init));"
+              << "    if (_channel->channel.ring == NULL)"
+              << "    {"
+              << "        _result = OE_OUT_OF_MEMORY;"
+              << "        goto done;"
+              << "    }"
+              << "    memset(_channel->channel.ring, 0, "
+                 "sizeof(oe_channel_ring_t));"
+              << ""
+              << "    if ((_result = " + attach + "("
+              << "             enclave,"
+              << "             &" + global_id + ","
+              << "             " + fcn_id + ","
+              << "             _channel->channel.ring)) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    *channel = _channel;"
+              << "    _channel = NULL;"
+              << ""
+              << "done:"
+              << "    if (_channel)"
+              << "    {"
+              << "        oe_free(_channel->channel.ring);"
+              << "        oe_free(_channel);"
+              << "    }"
+              << ""
+              << "    return _result;"
+              << "}"
+              << ""
+              << channel_close_prototype(c) << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    if (!channel)"
+              << "    {"
+              << "        _result = OE_INVALID_PARAMETER;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    /* Detach the ring from the enclave before freeing it. */"
+              << "    if ((_result = " + attach + "("
+              << "             channel->enclave,"
+              << "             &" + global_id + ","
+              << "             " + fcn_id + ","
+              << "             NULL)) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    oe_free(channel->channel.ring);"
+              << "    oe_free(channel);"
+              << ""
+              << "done:"
+              << "    return _result;"
+              << "}"
+              << "";
+        if (channel_sends(c, true))
+            out() << channel_send_prototype(c, true) << "{"
+                  << "    return oe_channel_send(&channel->channel, records, "
+                     "count);"
+                  << "}"
+                  << "";
+        else
+            out() << channel_receive_prototype(c, true) << "{"
+                  << "    return oe_channel_receive(&channel->channel, "
+                     "records, count);"
+                  << "}"
+                  << "";
+    }
+
+    /*
+     * Emit the enclave-side wrapper of a deferred OCALL. The input buffer of
+     * the call is marshalled into a record of the per-thread deferred OCALL
+     * buffer and the wrapper returns without leaving the enclave.
+     */
+    void emit_deferred(Function* f)
+    {
+        ecall_ = false;
+        std::string fcn_id = edl_->name_ + "_fcn_id_" + f->name_;
+        std::string args_t = f->name_ + "_args_t";
+        out() << prototype(f, false, true) << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << "";
+        enclave_status_check();
+        out() << "    /* Marshalling struct. */"
+              << "    " + args_t + " _args, *_pargs_in = NULL;"
+              << "    /* Marshalling buffer and sizes. */"
+              << "    size_t _input_buffer_size = 0;"
+              << "    uint8_t* _input_buffer = NULL;"
+              << "    size_t _input_buffer_offset = 0;"
+              << ""
+              << "    /* Fill marshalling struct. */"
+              << "    memset(&_args, 0, sizeof(_args));";
+        fill_marshalling_struct(f);
+        out() << ""
+              << "    /* Compute input buffer size. Include in parameters. */";
+        compute_input_buffer_size(f);
+        out() << ""
+              << "    /* Reserve a record in the deferred OCALL buffer. */"
+              << "    if ((_result = _" + edl_->name_ + "_deferred_reserve("
+              << "             " + fcn_id + ","
+              << "             _input_buffer_size,"
+              << "             &_input_buffer)) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    /* Serialize buffer inputs (in parameters). */";
+        serialize_buffer_inputs(f);
+        out() << ""
+              << "    /* The record holds the offsets of the parameters, which "
+                 "the host"
+              << "       forwarder turns back into pointers, instead of "
+                 "enclave addresses. */";
+        for (Decl* p : f->params_)
+            if (p->attrs_ && (p->attrs_->in_ || p->attrs_->inout_) &&
+                !in_place(p) && !is_host_memory(p) && !is_chunked(p))
+                out() << "    OE_SET_DEFERRED_OFFSET(" + p->name_ + ", " +
+                             mtype_str(p) + ");";
+        out() << ""
+              << "    /* Copy args structure (now filled) to the record. */"
+              << "    memcpy(_pargs_in, &_args, sizeof(*_pargs_in));"
+              << ""
+              << "    /* The host function is called when the buffer is "
+                 "flushed. */"
+              << "    _" + edl_->name_ +
+                     "_deferred_commit(_input_buffer_size);"
+              << "    _result = OE_OK;"
+              << ""
+              << "done:"
+              << "    return _result;"
+              << "}"
+              << "";
+    }
+
+    /*
+     * Emit the per-thread buffer of the deferred OCALLs and the functions
+     * that append records to it and deliver them to the host in one OCALL.
+     * The buffer is kept between deliveries and released by
+     * <edl>_flush_deferred, which a thread calls once it is done with the
+     * deferred OCALLs. The records still in a buffer are lost when the
+     * enclave is terminated.
+     */
+    void emit_deferred_buffer()
+    {
+        ecall_ = false;
+        std::string name = "_" + edl_->name_ + "_deferred";
+        std::string args_t = edl_->name_ + "_deferred_batch_args_t";
+        std::string record_t = edl_->name_ + "_deferred_record_t";
+        std::string fcn_id = edl_->name_ + "_fcn_id_oe_deferred_batch";
+        out() << "static OE_EDGER8R_THREAD_LOCAL uint8_t* " + name +
+                     "_buffer;"
+              << "static OE_EDGER8R_THREAD_LOCAL size_t " + name +
+                     "_buffer_size;"
+              << "static OE_EDGER8R_THREAD_LOCAL size_t " + name +
+                     "_buffer_offset;"
+              << ""
+              << "static oe_result_t " + name + "_deliver(void)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << ""
+              << "    /* Marshalling struct. */"
+              << "    " + args_t + " _args, *_pargs_out = NULL;"
+              << "    /* Marshalling buffer and sizes. */"
+              << "    size_t _input_buffer_size = 0;"
+              << "    size_t _output_buffer_size = 0;"
+              << "    size_t _total_buffer_size = 0;"
+              << "    uint8_t* _buffer = NULL;"
+              << "    uint8_t* _input_buffer = NULL;"
+              << "    uint8_t* _output_buffer = NULL;"
+              << "    size_t _input_buffer_offset = 0;"
+              << "    size_t _output_bytes_written = 0;"
+              << ""
+              << "    if (!" + name + "_buffer_offset)"
+              << "        return OE_OK;"
+              << ""
+              << "    /* The records follow the args struct in the input "
+                 "buffer. */"
+              << "    OE_ADD_SIZE(_input_buffer_offset, sizeof(_args));"
+              << "    _input_buffer_size = _input_buffer_offset;"
+              << "    OE_ADD_SIZE(_input_buffer_size, " + name +
+                     "_buffer_offset);"
+              << "    OE_ADD_SIZE(_output_buffer_size, sizeof(_args));"
+              << ""
+              << "    /* Allocate marshalling buffer. */"
+              << "    _total_buffer_size = _input_buffer_size;"
+              << "    OE_ADD_SIZE(_total_buffer_size, _output_buffer_size);"
+              << "    _buffer = (uint8_t*)oe_allocate_ocall_buffer("
+                 "_total_buffer_size);"
+              << "    _input_buffer = _buffer;"
+              << "    _output_buffer = _buffer + _input_buffer_size;"
+              << "    if (_buffer == NULL)"
+              << "    {"
+              << "        _result = OE_OUT_OF_MEMORY;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    memset(&_args, 0, sizeof(_args));"
+              << "    oe_memcpy_with_barrier(_input_buffer, &_args, "
+                 "sizeof(_args));"
+              << "    oe_memcpy_with_barrier("
+              << "        _input_buffer + _input_buffer_offset,"
+              << "        " + name + "_buffer,"
+              << "        " + name + "_buffer_offset);"
+              << ""
+              << "    /* The records are consumed even if the call fails. */"
+              << "    " + name + "_buffer_offset = 0;"
+              << ""
+              << "    /* Call host function. */"
+              << "    if ((_result = oe_call_host_function("
+              << "             " + fcn_id + ","
+              << "             _input_buffer,"
+              << "             _input_buffer_size,"
+              << "             _output_buffer,"
+              << "             _output_buffer_size,"
+              << "             &_output_bytes_written)) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    /* Currently exactly _output_buffer_size bytes must be "
+                 "written. */"
+              << "    if (_output_bytes_written != _output_buffer_size)"
+              << "    {"
+              << "        _result = OE_FAILURE;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    /* Check if the calls succeeded. */"
+              << "    _pargs_out = (" + args_t + "*)_output_buffer;"
+              << "    _result = _pargs_out->oe_result;"
+              << ""
+              << "done:"
+              << "    if (_buffer)"
+              << "        oe_free_ocall_buffer(_buffer);"
+              << ""
+              << "    return _result;"
+              << "}"
+              << ""
+              << flush_deferred_prototype(edl_) << "{"
+              << "    oe_result_t _result = " + name + "_deliver();"
+              << ""
+              << "    /* Release the buffer of the thread. The next deferred "
+                 "OCALL allocates"
+              << "       a new one. */"
+              << "    oe_free(" + name + "_buffer);"
+              << "    " + name + "_buffer = NULL;"
+              << "    " + name + "_buffer_size = 0;"
+              << "    return _result;"
+              << "}"
+              << ""
+              << "static oe_result_t " + name + "_reserve("
+              << "    uint64_t function_id,"
+              << "    size_t size,"
+              << "    uint8_t** buffer)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << "    " + record_t + "* _record = NULL;"
+              << "    size_t _record_size = 0;"
+              << "    size_t _end = " + name + "_buffer_offset;"
+              << "    size_t _buffer_size = OE_DEFERRED_OCALL_BUFFER_SIZE;"
+              << "    uint8_t* _buffer = NULL;"
+              << ""
+              << "    OE_ADD_SIZE(_record_size, sizeof(*_record));"
+              << "    OE_ADD_SIZE(_record_size, size);"
+              << "    OE_ADD_SIZE(_end, _record_size);"
+              << ""
+              << "    /* Flush the pending records if the new one does not "
+                 "fit. */"
+              << "    if (_end > " + name + "_buffer_size)"
+              << "    {"
+              << "        if ((_result = " + name + "_deliver()) != OE_OK)"
+              << "            goto done;"
+              << "        _end = _record_size;"
+              << "    }"
+              << ""
+              << "    /* Grow the empty buffer for records larger than it. */"
+              << "    if (_end > " + name + "_buffer_size)"
+              << "    {"
+              << "        if (_end > _buffer_size)"
+              << "            _buffer_size = _end;"
+              << "        _buffer = (uint8_t*)oe_malloc(_buffer_size);"
+              << "        if (_buffer == NULL)"
+              << "        {"
+              << "            _result = OE_OUT_OF_MEMORY;"
+              << "            goto done;"
+              << "        }"
+              << "        oe_free(" + name + "_buffer);"
+              << "        " + name + "_buffer = _buffer;"
+              << "        " + name + "_buffer_size = _buffer_size;"
+              << "    }"
+              << ""
+              << "    _record = (" + record_t + "*)(" + name + "_buffer + " +
+                     name + "_buffer_offset);"
+              << "    _record->function_id = function_id;"
+              << "    _record->size = size;"
+              << "    *buffer = (uint8_t*)(_record + 1);"
+              << "    _result = OE_OK;"
+              << ""
+              << "done:"
+              << "    return _result;"
+              << "}"
+              << ""
+              << "static void " + name + "_commit(size_t size)"
+              << "{"
+              << "    /* The size is checked by " + name +
+                     "_reserve and, like all the sizes"
+              << "       computed with OE_ADD_SIZE, keeps the records "
+                 "aligned. */"
+              << "    " + name + "_buffer_offset += sizeof(" + record_t +
+                     ") + size;"
+              << "}"
+              << "";
     }
 
     bool gen_t() const
@@ -328,52 +1100,300 @@ class WEmitter
         }
     }
 
-    void add_size_deep_copy(
-        const std::string& parent_condition,
-        const std::string& parent_expr,
-        const std::string& buffer_size,
-        Decl* parent_prop,
-        int level,
-        std::string indent = "    ")
+    /*
+     * Stream the chunked in parameters to the enclave before the call, or
+     * the chunked out parameters from it after the call.
+     */
+    void stream_chunks(Function* f, bool in)
     {
-        UserType* ut = get_user_type_for_deep_copy(edl_, parent_prop);
-        if (!ut)
-            return;
-        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
-            std::string op = *parent_expr.rbegin() == ']' ? "." : "->";
-            std::string expr = parent_expr + op + prop->name_;
-            std::string prefix = "_args." + parent_expr + op;
-            std::string argcount = pcount(prop, prefix);
-            std::string argsize = psize(prop, prefix);
-            std::string cond = parent_condition + " && " + expr;
-            out() << indent + "if (" + cond + ")"
-                  << indent + "    OE_ADD_ARG_SIZE(" + buffer_size + ", " +
-                         argcount + ", " + argsize + ");";
+        bool empty = true;
+        for (Decl* p : f->params_)
+        {
+            if (!is_chunked(p) || p->attrs_->in_ != in)
+                continue;
+            if (empty)
+                out() << ""
+                      << "    /* Stream the chunked " +
+                             std::string(in ? "in" : "out") +
+                             " parameters. */";
+            out() << "    if (" + p->name_ + ")"
+                  << "    {"
+                  << "        OE_COMPUTE_ARG_SIZE(_chunked_size, " +
+                         pcount(p, "_args.") + ", " + psize(p, "_args.") +
+                         ");"
+                  << "        if ((_result = _" + edl_->name_ +
+                         (in ? "_send_chunks(" : "_receive_chunks(")
+                  << "                 enclave,"
+                  << "                 &_" + p->name_ + "_global_id,"
+                  << "                 " + edl_->name_ + "_fcn_id_" +
+                         f->name_ + "_" + p->name_ + "_chunk,"
+                  << "                 &_args,"
+                  << "                 sizeof(_args),"
+                  << "                 " + p->name_ + ","
+                  << "                 _chunked_size,"
+                  << "                 sizeof(" + chunk_type_str(p) + "),"
+                  << "                 " + chunk_count_str(p) + ")) != OE_OK)"
+                  << "            goto done;";
+            if (in)
+                out() << "        _" + p->name_ +
+                             "_pending = _chunked_size != 0;";
+            out() << "    }";
+            if (in)
+                out() << "    _args." + p->name_ + " = NULL;";
+            empty = false;
+        }
+        if (!empty && !in)
+            out() << "";
+    }
 
-            UserType* ut = get_user_type_for_deep_copy(edl_, prop);
-            if (!ut)
-                return;
+    /*
+     * The function takes the chunked in parameters once it returns. Until
+     * then a failed call aborts the ones that began.
+     */
+    void take_chunks(Function* f)
+    {
+        for (Decl* p : f->params_)
+            if (is_chunked(p) && p->attrs_->in_)
+                out() << "    _" + p->name_ + "_pending = 0;";
+    }
 
-            std::string count = count_attr_str(prop->attrs_->count_, prefix);
+    void abort_chunks(Function* f)
+    {
+        for (Decl* p : f->params_)
+        {
+            if (!is_chunked(p) || !p->attrs_->in_)
+                continue;
+            out() << "    if (_" + p->name_ + "_pending)"
+                  << "        _" + edl_->name_ + "_abort_chunks("
+                  << "            enclave,"
+                  << "            &_" + p->name_ + "_global_id,"
+                  << "            " + edl_->name_ + "_fcn_id_" + f->name_ +
+                         "_" + p->name_ + "_chunk,"
+                  << "            &_args,"
+                  << "            sizeof(_args));";
+        }
+    }
 
-            if (count == "1" || count == "")
-            {
-                add_size_deep_copy(
-                    cond, expr, buffer_size, prop, level + 1, indent);
-            }
+    /*
+     * Emit the host-side helpers that stream a chunked parameter with one
+     * ECALL per chunk. Only the header, the args struct of the function and
+     * one chunk are marshalled at a time, so the enclave never holds the
+     * whole buffer. The first chunk begins the call in the enclave, and a
+     * stream that fails after it aborts the call.
+     */
+    void emit_chunk_helpers()
+    {
+        std::string header_t = edl_->name_ + "_chunk_header_t";
+        std::string info = "_" + edl_->name_ +
+                           "_ecall_info_table[function_id].name,";
+        out() << "static oe_result_t _" + edl_->name_ + "_abort_chunks("
+              << "    oe_enclave_t* enclave,"
+              << "    uint64_t* global_id,"
+              << "    uint32_t function_id,"
+              << "    const void* args,"
+              << "    size_t args_size)"
+              << "{"
+              << "    oe_result_t _result = OE_FAILURE;"
+              << "    " + header_t + " _header;"
+              << "    size_t _header_size = 0;"
+              << "    size_t _buffer_size = 0;"
+              << "    uint8_t* _buffer = NULL;"
+              << "    size_t _output_bytes_written = 0;"
+              << ""
+              << "    OE_ADD_SIZE(_header_size, sizeof(_header));"
+              << "    _buffer_size = _header_size;"
+              << "    OE_ADD_SIZE(_buffer_size, args_size);"
+              << "    _buffer = (uint8_t*)oe_malloc(_buffer_size);"
+              << "    if (_buffer == NULL)"
+              << "    {"
+              << "        _result = OE_OUT_OF_MEMORY;"
+              << "        goto done;"
+              << "    }"
+              << ""
+              << "    memset(&_header, 0, sizeof(_header));"
+              << "    _header.flags = OE_CHUNK_ABORT;"
+              << "    memcpy(_buffer, &_header, sizeof(_header));"
+              << "    memcpy(_buffer + _header_size, args, args_size);"
+              << ""
+              << "    /* Call enclave function. */"
+              << "    if ((_result = oe_call_enclave_function("
+              << "             enclave,"
+              << "             global_id,"
+              << "             " + info
+              << "             _buffer,"
+              << "             _buffer_size,"
+              << "             &_header,"
+              << "             sizeof(_header),"
+              << "             &_output_bytes_written)) != OE_OK)"
+              << "        goto done;"
+              << ""
+              << "    if (_output_bytes_written != sizeof(_header))"
+              << "    {"
+              << "        _result = OE_FAILURE;"
+              << "        goto done;"
+              << "    }"
+              << "    _result = _header.oe_result;"
+              << ""
+              << "done:"
+              << "    if (_buffer)"
+              << "        oe_free(_buffer);"
+              << ""
+              << "    return _result;"
+              << "}"
+              << "";
+        for (bool in : {true, false})
+        {
+            std::string data = in ? "const void* data," : "void* data,";
+            std::string in_size = in ? "_buffer_size" : "_input_size";
+            std::string out_buffer = in ? "&_header" : "_output";
+            std::string out_size = in ? "sizeof(_header)" : "_output_size";
+            out() << "static oe_result_t _" + edl_->name_ +
+                         (in ? "_send_chunks(" : "_receive_chunks(")
+                  << "    oe_enclave_t* enclave,"
+                  << "    uint64_t* global_id,"
+                  << "    uint32_t function_id,"
+                  << "    const void* args,"
+                  << "    size_t args_size,"
+                  << "    " + data
+                  << "    size_t size,"
+                  << "    size_t element_size,"
+                  << "    size_t chunk_count)"
+                  << "{"
+                  << "    oe_result_t _result = OE_FAILURE;"
+                  << "    " + header_t + " _header;"
+                  << "    size_t _header_size = 0;"
+                  << "    size_t _input_size = 0;"
+                  << "    size_t _chunk_size = 0;"
+                  << "    size_t _buffer_size = 0;"
+                  << "    uint8_t* _buffer = NULL;";
+            if (!in)
+                out() << "    uint8_t* _output = NULL;"
+                      << "    size_t _output_size = 0;";
+            out() << "    size_t _offset = 0;"
+                  << "    size_t _count = 0;"
+                  << "    size_t _output_bytes_written = 0;"
+                  << ""
+                  << "    if (size % element_size)"
+                  << "    {"
+                  << "        _result = OE_INVALID_PARAMETER;"
+                  << "        goto done;"
+                  << "    }"
+                  << ""
+                  << "    /* Allocate a buffer for the header, the args struct "
+                     "and the largest"
+                  << "       chunk" +
+                         std::string(in ? "" : ", then the output header") +
+                         ". */"
+                  << "    OE_ADD_SIZE(_header_size, sizeof(_header));"
+                  << "    _input_size = _header_size;"
+                  << "    OE_ADD_SIZE(_input_size, args_size);"
+                  << "    OE_COMPUTE_ARG_SIZE(_chunk_size, chunk_count, "
+                     "element_size);"
+                  << "    _buffer_size = _input_size;";
+            if (!in)
+                out() << "    OE_ADD_SIZE(_buffer_size, _header_size);";
+            out() << "    OE_ADD_SIZE(_buffer_size, _chunk_size);"
+                  << "    _buffer = (uint8_t*)oe_malloc(_buffer_size);"
+                  << "    if (_buffer == NULL)"
+                  << "    {"
+                  << "        _result = OE_OUT_OF_MEMORY;"
+                  << "        goto done;"
+                  << "    }"
+                  << "    memcpy(_buffer + _header_size, args, args_size);";
+            if (!in)
+                out() << "    _output = _buffer + _input_size;";
+            out() << ""
+                  << "    for (_offset = 0; _offset < size / element_size; "
+                     "_offset += _count)"
+                  << "    {"
+                  << "        _count = size / element_size - _offset;"
+                  << "        if (_count > chunk_count)"
+                  << "            _count = chunk_count;";
+            if (in)
+                out() << "        _buffer_size = _input_size;"
+                      << "        OE_ADD_ARG_SIZE(_buffer_size, _count, "
+                         "element_size);";
             else
-            {
-                std::string idx = "_i_" + to_str(level);
-                std::string expr =
-                    parent_expr + op + prop->name_ + "[" + idx + "]";
-                out() << indent + "for (size_t " + idx + " = 0; " + idx +
-                             " < " + count + "; " + idx + "++)"
-                      << indent + "{";
-                add_size_deep_copy(
-                    cond, expr, buffer_size, prop, level + 1, indent + "    ");
-                out() << indent + "}";
-            }
-        });
+                out() << "        _output_size = _header_size;"
+                      << "        OE_ADD_ARG_SIZE(_output_size, _count, "
+                         "element_size);";
+            out() << ""
+                  << "        memset(&_header, 0, sizeof(_header));"
+                  << "        _header.offset = _offset;"
+                  << "        _header.count = _count;"
+                  << "        _header.flags = _offset ? 0 : OE_CHUNK_BEGIN;"
+                  << "        memcpy(_buffer, &_header, sizeof(_header));";
+            if (in)
+                out() << "        memcpy("
+                      << "            _buffer + _input_size,"
+                      << "            (const uint8_t*)data + _offset * "
+                         "element_size,"
+                      << "            _count * element_size);";
+            out() << ""
+                  << "        /* Call enclave function. */"
+                  << "        if ((_result = oe_call_enclave_function("
+                  << "                 enclave,"
+                  << "                 global_id,"
+                  << "                 " + info
+                  << "                 _buffer,"
+                  << "                 " + in_size + ","
+                  << "                 " + out_buffer + ","
+                  << "                 " + out_size + ","
+                  << "                 &_output_bytes_written)) != OE_OK)"
+                  << "            goto done;"
+                  << ""
+                  << "        if (_output_bytes_written != " + out_size + ")"
+                  << "        {"
+                  << "            _result = OE_FAILURE;"
+                  << "            goto done;"
+                  << "        }";
+            if (in)
+                out() << "        if ((_result = _header.oe_result) != OE_OK)"
+                      << "            goto done;";
+            else
+                out() << "        if ((_result = ((" + header_t +
+                             "*)_output)->oe_result) != OE_OK)"
+                      << "            goto done;"
+                      << ""
+                      << "        memcpy("
+                      << "            (uint8_t*)data + _offset * "
+                         "element_size,"
+                      << "            _output + _header_size,"
+                      << "            _count * element_size);";
+            out() << "    }"
+                  << ""
+                  << "    _result = OE_OK;"
+                  << ""
+                  << "done:"
+                  << "    /* The first chunk began the call. */"
+                  << "    if (_result != OE_OK && _count)"
+                  << "        _" + edl_->name_ +
+                         "_abort_chunks(enclave, global_id, function_id, "
+                         "args, args_size);"
+                  << "    if (_buffer)"
+                  << "        oe_free(_buffer);"
+                  << ""
+                  << "    return _result;"
+                  << "}"
+                  << "";
+        }
+    }
+
+    void check_host_memory_params(Function* f)
+    {
+        bool empty = true;
+        for (Decl* p : f->params_)
+        {
+            if (!is_host_memory(p))
+                continue;
+            if (empty)
+                out() << ""
+                      << "    /* Host memory parameters are passed as is. */";
+            out() << "    OE_CHECK_HOST_MEMORY_PARAM(" + p->name_ + ", " +
+                         pcount(p, "_args.") + ", " + psize(p, "_args.") +
+                         ");";
+            empty = false;
+        }
     }
 
     void compute_buffer_size(Function* f, bool input)
@@ -383,7 +1403,7 @@ class WEmitter
         out() << "    OE_ADD_SIZE(" + buffer_size + ", sizeof(" + f->name_ +
                      "_args_t));";
         bool empty = true;
-        for (Decl* p : f->params_)
+        for (Decl* p : input ? f->params_ : output_params(f))
         {
             if (!p->attrs_)
                 continue;
@@ -392,11 +1412,20 @@ class WEmitter
                 !(input ? p->attrs_->in_ : p->attrs_->out_))
                 continue;
 
+            /* Inline parameters are stored in the marshalling struct. */
+            if (is_host_memory(p) || is_chunked(p) || inline_param(p))
+                continue;
+
+            /* In-place in-out parameters only occupy the output buffer. */
+            if (input && in_place(p))
+                continue;
+
             std::string argcount = pcount(p, "_args.");
             std::string argsize = psize(p, "_args.");
+            align_offset(p, buffer_size);
             out() << "    if (" + p->name_ + ")"
-                  << "        OE_ADD_ARG_SIZE(" + buffer_size + ", " +
-                         argcount + ", " + argsize + ");";
+                  << "        " + macro(p, "OE_ADD_ARG_SIZE") + "(" +
+                         buffer_size + ", " + argcount + ", " + argsize + ");";
             empty = false;
 
             /* Skip the nested pointers if the parameter is not
@@ -406,85 +1435,77 @@ class WEmitter
                 continue;
 
             std::string count = count_attr_str(p->attrs_->count_, "_args.");
-
-            if (count == "1" || count == "")
-            {
-                std::string cond = p->name_;
-                std::string expr = p->name_;
-                add_size_deep_copy(cond, expr, buffer_size, p, 2, "    ");
-            }
-            else
-            {
-                std::string cond = p->name_;
-                std::string expr = p->name_ + "[_i_1]";
-                out() << "    for (size_t _i_1 = 0; _i_1 < " + count +
-                             "; _i_1++)"
-                      << "    {";
-                add_size_deep_copy(cond, expr, buffer_size, p, 2, "        ");
-                out() << "    }";
-            }
+            out() << "    if (" + p->name_ + ")"
+                  << "    {"
+                  << deepcopy_helper_call(
+                         "        ",
+                         deepcopy_helper_name("size", ut),
+                         {p->name_,
+                          count == "" ? "1" : count,
+                          "&" + buffer_size})
+                  << "    }";
         }
         if (empty)
             out() << "    /* There were no corresponding parameters. */";
+
+        /* The compact layout leaves the buffer sizes unrounded. */
+        if (options_.compact_layout_)
+            out() << "    OE_ALIGN_SIZE_COMPACT(" + buffer_size +
+                         ", OE_EDGER8R_BUFFER_ALIGNMENT);";
+
+        /* The output buffer follows the input buffer, so it is aligned by
+         * padding the input buffer when it holds aligned parameters. */
+        bool aligned_outputs = false;
+        for (Decl* p : f->params_)
+            if (!param_align_str(p).empty() &&
+                (p->attrs_->out_ || p->attrs_->inout_))
+                aligned_outputs = true;
+        if (input && aligned_outputs)
+            out() << "    OE_ALIGN_SIZE(" + buffer_size + ", " +
+                         buffer_align_str(f) + ");";
     }
 
-    void compute_input_buffer_size(Function* f)
+    /* Pad the offset to the alignment of the parameter. */
+    void align_offset(Decl* p, const std::string& offset)
     {
-        compute_buffer_size(f, true);
+        std::string align = align_offset_str(edl_, options_, p, offset);
+        if (!align.empty())
+            out() << "    " + align;
     }
 
-    void compute_output_buffer_size(Function* f)
+    /* The variant of a marshalling macro for the layout of a parameter. */
+    std::string macro(Decl* p, const std::string& name)
     {
-        compute_buffer_size(f, false);
+        return layout_macro(edl_, options_, p, name);
     }
 
-    void serialize_pointers_deep_copy(
-        const std::string& parent_condition,
-        const std::string& parent_expr,
-        const std::string& cmd,
-        Decl* parent_prop,
-        int level,
-        std::string indent = "    ")
+    /*
+     * The parameters in the order of the output buffer. In-place in-out
+     * parameters lead it and variable-length out parameters end it.
+     */
+    std::vector<Decl*> output_params(Function* f)
     {
-        UserType* ut = get_user_type_for_deep_copy(edl_, parent_prop);
-        if (!ut)
-            return;
-        iterate_deep_copyable_fields(ut, [&](Decl* prop) {
-            std::string op = *parent_expr.rbegin() == ']' ? "." : "->";
-            std::string expr = parent_expr + op + prop->name_;
-            std::string prefix = "_args." + parent_expr + op;
-            std::string argcount = pcount(prop, prefix);
-            std::string argsize = psize(prop, prefix);
-            std::string cond = parent_condition + " && " + expr;
-            std::string mt = mtype_str(prop);
-            out() << indent + "if (" + cond + ")"
-                  << indent + "    " + cmd + "(" + expr + ", " + argcount +
-                         ", " + argsize + ", " + mt + ");";
-
-            UserType* ut = get_user_type_for_deep_copy(edl_, prop);
-            if (!ut)
-                return;
+        std::vector<Decl*> params;
+        for (Decl* p : f->params_)
+            if (in_place(p))
+                params.push_back(p);
+        for (Decl* p : f->params_)
+            if (!in_place(p) && !is_variable_length(p))
+                params.push_back(p);
+        for (Decl* p : f->params_)
+            if (is_variable_length(p))
+                params.push_back(p);
+        return params;
+    }
 
-            std::string count = count_attr_str(prop->attrs_->count_, prefix);
+    void compute_input_buffer_size(Function* f)
+    {
+        compute_buffer_size(f, true);
+    }
 
-            if (count == "1" || count == "")
-            {
-                serialize_pointers_deep_copy(
-                    cond, expr, cmd, prop, level + 1, indent);
-            }
-            else
-            {
-                std::string idx = "_i_" + to_str(level);
-                std::string expr =
-                    parent_expr + op + prop->name_ + "[" + idx + "]";
-                out() << indent + "for (size_t " + idx + " = 0; " + idx +
-                             " < " + count + "; " + idx + "++)"
-                      << indent + "{";
-                serialize_pointers_deep_copy(
-                    cond, expr, cmd, prop, level + 1, indent + "    ");
-                out() << indent + "}";
-            }
-        });
+    void compute_output_buffer_size(Function* f)
+    {
+        compute_buffer_size(f, false);
     }
 
     void serialize_buffer_inputs(Function* f)
@@ -494,7 +1515,16 @@ class WEmitter
         bool empty = true;
         for (Decl* p : f->params_)
         {
-            if (p->attrs_ && (p->attrs_->in_ || p->attrs_->inout_))
+            if (in_place(p) || is_host_memory(p) || is_chunked(p))
+                continue;
+            if (p->attrs_ && (p->attrs_->in_ || p->attrs_->inout_) &&
+                inline_param(p))
+            {
+                out() << "    OE_WRITE_INLINE_PARAM(" + p->name_ + ", " +
+                             mtype_str(p) + ");";
+                empty = false;
+            }
+            else if (p->attrs_ && (p->attrs_->in_ || p->attrs_->inout_))
             {
                 std::string mt = mtype_str(p);
                 std::string argcount = pcount(p, "_args.");
@@ -506,7 +1536,9 @@ class WEmitter
                  * OE_WRITE_IN_PARAM_WITH_BARRIER in the enclave code */
                 if (gen_t())
                     cmd += "_WITH_BARRIER";
+                cmd = macro(p, cmd);
 
+                align_offset(p, "_input_buffer_offset");
                 out() << "    if (" + p->name_ + ")"
                       << "        " + cmd + "(" + p->name_ + ", " + argcount +
                              ", " + argsize + ", " + mt + ");";
@@ -517,28 +1549,57 @@ class WEmitter
                     continue;
 
                 std::string count = count_attr_str(p->attrs_->count_, "_args.");
-
-                if (count == "1" || count == "")
-                {
-                    std::string cond = p->name_;
-                    std::string expr = p->name_;
-                    serialize_pointers_deep_copy(cond, expr, cmd, p, 2, "    ");
-                }
-                else
-                {
-                    std::string cond = p->name_;
-                    std::string expr = p->name_ + "[_i_1]";
-                    out() << "    for (size_t _i_1 = 0; _i_1 < " + count +
-                                 "; _i_1++)"
-                          << "    {";
-                    serialize_pointers_deep_copy(
-                        cond, expr, cmd, p, 2, "        ");
-                    out() << "    }";
-                }
+                out() << "    if (" + p->name_ + ")"
+                      << "    {"
+                      << deepcopy_helper_call(
+                             "        ",
+                             deepcopy_helper_name("serialize", ut),
+                             {"_args." + p->name_,
+                              p->name_,
+                              count == "" ? "1" : count,
+                              "_input_buffer",
+                              "&_input_buffer_offset"})
+                      << "    }";
             }
         }
         if (empty)
             out() << "    /* There were no in nor in-out parameters. */";
+        serialize_in_place_params(f);
+    }
+
+    bool in_place(Decl* p)
+    {
+        return is_in_place_in_out(edl_, options_, ecall_, p);
+    }
+
+    bool inline_param(Decl* p)
+    {
+        return is_inline_param(edl_, options_, p);
+    }
+
+    void serialize_in_place_params(Function* f)
+    {
+        bool empty = true;
+        for (Decl* p : f->params_)
+        {
+            if (!in_place(p))
+                continue;
+            if (empty)
+                out() << ""
+                      << "    /* Serialize in-place in-out parameters. They "
+                         "lead the output buffer. */"
+                      << "    OE_ADD_SIZE(_output_buffer_offset, "
+                         "sizeof(*_pargs_out));";
+            align_offset(p, "_output_buffer_offset");
+            out() << "    if (" + p->name_ + ")"
+                  << "        " +
+                         macro(p, "OE_WRITE_IN_PLACE_PARAM_WITH_BARRIER") +
+                         "(" + p->name_ + ", " + pcount(p, "_args.") + ", " +
+                         psize(p, "_args.") + ", " + mtype_str(p) + ");";
+            empty = false;
+        }
+        if (!empty)
+            out() << "    _output_buffer_offset = 0;";
     }
 
     void unmarshal_deep_copy(
@@ -692,7 +1753,9 @@ class WEmitter
 
     void unmarshal_deep_copy_out(Decl* p)
     {
-        std::string cmd = "OE_SET_DEEPCOPY_OUT_PARAM";
+        std::string cmd = options_.deepcopy_out_arena_
+                              ? "OE_SET_DEEPCOPY_OUT_ARENA_PARAM"
+                              : "OE_SET_DEEPCOPY_OUT_PARAM";
         std::string count = count_attr_str(p->attrs_->count_);
         std::string mt = mtype_str(p);
 
@@ -717,15 +1780,39 @@ class WEmitter
     {
         std::string check = "OE_CHECK_NULL_TERMINATOR";
         bool empty = true;
-        for (Decl* p : f->params_)
+        for (Decl* p : output_params(f))
         {
+            if (is_host_memory(p) || is_chunked(p))
+                continue;
+            if (p->attrs_ && (p->attrs_->out_ || p->attrs_->inout_) &&
+                !inline_param(p))
+                align_offset(p, "_output_buffer_offset");
+            if (is_variable_length(p))
+            {
+                empty = false;
+                out() << "    " + macro(p, "OE_READ_OUT_PARAM_LENGTH") + "("
+                      << "        " + p->name_ + ","
+                      << "        " + length_value_str(p, "") + ","
+                      << "        " + length_capacity_str(p, "_args.") + ","
+                      << "        " + length_unit_str(p, "_args.") + ");";
+                continue;
+            }
+            if (p->attrs_ && (p->attrs_->out_ || p->attrs_->inout_) &&
+                inline_param(p))
+            {
+                empty = false;
+                out() << "    OE_READ_INLINE_PARAM(" + p->name_ + ");";
+                continue;
+            }
             if (p->attrs_ && (p->attrs_->out_ || p->attrs_->inout_))
             {
                 empty = false;
                 std::string argcount = pcount(p, "_args.");
                 std::string argsize = psize(p, "_args.");
-                std::string cmd = p->attrs_->inout_ ? "OE_READ_IN_OUT_PARAM"
-                                                    : "OE_READ_OUT_PARAM";
+                std::string cmd = macro(
+                    p,
+                    p->attrs_->inout_ ? "OE_READ_IN_OUT_PARAM"
+                                      : "OE_READ_OUT_PARAM");
                 UserType* ut = get_user_type_for_deep_copy(edl_, p);
                 if (!ut)
                 {
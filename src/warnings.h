@@ -10,6 +10,11 @@ enum class Warning
     Error,
     ForeignTypePtr,
     NonPortableType,
+    PerfDeepCopyDepth,
+    PerfInOut,
+    PerfLargeByValue,
+    PerfSmallPtrParams,
+    PerfUnboundedString,
     PtrInStruct,
     PtrInFunction,
     ReturnPtr,
@@ -18,6 +23,15 @@ enum class Warning
     Unknown
 };
 
+/* The -Wperf-* warnings flag costly EDL patterns and are not enabled by -Wall.
+ */
+inline bool is_perf_warning(Warning w)
+{
+    return w == Warning::PerfDeepCopyDepth || w == Warning::PerfInOut ||
+           w == Warning::PerfLargeByValue || w == Warning::PerfSmallPtrParams ||
+           w == Warning::PerfUnboundedString;
+}
+
 /* A bug with C++11 prevents an enum class directly be used as a key in
  * an unordered_map. As a workaround, we have to provide a customized hash
  * function as a third argument to the unordered_map. Note that the bug
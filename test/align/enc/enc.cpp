@@ -0,0 +1,62 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include <string.h>
+#include "align_t.h"
+
+static bool aligned(const void* p, uint64_t align)
+{
+    return (uint64_t)p % align == 0;
+}
+
+double enc_sum(
+    const uint8_t* odd,
+    const double* values,
+    size_t n,
+    const uint8_t* page,
+    size_t page_size)
+{
+    OE_TEST(odd[0] == 1 && odd[2] == 3);
+    OE_TEST(aligned(values, 64));
+    OE_TEST(aligned(page, 4096));
+    OE_TEST(page_size == 100 && page[99] == 99);
+
+    double sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += values[i];
+    return sum;
+}
+
+void enc_fill(uint8_t* odd, double* values, uint32_t* counters, size_t n)
+{
+    OE_TEST(aligned(values, 64));
+    OE_TEST(aligned(counters, 256));
+
+    memset(odd, 7, 5);
+    for (size_t i = 0; i < n; i++)
+    {
+        values[i] = (double)i / 2;
+        counters[i]++;
+    }
+}
+
+void enc_run_ocalls()
+{
+    uint8_t odd = 1;
+    float in[10];
+    float out[10];
+    uint8_t buf[1000];
+    size_t produced = 0;
+
+    for (size_t i = 0; i < 10; i++)
+        in[i] = (float)i;
+    memset(buf, 0, sizeof(buf));
+    OE_TEST(
+        ocall_scale(&odd, in, out, 10, buf, sizeof(buf), &produced) == OE_OK);
+    for (size_t i = 0; i < 10; i++)
+        OE_TEST(out[i] == 2 * in[i]);
+    OE_TEST(produced == 20);
+    for (size_t i = 0; i < sizeof(buf); i++)
+        OE_TEST(buf[i] == (i < 20 ? 0x33 : 0));
+}
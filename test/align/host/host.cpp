@@ -0,0 +1,95 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include "align_u.h"
+
+static oe_enclave_t* enclave;
+
+static bool aligned(const void* p, uint64_t align)
+{
+    return (uint64_t)p % align == 0;
+}
+
+void ocall_scale(
+    const uint8_t* odd,
+    const float* in,
+    float* out,
+    size_t n,
+    uint8_t* buf,
+    size_t cap,
+    size_t* produced)
+{
+    OE_TEST(*odd == 1);
+    OE_TEST(aligned(in, 128));
+    OE_TEST(aligned(out, 64));
+    OE_TEST(aligned(buf, 512));
+
+    for (size_t i = 0; i < n; i++)
+        out[i] = 2 * in[i];
+    memset(buf, 0x33, cap);
+    *produced = 20;
+}
+
+static void test_sum()
+{
+    uint8_t odd[3] = {1, 2, 3};
+    double values[33];
+    uint8_t page[100];
+    double expected = 0;
+
+    for (size_t i = 0; i < 33; i++)
+        expected += values[i] = (double)i * 1.5;
+    for (size_t i = 0; i < sizeof(page); i++)
+        page[i] = (uint8_t)i;
+
+    double sum = 0;
+    OE_TEST(
+        enc_sum(enclave, &sum, odd, values, 33, page, sizeof(page)) == OE_OK);
+    OE_TEST(sum == expected);
+}
+
+static void test_fill()
+{
+    uint8_t odd[5] = {0};
+    double values[7];
+    uint32_t counters[7];
+
+    for (uint32_t i = 0; i < 7; i++)
+        counters[i] = i;
+    OE_TEST(enc_fill(enclave, odd, values, counters, 7) == OE_OK);
+    for (uint32_t i = 0; i < 7; i++)
+    {
+        OE_TEST(values[i] == (double)i / 2);
+        OE_TEST(counters[i] == i + 1);
+    }
+    OE_TEST(odd[0] == 7 && odd[4] == 7);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_align_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    test_sum();
+    test_fill();
+    OE_TEST(enc_run_ocalls(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (align)\n");
+
+    return 0;
+}
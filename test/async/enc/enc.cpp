@@ -0,0 +1,22 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "async_t.h"
+
+int enc_square(int x)
+{
+    return x * x;
+}
+
+void enc_fill(uint64_t* buf, size_t count, uint64_t value)
+{
+    for (size_t i = 0; i < count; i++)
+        buf[i] = value + i;
+}
+
+void enc_wait(int* flag)
+{
+    while (!__atomic_load_n(flag, __ATOMIC_ACQUIRE))
+        ;
+}
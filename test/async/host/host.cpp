@@ -0,0 +1,65 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+
+#include <openenclave/internal/tests.h>
+#include "async_u.h"
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_async_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    /* The caller keeps running while the call is in flight. */
+    {
+        int flag = 0;
+        oe_call_handle_t handle = enc_wait_async(enclave, &flag);
+        OE_TEST(handle != NULL);
+        OE_TEST(oe_call_poll(handle) == OE_BUSY);
+        __atomic_store_n(&flag, 1, __ATOMIC_RELEASE);
+        OE_TEST(oe_call_wait(handle) == OE_OK);
+    }
+
+    /* Several calls can be in flight at the same time. */
+    {
+        int squares[16];
+        oe_call_handle_t handles[16];
+        for (int i = 0; i < 16; i++)
+        {
+            handles[i] = enc_square_async(enclave, &squares[i], i);
+            OE_TEST(handles[i] != NULL);
+        }
+        for (int i = 0; i < 16; i++)
+        {
+            OE_TEST(oe_call_wait(handles[i]) == OE_OK);
+            OE_TEST(squares[i] == i * i);
+        }
+    }
+
+    /* Out parameters are written once the call completes. */
+    {
+        uint64_t buf[32];
+        oe_call_handle_t handle = enc_fill_async(enclave, buf, 32, 7);
+        OE_TEST(handle != NULL);
+        OE_TEST(oe_call_wait(handle) == OE_OK);
+        OE_TEST(oe_call_poll(NULL) == OE_INVALID_PARAMETER);
+        for (uint64_t i = 0; i < 32; i++)
+            OE_TEST(buf[i] == 7 + i);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (async)\n");
+}
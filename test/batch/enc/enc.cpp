@@ -0,0 +1,28 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "batch_t.h"
+
+static size_t _ticks;
+
+uint64_t enc_add(uint64_t a, uint64_t b)
+{
+    return a + b;
+}
+
+void enc_tick(void)
+{
+    _ticks++;
+}
+
+int enc_store(int* p, int value)
+{
+    *p = value;
+    return value * 2;
+}
+
+size_t enc_get_ticks(void)
+{
+    return _ticks;
+}
@@ -0,0 +1,92 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+
+#include <openenclave/internal/tests.h>
+#include "batch_u.h"
+
+void host_unused(int value)
+{
+    OE_UNUSED(value);
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_batch_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    /* Every call of the batch gets its own arguments and return value. */
+    {
+        enc_add_batch_args_t calls[64];
+        oe_result_t results[64];
+        for (uint64_t i = 0; i < 64; i++)
+        {
+            calls[i].a = i;
+            calls[i].b = 1000 * i;
+            calls[i].oe_retval = 0;
+            results[i] = OE_FAILURE;
+        }
+        OE_TEST(enc_add_batch(enclave, 64, calls, results) == OE_OK);
+        for (uint64_t i = 0; i < 64; i++)
+        {
+            OE_TEST(results[i] == OE_OK);
+            OE_TEST(calls[i].oe_retval == 1001 * i);
+        }
+    }
+
+    /* A batch without parameters or return value. */
+    {
+        enc_tick_batch_args_t calls[10];
+        oe_result_t results[10];
+        OE_TEST(enc_tick_batch(enclave, 10, calls, results) == OE_OK);
+        for (size_t i = 0; i < 10; i++)
+            OE_TEST(results[i] == OE_OK);
+
+        size_t ticks = 0;
+        OE_TEST(enc_get_ticks(enclave, &ticks) == OE_OK);
+        OE_TEST(ticks == 10);
+
+        /* The regular ECALL is still available. */
+        OE_TEST(enc_tick(enclave) == OE_OK);
+        OE_TEST(enc_get_ticks(enclave, &ticks) == OE_OK);
+        OE_TEST(ticks == 11);
+    }
+
+    /* user_check pointers are passed through as values. */
+    {
+        int values[4] = {0};
+        enc_store_batch_args_t calls[4];
+        oe_result_t results[4];
+        for (int i = 0; i < 4; i++)
+        {
+            calls[i].p = &values[i];
+            calls[i].value = i + 1;
+        }
+        OE_TEST(enc_store_batch(enclave, 4, calls, results) == OE_OK);
+        for (int i = 0; i < 4; i++)
+        {
+            OE_TEST(results[i] == OE_OK);
+            OE_TEST(calls[i].oe_retval == 2 * (i + 1));
+            OE_TEST(values[i] == i + 1);
+        }
+    }
+
+    /* An empty batch is a single transition that makes no calls. */
+    OE_TEST(enc_add_batch(enclave, 0, NULL, NULL) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (batch)\n");
+}
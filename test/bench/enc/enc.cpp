@@ -0,0 +1,117 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include <chrono>
+#include <vector>
+#include "bench_t.h"
+
+int ecall_scalars(int a, uint64_t b, double c)
+{
+    return a + (int)b + (int)c;
+}
+
+void ecall_in(const uint8_t* buf, size_t size)
+{
+    OE_UNUSED(buf);
+    OE_UNUSED(size);
+}
+
+void ecall_out(uint8_t* buf, size_t size)
+{
+    OE_UNUSED(buf);
+    OE_UNUSED(size);
+}
+
+void ecall_in_out(uint8_t* buf, size_t size)
+{
+    OE_UNUSED(buf);
+    OE_UNUSED(size);
+}
+
+size_t ecall_string(const char* str)
+{
+    return str[0] ? 1 : 0;
+}
+
+size_t ecall_wstring(const wchar_t* str)
+{
+    return str[0] ? 1 : 0;
+}
+
+uint64_t ecall_array(uint64_t matrix[32][32])
+{
+    return matrix[31][31];
+}
+
+uint64_t ecall_deepcopy1(Leaf* leaf)
+{
+    return leaf->count;
+}
+
+uint64_t ecall_deepcopy2(Branch* branch)
+{
+    return branch->count;
+}
+
+uint64_t ecall_deepcopy3(Tree* tree)
+{
+    return tree->count;
+}
+
+int ecall_switchless(int a)
+{
+    return a;
+}
+
+static void call_ocall(ocall_kind kind, uint8_t* buf, size_t size)
+{
+    int ret = 0;
+    size_t len = 0;
+
+    switch (kind)
+    {
+        case OCALL_SCALARS:
+            OE_TEST(ocall_scalars(&ret, 1, 2, 3.0) == OE_OK);
+            break;
+        case OCALL_IN:
+            OE_TEST(ocall_in(buf, size) == OE_OK);
+            break;
+        case OCALL_OUT:
+            OE_TEST(ocall_out(buf, size) == OE_OK);
+            break;
+        case OCALL_IN_OUT:
+            OE_TEST(ocall_in_out(buf, size) == OE_OK);
+            break;
+        case OCALL_STRING:
+            OE_TEST(ocall_string(&len, (const char*)buf) == OE_OK);
+            break;
+        case OCALL_ERRNO:
+            OE_TEST(ocall_errno(&ret, 1) == OE_OK);
+            break;
+        case OCALL_SWITCHLESS:
+            OE_TEST(ocall_switchless(&ret, 1) == OE_OK);
+            break;
+    }
+}
+
+void ecall_run_ocalls(
+    ocall_kind kind,
+    size_t size,
+    size_t iterations,
+    uint64_t* latencies)
+{
+    /* The string OCALL sends size - 1 characters. */
+    std::vector<uint8_t> buf(size ? size : 1, 'a');
+    buf.back() = 0;
+
+    for (size_t i = 0; i < iterations; i++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        call_ocall(kind, buf.data(), size);
+        auto end = std::chrono::steady_clock::now();
+        latencies[i] = (uint64_t)std::chrono::duration_cast<
+                           std::chrono::nanoseconds>(end - start)
+                           .count();
+    }
+}
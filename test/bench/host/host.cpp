@@ -0,0 +1,450 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bench_u.h"
+
+/*
+ * Measures the latency and throughput of ECALLs and OCALLs of various
+ * shapes in virtual mode and writes the results as JSON:
+ *
+ *     oeedger8r_bench_host ENCLAVE_PATH [--quick] [--iterations N]
+ *                          [--threads N] [--output FILE]
+ *
+ * With --threads N, each case is run by 1, 2, 4, ... and N threads at once,
+ * which gives the throughput curve of the case up to N threads. Every thread
+ * makes the same number of calls, and calls_per_sec counts the calls of all
+ * of them.
+ *
+ * bytes_per_call is the size of the data the parameters point to, which
+ * the generated code copies at least once in each direction it travels, and
+ * bytes_pointed_to is its total over the calls. Neither counts the copies
+ * that the marshalling makes: the arg structs, the padding and the copies
+ * made by the runtime.
+ */
+
+#define LEAF_COUNT 16
+#define BRANCH_COUNT 4
+#define TREE_COUNT 4
+
+struct Result
+{
+    std::string name;
+    size_t threads;
+    size_t calls;
+    uint64_t p50_ns;
+    uint64_t p99_ns;
+    double calls_per_sec;
+    uint64_t bytes_per_call;
+};
+
+static oe_enclave_t* enclave;
+static std::vector<Result> results;
+static size_t iterations = 10000;
+static std::vector<size_t> thread_counts = {1};
+
+int ocall_scalars(int a, uint64_t b, double c)
+{
+    return a + (int)b + (int)c;
+}
+
+void ocall_in(const uint8_t* buf, size_t size)
+{
+    OE_UNUSED(buf);
+    OE_UNUSED(size);
+}
+
+void ocall_out(uint8_t* buf, size_t size)
+{
+    OE_UNUSED(buf);
+    OE_UNUSED(size);
+}
+
+void ocall_in_out(uint8_t* buf, size_t size)
+{
+    OE_UNUSED(buf);
+    OE_UNUSED(size);
+}
+
+size_t ocall_string(const char* str)
+{
+    return str[0] ? 1 : 0;
+}
+
+int ocall_errno(int a)
+{
+    errno = a;
+    return -1;
+}
+
+int ocall_switchless(int a)
+{
+    return a;
+}
+
+static uint64_t elapsed_ns(
+    std::chrono::steady_clock::time_point start,
+    std::chrono::steady_clock::time_point end)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               end - start)
+        .count();
+}
+
+/* Large buffers get fewer calls so that each case copies at most 1 GiB. */
+static size_t iterations_for(uint64_t bytes_per_call)
+{
+    size_t n = iterations;
+    if (bytes_per_call && n > (1ULL << 30) / bytes_per_call)
+        n = std::max<size_t>(10, (size_t)((1ULL << 30) / bytes_per_call));
+    return n;
+}
+
+static void report(
+    const std::string& name,
+    size_t threads,
+    uint64_t bytes_per_call,
+    std::vector<uint64_t>& latencies,
+    uint64_t total_ns)
+{
+    std::sort(latencies.begin(), latencies.end());
+    Result r;
+    r.name = name;
+    r.threads = threads;
+    r.calls = latencies.size();
+    r.p50_ns = latencies[latencies.size() / 2];
+    r.p99_ns = latencies[(latencies.size() * 99) / 100];
+    r.calls_per_sec = total_ns ? r.calls * 1e9 / (double)total_ns : 0;
+    r.bytes_per_call = bytes_per_call;
+    results.push_back(r);
+    fprintf(
+        stderr,
+        "%-28s %3zu threads  p50 %10llu ns  p99 %10llu ns  %12.0f calls/s\n",
+        name.c_str(),
+        threads,
+        (unsigned long long)r.p50_ns,
+        (unsigned long long)r.p99_ns,
+        r.calls_per_sec);
+}
+
+/*
+ * Run the case on each number of threads. Each thread warms up, then runs
+ * iterations of the case, which fills the latencies of the thread. The
+ * throughput is taken over the span from the first thread starting its
+ * timed run to the last one finishing it.
+ */
+template <typename Run>
+static void bench_threads(
+    const std::string& name,
+    uint64_t bytes_per_call,
+    Run&& run)
+{
+    for (size_t threads : thread_counts)
+    {
+        size_t n = iterations_for(bytes_per_call * threads);
+        std::vector<std::vector<uint64_t>> latencies(
+            threads, std::vector<uint64_t>(n));
+        std::vector<std::chrono::steady_clock::time_point> begins(threads);
+        std::vector<std::chrono::steady_clock::time_point> ends(threads);
+
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; t++)
+            workers.emplace_back([&, t] {
+                run(latencies[t], begins[t], ends[t]);
+            });
+        for (std::thread& worker : workers)
+            worker.join();
+
+        std::vector<uint64_t> all;
+        for (const std::vector<uint64_t>& l : latencies)
+            all.insert(all.end(), l.begin(), l.end());
+        report(
+            name,
+            threads,
+            bytes_per_call,
+            all,
+            elapsed_ns(
+                *std::min_element(begins.begin(), begins.end()),
+                *std::max_element(ends.begin(), ends.end())));
+    }
+}
+
+/*
+ * make_call returns the call of one thread, so that the calls that write to
+ * a buffer each get their own.
+ */
+template <typename MakeCall>
+static void bench_ecall(
+    const std::string& name,
+    uint64_t bytes_per_call,
+    MakeCall&& make_call)
+{
+    bench_threads(
+        name,
+        bytes_per_call,
+        [&](std::vector<uint64_t>& latencies,
+            std::chrono::steady_clock::time_point& begin,
+            std::chrono::steady_clock::time_point& end) {
+            auto call = make_call();
+            for (size_t i = 0; i < latencies.size() / 10 + 1; i++)
+                call();
+
+            begin = std::chrono::steady_clock::now();
+            for (uint64_t& latency : latencies)
+            {
+                auto start = std::chrono::steady_clock::now();
+                call();
+                latency = elapsed_ns(start, std::chrono::steady_clock::now());
+            }
+            end = std::chrono::steady_clock::now();
+        });
+}
+
+/* The enclave times the OCALLs and returns the latencies. */
+static void bench_ocall(
+    const std::string& name,
+    ocall_kind kind,
+    size_t size,
+    uint64_t bytes_per_call)
+{
+    bench_threads(
+        name,
+        bytes_per_call,
+        [&](std::vector<uint64_t>& latencies,
+            std::chrono::steady_clock::time_point& begin,
+            std::chrono::steady_clock::time_point& end) {
+            OE_TEST(
+                ecall_run_ocalls(
+                    enclave,
+                    kind,
+                    size,
+                    latencies.size() / 10 + 1,
+                    latencies.data()) == OE_OK);
+
+            begin = std::chrono::steady_clock::now();
+            OE_TEST(
+                ecall_run_ocalls(
+                    enclave,
+                    kind,
+                    size,
+                    latencies.size(),
+                    latencies.data()) == OE_OK);
+            end = std::chrono::steady_clock::now();
+        });
+}
+
+static void bench_ecalls(const std::vector<size_t>& sizes)
+{
+    bench_ecall("ecall_scalars", 0, [] {
+        return [] {
+            int ret = 0;
+            OE_TEST(ecall_scalars(enclave, &ret, 1, 2, 3.0) == OE_OK);
+        };
+    });
+
+    for (size_t size : sizes)
+    {
+        std::string suffix = "_" + std::to_string(size);
+        const std::vector<uint8_t> in(size, 1);
+        bench_ecall("ecall_in" + suffix, size, [&] {
+            return [&] {
+                OE_TEST(ecall_in(enclave, in.data(), size) == OE_OK);
+            };
+        });
+        bench_ecall("ecall_out" + suffix, size, [&] {
+            return [buf = std::vector<uint8_t>(size, 1), size]() mutable {
+                OE_TEST(ecall_out(enclave, buf.data(), size) == OE_OK);
+            };
+        });
+        bench_ecall("ecall_in_out" + suffix, 2 * size, [&] {
+            return [buf = std::vector<uint8_t>(size, 1), size]() mutable {
+                OE_TEST(ecall_in_out(enclave, buf.data(), size) == OE_OK);
+            };
+        });
+    }
+
+    for (size_t size : sizes)
+    {
+        std::string str(size - 1, 'a');
+        std::wstring wstr(size / sizeof(wchar_t) - 1, L'a');
+        std::string suffix = "_" + std::to_string(size);
+        bench_ecall("ecall_string" + suffix, size, [&] {
+            return [&] {
+                size_t len = 0;
+                OE_TEST(ecall_string(enclave, &len, str.c_str()) == OE_OK);
+            };
+        });
+        bench_ecall("ecall_wstring" + suffix, size, [&] {
+            return [&] {
+                size_t len = 0;
+                OE_TEST(ecall_wstring(enclave, &len, wstr.c_str()) == OE_OK);
+            };
+        });
+    }
+
+    {
+        uint64_t matrix[32][32] = {{0}};
+        bench_ecall("ecall_array_32x32", sizeof(matrix), [&] {
+            return [&] {
+                uint64_t ret = 0;
+                OE_TEST(ecall_array(enclave, &ret, matrix) == OE_OK);
+            };
+        });
+    }
+
+    {
+        std::vector<uint64_t> data(LEAF_COUNT, 1);
+        std::vector<Leaf> leaves(BRANCH_COUNT, Leaf{LEAF_COUNT, data.data()});
+        std::vector<Branch> branches(
+            TREE_COUNT, Branch{BRANCH_COUNT, leaves.data()});
+        Tree tree{TREE_COUNT, branches.data()};
+
+        uint64_t leaf_bytes = sizeof(Leaf) + LEAF_COUNT * sizeof(uint64_t);
+        uint64_t branch_bytes = sizeof(Branch) + BRANCH_COUNT * leaf_bytes;
+        uint64_t tree_bytes = sizeof(Tree) + TREE_COUNT * branch_bytes;
+        bench_ecall("ecall_deepcopy_depth1", leaf_bytes, [&] {
+            return [&] {
+                uint64_t ret = 0;
+                OE_TEST(ecall_deepcopy1(enclave, &ret, &leaves[0]) == OE_OK);
+            };
+        });
+        bench_ecall("ecall_deepcopy_depth2", branch_bytes, [&] {
+            return [&] {
+                uint64_t ret = 0;
+                OE_TEST(ecall_deepcopy2(enclave, &ret, &branches[0]) == OE_OK);
+            };
+        });
+        bench_ecall("ecall_deepcopy_depth3", tree_bytes, [&] {
+            return [&] {
+                uint64_t ret = 0;
+                OE_TEST(ecall_deepcopy3(enclave, &ret, &tree) == OE_OK);
+            };
+        });
+    }
+
+    bench_ecall("ecall_switchless", 0, [] {
+        return [] {
+            int ret = 0;
+            OE_TEST(ecall_switchless(enclave, &ret, 1) == OE_OK);
+        };
+    });
+}
+
+static void bench_ocalls(const std::vector<size_t>& sizes)
+{
+    bench_ocall("ocall_scalars", OCALL_SCALARS, 0, 0);
+    for (size_t size : sizes)
+    {
+        std::string suffix = "_" + std::to_string(size);
+        bench_ocall("ocall_in" + suffix, OCALL_IN, size, size);
+        bench_ocall("ocall_out" + suffix, OCALL_OUT, size, size);
+        bench_ocall("ocall_in_out" + suffix, OCALL_IN_OUT, size, 2 * size);
+        bench_ocall("ocall_string" + suffix, OCALL_STRING, size, size);
+    }
+    bench_ocall("ocall_errno", OCALL_ERRNO, 0, 0);
+    bench_ocall("ocall_switchless", OCALL_SWITCHLESS, 0, 0);
+}
+
+static void write_json(FILE* file)
+{
+    fprintf(file, "{\n");
+    fprintf(file, "  \"suite\": \"oeedger8r_bench\",\n");
+    fprintf(file, "  \"results\": [\n");
+    for (size_t i = 0; i < results.size(); i++)
+    {
+        const Result& r = results[i];
+        fprintf(
+            file,
+            "    {\"name\": \"%s\", \"threads\": %zu, \"calls\": %zu, "
+            "\"p50_ns\": %llu, \"p99_ns\": %llu, \"calls_per_sec\": %.1f, "
+            "\"bytes_per_call\": %llu, \"bytes_pointed_to\": %llu}%s\n",
+            r.name.c_str(),
+            r.threads,
+            r.calls,
+            (unsigned long long)r.p50_ns,
+            (unsigned long long)r.p99_ns,
+            r.calls_per_sec,
+            (unsigned long long)r.bytes_per_call,
+            (unsigned long long)(r.bytes_per_call * r.calls),
+            i + 1 < results.size() ? "," : "");
+    }
+    fprintf(file, "  ]\n");
+    fprintf(file, "}\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* output = NULL;
+    std::vector<size_t> sizes = {64, 4096, 256 * 1024, 16 * 1024 * 1024};
+
+    if (argc < 2)
+    {
+        fprintf(
+            stderr,
+            "Usage: %s ENCLAVE_PATH [--quick] [--iterations N] "
+            "[--threads N] [--output FILE]\n",
+            argv[0]);
+        return 1;
+    }
+    for (int i = 2; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--quick") == 0)
+        {
+            iterations = 100;
+            sizes = {64, 4096};
+        }
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            iterations = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            /* Sweep the powers of two below N, then N. */
+            size_t max_threads = (size_t)std::max(1, atoi(argv[++i]));
+            thread_counts.clear();
+            for (size_t n = 1; n < max_threads; n *= 2)
+                thread_counts.push_back(n);
+            thread_counts.push_back(max_threads);
+        }
+        else if (strcmp(argv[i], "--output") == 0 && i + 1 < argc)
+            output = argv[++i];
+        else
+        {
+            fprintf(stderr, "error: unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+
+    oe_enclave_setting_context_switchless_t switchless_setting = {1, 1};
+    oe_enclave_setting_t setting;
+    setting.setting_type = OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS;
+    setting.u.context_switchless_setting = &switchless_setting;
+    OE_TEST(
+        oe_create_bench_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, 0, &setting, 1, &enclave) == OE_OK);
+
+    bench_ecalls(sizes);
+    bench_ocalls(sizes);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    FILE* file = output ? fopen(output, "w") : stdout;
+    if (!file)
+    {
+        fprintf(stderr, "error: cannot open %s\n", output);
+        return 1;
+    }
+    write_json(file);
+    if (output)
+        fclose(file);
+
+    return 0;
+}
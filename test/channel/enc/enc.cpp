@@ -0,0 +1,31 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "channel_t.h"
+
+#include <string.h>
+
+static uint64_t _next_id;
+
+size_t enc_log(size_t count, char c)
+{
+    char buf[4096];
+    OE_TEST(count <= sizeof(buf));
+    memset(buf, c, count);
+    return log_stream_send(buf, count);
+}
+
+size_t enc_read_samples(size_t count, double* sum)
+{
+    Sample samples[16];
+    size_t n = samples_receive(samples, count < 16 ? count : 16);
+    *sum = 0;
+    for (size_t i = 0; i < n; i++)
+    {
+        /* The records arrive in order, each exactly once. */
+        OE_TEST(samples[i].id == _next_id++);
+        *sum += samples[i].value;
+    }
+    return n;
+}
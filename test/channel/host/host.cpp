@@ -0,0 +1,111 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include "channel_u.h"
+
+static oe_enclave_t* enclave;
+
+static size_t log(size_t count, char c)
+{
+    size_t n = 0;
+    OE_TEST(enc_log(enclave, &n, count, c) == OE_OK);
+    return n;
+}
+
+static void check_log(log_stream_channel_t* channel, size_t count, char c)
+{
+    char buf[2048];
+    OE_TEST(log_stream_receive(channel, buf, sizeof(buf)) == count);
+    for (size_t i = 0; i < count; i++)
+        OE_TEST(buf[i] == c);
+}
+
+static void test_log_stream()
+{
+    log_stream_channel_t* channel = NULL;
+
+    /* Nothing can be sent before the host opens the channel. */
+    OE_TEST(log(10, 'x') == 0);
+    OE_TEST(log_stream_open(NULL, &channel) == OE_INVALID_PARAMETER);
+    OE_TEST(log_stream_open(enclave, NULL) == OE_INVALID_PARAMETER);
+    OE_TEST(log_stream_open(enclave, &channel) == OE_OK);
+
+    OE_TEST(log(700, 'a') == 700);
+    check_log(channel, 700, 'a');
+
+    /* The second batch wraps around the end of the ring. */
+    OE_TEST(log(700, 'b') == 700);
+    check_log(channel, 700, 'b');
+
+    /* A full ring takes no more records. */
+    OE_TEST(log(2000, 'c') == 1024);
+    OE_TEST(log(1, 'd') == 0);
+    check_log(channel, 1024, 'c');
+    check_log(channel, 0, 'c');
+
+    OE_TEST(log_stream_close(channel) == OE_OK);
+    OE_TEST(log(10, 'x') == 0);
+
+    /* A reopened channel starts empty. */
+    OE_TEST(log_stream_open(enclave, &channel) == OE_OK);
+    check_log(channel, 0, 'x');
+    OE_TEST(log(10, 'e') == 10);
+    check_log(channel, 10, 'e');
+    OE_TEST(log_stream_close(channel) == OE_OK);
+}
+
+static size_t read_samples(size_t count, double expected_sum)
+{
+    size_t n = 0;
+    double sum = -1;
+    OE_TEST(enc_read_samples(enclave, &n, count, &sum) == OE_OK);
+    OE_TEST(sum == expected_sum);
+    return n;
+}
+
+static void test_samples()
+{
+    samples_channel_t* channel = NULL;
+    Sample samples[10];
+    for (size_t i = 0; i < 10; i++)
+        samples[i] = Sample{i, (double)i};
+
+    OE_TEST(samples_open(enclave, &channel) == OE_OK);
+
+    /* The 100 byte ring holds 6 records of 16 bytes. */
+    OE_TEST(samples_send(channel, samples, 10) == 6);
+    OE_TEST(read_samples(4, 0 + 1 + 2 + 3) == 4);
+    OE_TEST(samples_send(channel, samples + 6, 4) == 4);
+    OE_TEST(read_samples(100, 4 + 5 + 6 + 7 + 8 + 9) == 6);
+    OE_TEST(read_samples(100, 0) == 0);
+
+    OE_TEST(samples_close(channel) == OE_OK);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_channel_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    test_log_stream();
+    test_samples();
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (channel)\n");
+
+    return 0;
+}
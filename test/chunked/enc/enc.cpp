@@ -0,0 +1,247 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "chunked_t.h"
+
+/* The state of a call that streams a chunked in parameter. */
+typedef struct _call
+{
+    bool busy;
+    size_t next_offset;
+    uint64_t sum;
+    uint64_t chunks;
+    uint64_t aborts;
+} call_t;
+
+/* The calls in progress, one per id. */
+static call_t _calls[2];
+
+static call_t* _get_call(int id)
+{
+    OE_TEST(id >= 0 && id < (int)OE_COUNTOF(_calls));
+    return &_calls[id];
+}
+
+static void _begin(int id)
+{
+    call_t* call = _get_call(id);
+    OE_TEST(!call->busy);
+    call->busy = true;
+    call->next_offset = 0;
+    call->sum = 0;
+    call->chunks = 0;
+}
+
+/* Empty and null buffers are not streamed, so the call may not have begun. */
+static uint64_t _end(int id, size_t n)
+{
+    call_t* call = _get_call(id);
+    uint64_t sum = 0;
+    if (call->busy)
+    {
+        OE_TEST(call->next_offset == n);
+        sum = call->sum;
+    }
+    call->busy = false;
+    return sum;
+}
+
+static void _abort(int id)
+{
+    call_t* call = _get_call(id);
+    OE_TEST(call->busy);
+    call->busy = false;
+    call->aborts++;
+}
+
+void enc_sum_values_begin(size_t n, int id)
+{
+    OE_TEST(n > 0);
+    _begin(id);
+}
+
+void enc_sum_values_sink(
+    size_t n,
+    int id,
+    const uint32_t* chunk,
+    size_t offset,
+    size_t count)
+{
+    /* The chunks arrive in order and none is larger than 64 bytes. */
+    call_t* call = _get_call(id);
+    OE_TEST(call->busy);
+    OE_TEST(offset == call->next_offset);
+    OE_TEST(count > 0 && count <= 16 && offset + count <= n);
+    call->next_offset += count;
+    for (size_t i = 0; i < count; i++)
+        call->sum += chunk[i];
+}
+
+void enc_sum_values_abort(size_t n, int id)
+{
+    OE_UNUSED(n);
+    _abort(id);
+}
+
+uint64_t enc_sum(const uint32_t* values, size_t n, int id)
+{
+    /* The values went through the sink. */
+    OE_TEST(values == NULL);
+    return _end(id, n);
+}
+
+void enc_sum_pair_values_begin(size_t n, size_t size, int id)
+{
+    OE_UNUSED(n);
+    OE_UNUSED(size);
+    _begin(id);
+}
+
+void enc_sum_pair_values_sink(
+    size_t n,
+    size_t size,
+    int id,
+    const uint32_t* chunk,
+    size_t offset,
+    size_t count)
+{
+    OE_UNUSED(size);
+    enc_sum_values_sink(n, id, chunk, offset, count);
+}
+
+void enc_sum_pair_values_abort(size_t n, size_t size, int id)
+{
+    OE_UNUSED(n);
+    OE_UNUSED(size);
+    _abort(id);
+}
+
+void enc_sum_pair_words_begin(size_t n, size_t size, int id)
+{
+    /* The words never stream. */
+    OE_UNUSED(n);
+    OE_UNUSED(size);
+    OE_UNUSED(id);
+    OE_TEST(false);
+}
+
+void enc_sum_pair_words_sink(
+    size_t n,
+    size_t size,
+    int id,
+    const uint32_t* chunk,
+    size_t offset,
+    size_t count)
+{
+    OE_UNUSED(n);
+    OE_UNUSED(size);
+    OE_UNUSED(id);
+    OE_UNUSED(chunk);
+    OE_UNUSED(offset);
+    OE_UNUSED(count);
+    OE_TEST(false);
+}
+
+void enc_sum_pair_words_abort(size_t n, size_t size, int id)
+{
+    OE_UNUSED(n);
+    OE_UNUSED(size);
+    OE_UNUSED(id);
+    OE_TEST(false);
+}
+
+uint64_t enc_sum_pair(
+    const uint32_t* values,
+    size_t n,
+    const uint32_t* words,
+    size_t size,
+    int id)
+{
+    OE_UNUSED(values);
+    OE_UNUSED(n);
+    OE_UNUSED(words);
+    OE_UNUSED(size);
+    OE_UNUSED(id);
+    OE_TEST(false);
+    return 0;
+}
+
+uint64_t enc_aborts(int id)
+{
+    call_t* call = _get_call(id);
+    uint64_t aborts = call->aborts;
+    call->aborts = 0;
+    return aborts;
+}
+
+void enc_fill(uint8_t* buf, size_t size, uint8_t offset)
+{
+    OE_TEST(buf == NULL);
+    OE_UNUSED(size);
+    OE_UNUSED(offset);
+}
+
+void enc_fill_buf_begin(size_t size, uint8_t offset)
+{
+    OE_TEST(size > 0);
+    OE_UNUSED(offset);
+}
+
+void enc_fill_buf_source(
+    size_t size,
+    uint8_t offset,
+    uint8_t* chunk,
+    size_t _offset,
+    size_t count)
+{
+    OE_TEST(count > 0 && count <= 100 && _offset + count <= size);
+    for (size_t i = 0; i < count; i++)
+        chunk[i] = (uint8_t)(offset + _offset + i);
+}
+
+void enc_fill_buf_abort(size_t size, uint8_t offset)
+{
+    OE_UNUSED(size);
+    OE_UNUSED(offset);
+    OE_TEST(false);
+}
+
+void enc_checksum_data_begin(size_t size, int id)
+{
+    OE_UNUSED(size);
+    _begin(id);
+}
+
+void enc_checksum_data_sink(
+    size_t size,
+    int id,
+    const uint8_t* chunk,
+    size_t offset,
+    size_t count)
+{
+    call_t* call = _get_call(id);
+    OE_TEST(call->busy);
+    OE_TEST(count <= 65536 && offset + count <= size);
+    for (size_t i = 0; i < count; i++)
+        call->sum += chunk[i] * (offset + i + 1);
+    call->next_offset += count;
+    call->chunks++;
+}
+
+void enc_checksum_data_abort(size_t size, int id)
+{
+    OE_UNUSED(size);
+    _abort(id);
+}
+
+uint64_t enc_checksum(
+    const uint8_t* data,
+    size_t size,
+    int id,
+    uint64_t* chunks)
+{
+    OE_TEST(data == NULL);
+    *chunks = _get_call(id)->chunks;
+    return _end(id, size);
+}
@@ -0,0 +1,136 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include <openenclave/internal/tests.h>
+#include "chunked_u.h"
+
+static oe_enclave_t* enclave;
+
+static void test_sum()
+{
+    std::vector<uint32_t> values(1000);
+    uint64_t expected = 0;
+    for (size_t i = 0; i < values.size(); i++)
+        expected += values[i] = (uint32_t)(i * 7);
+
+    uint64_t sum = 0;
+    OE_TEST(enc_sum(enclave, &sum, values.data(), values.size(), 0) == OE_OK);
+    OE_TEST(sum == expected);
+
+    /* Empty and null buffers are not streamed. */
+    OE_TEST(enc_sum(enclave, &sum, values.data(), 0, 0) == OE_OK);
+    OE_TEST(sum == 0);
+    OE_TEST(enc_sum(enclave, &sum, NULL, 10, 0) == OE_OK);
+    OE_TEST(sum == 0);
+}
+
+static void test_concurrent()
+{
+    /* The sinks of calls with different ids interleave. */
+    std::vector<std::thread> threads;
+    for (int id = 0; id < 2; id++)
+        threads.emplace_back([id]() {
+            std::vector<uint32_t> values(1000 + (size_t)id * 100);
+            uint64_t expected = 0;
+            for (size_t i = 0; i < values.size(); i++)
+                expected += values[i] = (uint32_t)(i * (size_t)(id + 3));
+
+            for (int i = 0; i < 100; i++)
+            {
+                uint64_t sum = 0;
+                OE_TEST(
+                    enc_sum(
+                        enclave, &sum, values.data(), values.size(), id) ==
+                    OE_OK);
+                OE_TEST(sum == expected);
+            }
+        });
+    for (std::thread& t : threads)
+        t.join();
+}
+
+static void test_abort()
+{
+    std::vector<uint32_t> values(100, 1);
+    uint64_t sum = 0;
+    uint64_t aborts = 0;
+
+    /* The words fail after the values began, so the values are aborted. */
+    OE_TEST(
+        enc_sum_pair(
+            enclave,
+            &sum,
+            values.data(),
+            values.size(),
+            values.data(),
+            10,
+            1) == OE_INVALID_PARAMETER);
+    OE_TEST(enc_aborts(enclave, &aborts, 1) == OE_OK);
+    OE_TEST(aborts == 1);
+
+    /* The aborted call no longer holds its id. */
+    OE_TEST(enc_sum(enclave, &sum, values.data(), values.size(), 1) == OE_OK);
+    OE_TEST(sum == values.size());
+    OE_TEST(enc_aborts(enclave, &aborts, 1) == OE_OK);
+    OE_TEST(aborts == 0);
+}
+
+static void test_fill()
+{
+    std::vector<uint8_t> buf(1000);
+    OE_TEST(enc_fill(enclave, buf.data(), buf.size(), 3) == OE_OK);
+    for (size_t i = 0; i < buf.size(); i++)
+        OE_TEST(buf[i] == (uint8_t)(3 + i));
+}
+
+static void test_large()
+{
+    /* 8 MB cross the boundary in 128 chunks of 64 KB. */
+    std::vector<uint8_t> data(8 * 1024 * 1024);
+    uint64_t expected = 0;
+    for (size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = (uint8_t)(i % 251);
+        expected += data[i] * (i + 1);
+    }
+
+    uint64_t checksum = 0;
+    uint64_t chunks = 0;
+    OE_TEST(
+        enc_checksum(
+            enclave, &checksum, data.data(), data.size(), 0, &chunks) ==
+        OE_OK);
+    OE_TEST(checksum == expected);
+    OE_TEST(chunks == 128);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_chunked_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    test_sum();
+    test_concurrent();
+    test_abort();
+    test_fill();
+    test_large();
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (chunked)\n");
+
+    return 0;
+}
@@ -0,0 +1,14 @@
+# Copyright (c) Open Enclave SDK contributors.
+# Licensed under the MIT License.
+
+# Generate the layout report of an EDL file and print it, so that the test
+# can match its content.
+execute_process(
+  COMMAND ${OEEDGER8R} --header-only --trusted-dir ${DIR} --untrusted-dir
+          ${DIR} --layout-report ${DIR}/report.json ${EDL}
+  RESULT_VARIABLE result)
+if (NOT result EQUAL 0)
+  message(FATAL_ERROR "oeedger8r failed: ${result}")
+endif ()
+file(READ ${DIR}/report.json report)
+message("${report}")
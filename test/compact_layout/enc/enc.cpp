@@ -0,0 +1,65 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include "compact_layout_t.h"
+
+template <typename T>
+static bool aligned(const T* p)
+{
+    return (uintptr_t)p % alignof(T) == 0;
+}
+
+size_t enc_mixed(
+    const char* name,
+    const uint8_t* bytes,
+    const uint64_t* values,
+    size_t n,
+    char* tag,
+    uint64_t* sum,
+    uint16_t* shorts)
+{
+    OE_TEST(aligned(values) && aligned(sum) && aligned(shorts));
+    *sum = 0;
+    for (size_t i = 0; i < 3; i++)
+        *sum += bytes[i];
+    for (size_t i = 0; i < n; i++)
+        *sum += values[i];
+    memcpy(tag, "mixed", 5);
+    for (size_t i = 0; i < 3; i++)
+        shorts[i] *= 2;
+    return strlen(name);
+}
+
+void enc_produce(
+    const char* prefix,
+    uint8_t* buf,
+    size_t cap,
+    size_t* produced,
+    uint32_t* checksum)
+{
+    OE_TEST(aligned(produced) && aligned(checksum));
+    *produced = cap < 7 ? cap : 7;
+    *checksum = 0;
+    for (size_t i = 0; i < *produced; i++)
+    {
+        buf[i] = (uint8_t)prefix[i % 3];
+        *checksum += buf[i];
+    }
+}
+
+void enc_call_host()
+{
+    uint64_t values[] = {1, 2, 3};
+    char text[] = "abcdef";
+    uint32_t words[2] = {0};
+    uint64_t retval = 0;
+
+    OE_TEST(host_mixed(&retval, "enclave", values, 3, text, words) == OE_OK);
+    OE_TEST(retval == 6);
+    OE_TEST(strcmp(text, "ABCDEF") == 0);
+    OE_TEST(words[0] == 7 && words[1] == 3);
+}
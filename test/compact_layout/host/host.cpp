@@ -0,0 +1,74 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include "compact_layout_u.h"
+
+uint64_t host_mixed(
+    const char* name,
+    const uint64_t* values,
+    size_t n,
+    char* text,
+    uint32_t* words)
+{
+    OE_TEST((uintptr_t)values % 8 == 0 && (uintptr_t)words % 4 == 0);
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += values[i];
+    for (size_t i = 0; text[i]; i++)
+        text[i] = (char)(text[i] - 'a' + 'A');
+    words[0] = (uint32_t)strlen(name);
+    words[1] = (uint32_t)n;
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+    uint8_t bytes[] = {1, 2, 3};
+    uint64_t values[] = {10, 20, 30, 40};
+    char tag[5] = {0};
+    uint64_t sum = 0;
+    uint16_t shorts[] = {1, 2, 3};
+    size_t retval = 0;
+    uint8_t buf[16] = {0};
+    size_t produced = 0;
+    uint32_t checksum = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_compact_layout_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, 0, NULL, 0, &enclave) == OE_OK);
+
+    OE_TEST(
+        enc_mixed(
+            enclave, &retval, "odd", bytes, values, 4, tag, &sum, shorts) ==
+        OE_OK);
+    OE_TEST(retval == 3);
+    OE_TEST(sum == 106);
+    OE_TEST(memcmp(tag, "mixed", 5) == 0);
+    OE_TEST(shorts[0] == 2 && shorts[1] == 4 && shorts[2] == 6);
+
+    /* Only the produced part of the buffer is copied back. */
+    OE_TEST(
+        enc_produce(enclave, "xyz", buf, sizeof(buf), &produced, &checksum) ==
+        OE_OK);
+    OE_TEST(produced == 7);
+    OE_TEST(memcmp(buf, "xyzxyzx", 7) == 0 && buf[7] == 0);
+    OE_TEST(checksum == 3 * ('x' + 'y' + 'z') - 'y' - 'z');
+
+    OE_TEST(enc_call_host(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+    printf("=== passed all tests (compact_layout)\n");
+    return 0;
+}
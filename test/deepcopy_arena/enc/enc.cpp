@@ -0,0 +1,106 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "deepcopy_arena_t.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void set_countparam(CountParamStruct* s, size_t count, uint64_t value)
+{
+    s->count = count;
+    s->ptr = (uint64_t*)malloc(count * sizeof(uint64_t));
+    for (size_t i = 0; i < count; i++)
+        s->ptr[i] = value + i;
+}
+
+static bool within(const void* ptr, const void* base, size_t size)
+{
+    return (const uint8_t*)ptr >= (const uint8_t*)base &&
+           (const uint8_t*)ptr < (const uint8_t*)base + size;
+}
+
+void enc_out(CountParamStruct* s)
+{
+    OE_TEST(s->count == 0);
+    OE_TEST(s->ptr == NULL);
+    set_countparam(s, 8, 100);
+}
+
+void enc_out_array(CountParamStruct* s, size_t n)
+{
+    for (size_t i = 0; i < n; i++)
+        set_countparam(&s[i], i + 1, 10 * i);
+}
+
+void enc_nested_out(NestedStruct* n)
+{
+    n->num = 3;
+    n->array_of_struct =
+        (CountParamStruct*)malloc(n->num * sizeof(CountParamStruct));
+    for (size_t i = 0; i < n->num; i++)
+        set_countparam(&n->array_of_struct[i], 4, i);
+}
+
+void enc_deepcopy_arena_test()
+{
+    void* arena = NULL;
+
+    {
+        CountParamStruct s;
+        memset(&s, 0, sizeof(s));
+        OE_TEST(host_out(&s, &arena) == OE_OK);
+        OE_TEST(s.count == 5);
+        OE_TEST(arena == s.ptr);
+        OE_TEST(oe_is_within_enclave(s.ptr, s.count * sizeof(uint64_t)));
+        for (size_t i = 0; i < s.count; i++)
+            OE_TEST(s.ptr[i] == 7 * i);
+        host_out_free_out(arena);
+    }
+
+    {
+        NestedStruct n;
+        memset(&n, 0, sizeof(n));
+        OE_TEST(host_nested_out(&n, 2, &arena) == OE_OK);
+        OE_TEST(n.num == 2);
+        /* The nested pointers follow the array in the same block. */
+        size_t size = 2 * sizeof(CountParamStruct) + 2 * 64;
+        for (size_t i = 0; i < n.num; i++)
+        {
+            CountParamStruct* s = &n.array_of_struct[i];
+            OE_TEST(within(s->ptr, n.array_of_struct, size));
+            OE_TEST(s->count == 3);
+            for (size_t j = 0; j < s->count; j++)
+                OE_TEST(s->ptr[j] == i + j);
+        }
+        host_nested_out_free_out(arena);
+    }
+
+    {
+        /* The arena is released through the handle even if the caller
+         * cleared the nested pointer at its start. */
+        NestedStruct n;
+        memset(&n, 0, sizeof(n));
+        OE_TEST(host_nested_out(&n, 2, &arena) == OE_OK);
+        OE_TEST(arena == n.array_of_struct);
+        n.array_of_struct = NULL;
+        host_nested_out_free_out(arena);
+    }
+
+    {
+        /* A null nested pointer leaves nothing to release. */
+        NestedStruct n;
+        memset(&n, 0, sizeof(n));
+        OE_TEST(host_nested_out(&n, 0, &arena) == OE_OK);
+        OE_TEST(n.array_of_struct == NULL);
+        OE_TEST(arena == NULL);
+        host_nested_out_free_out(arena);
+    }
+
+    {
+        CountParamStruct s;
+        OE_TEST(host_out(&s, NULL) == OE_INVALID_PARAMETER);
+    }
+}
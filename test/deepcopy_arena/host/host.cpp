@@ -0,0 +1,124 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include "deepcopy_arena_u.h"
+
+static void set_countparam(CountParamStruct* s, size_t count, uint64_t factor)
+{
+    s->count = count;
+    s->ptr = (uint64_t*)malloc(count * sizeof(uint64_t));
+    for (size_t i = 0; i < count; i++)
+        s->ptr[i] = factor * i;
+}
+
+static bool within(const void* ptr, const void* base, size_t size)
+{
+    return (const uint8_t*)ptr >= (const uint8_t*)base &&
+           (const uint8_t*)ptr < (const uint8_t*)base + size;
+}
+
+void host_out(CountParamStruct* s)
+{
+    set_countparam(s, 5, 7);
+}
+
+void host_nested_out(NestedStruct* n, size_t num)
+{
+    n->num = num;
+    n->array_of_struct = NULL;
+    if (num == 0)
+        return;
+    n->array_of_struct =
+        (CountParamStruct*)malloc(num * sizeof(CountParamStruct));
+    for (size_t i = 0; i < num; i++)
+    {
+        CountParamStruct* s = &n->array_of_struct[i];
+        s->count = 3;
+        s->ptr = (uint64_t*)malloc(s->count * sizeof(uint64_t));
+        for (size_t j = 0; j < s->count; j++)
+            s->ptr[j] = i + j;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_deepcopy_arena_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    void* arena = NULL;
+
+    {
+        CountParamStruct s;
+        memset(&s, 0, sizeof(s));
+        OE_TEST(enc_out(enclave, &s, &arena) == OE_OK);
+        OE_TEST(s.count == 8);
+        OE_TEST(arena == s.ptr);
+        for (size_t i = 0; i < s.count; i++)
+            OE_TEST(s.ptr[i] == 100 + i);
+        enc_out_free_out(arena);
+    }
+
+    {
+        /* All the elements share the block that starts at s[0].ptr. */
+        CountParamStruct s[3];
+        memset(s, 0, sizeof(s));
+        OE_TEST(enc_out_array(enclave, s, 3, &arena) == OE_OK);
+        OE_TEST(arena == s[0].ptr);
+        for (size_t i = 0; i < 3; i++)
+        {
+            OE_TEST(s[i].count == i + 1);
+            OE_TEST(within(s[i].ptr, arena, 6 * sizeof(uint64_t) + 48));
+            for (size_t j = 0; j < s[i].count; j++)
+                OE_TEST(s[i].ptr[j] == 10 * i + j);
+        }
+
+        /* The caller may clear the nested pointer at the start of the block
+         * before releasing it. */
+        s[0].ptr = NULL;
+        enc_out_array_free_out(arena);
+    }
+
+    {
+        NestedStruct n;
+        memset(&n, 0, sizeof(n));
+        OE_TEST(enc_nested_out(enclave, &n, &arena) == OE_OK);
+        OE_TEST(n.num == 3);
+        size_t size = 3 * sizeof(CountParamStruct) + 3 * 48;
+        for (size_t i = 0; i < n.num; i++)
+        {
+            CountParamStruct* s = &n.array_of_struct[i];
+            OE_TEST(within(s->ptr, n.array_of_struct, size));
+            OE_TEST(s->count == 4);
+            for (size_t j = 0; j < s->count; j++)
+                OE_TEST(s->ptr[j] == i + j);
+        }
+        enc_nested_out_free_out(arena);
+    }
+
+    {
+        CountParamStruct s;
+        OE_TEST(enc_out(enclave, &s, NULL) == OE_INVALID_PARAMETER);
+    }
+
+    OE_TEST(enc_deepcopy_arena_test(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (deepcopy_arena)\n");
+}
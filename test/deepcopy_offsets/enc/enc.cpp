@@ -0,0 +1,83 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "deepcopy_offsets_t.h"
+
+#include <stdint.h>
+#include <string.h>
+
+static uint64_t sum_nested(const NestedStruct* n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n->num; i++)
+    {
+        const CountParamStruct* s = &n->array_of_struct[i];
+        for (size_t j = 0; j < s->count; j++)
+            sum += s->ptr[j];
+    }
+    if (n->array_of_int)
+    {
+        for (size_t i = 0; i < 4; i++)
+            sum += (uint64_t)n->array_of_int[i];
+    }
+    return sum;
+}
+
+uint64_t enc_sum(NestedStruct* n)
+{
+    return sum_nested(n);
+}
+
+uint64_t enc_sum_array(NestedStruct* s, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += sum_nested(&s[i]);
+    return sum;
+}
+
+uint64_t enc_sum_super(SuperNestedStruct* s)
+{
+    return enc_sum_array(s->more_structs, 2);
+}
+
+uint64_t enc_sum_bytes(BytesStruct* s, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+        for (size_t j = 0; j < s[i].len; j++)
+            sum += s[i].bytes[j];
+    return sum;
+}
+
+void enc_double(NestedStruct* n)
+{
+    for (size_t i = 0; i < n->num; i++)
+    {
+        CountParamStruct* s = &n->array_of_struct[i];
+        for (size_t j = 0; j < s->count; j++)
+            s->ptr[j] *= 2;
+    }
+    for (size_t i = 0; i < 4; i++)
+        n->array_of_int[i] *= 2;
+}
+
+void enc_deepcopy_offsets_test()
+{
+    uint64_t data[3][4] = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+    CountParamStruct c[3] = {{4, data[0]}, {4, data[1]}, {4, data[2]}};
+    int ints[4] = {100, 200, 300, 400};
+    NestedStruct n[2] = {{3, c, ints}, {1, &c[2], NULL}};
+
+    uint64_t sum = 0;
+    OE_TEST(host_sum_array(&sum, n, 2) == OE_OK);
+    OE_TEST(sum == 78 + 1000 + 42);
+
+    OE_TEST(host_double(&n[0]) == OE_OK);
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 4; j++)
+            OE_TEST(data[i][j] == 2 * (4 * i + j + 1));
+    for (size_t i = 0; i < 4; i++)
+        OE_TEST(ints[i] == 200 * (int)(i + 1));
+}
@@ -0,0 +1,199 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+
+/* Include the generated code to marshal enc_sum_args_t by hand. */
+#include "deepcopy_offsets_u.c"
+
+static uint64_t sum_nested(const NestedStruct* n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n->num; i++)
+    {
+        const CountParamStruct* s = &n->array_of_struct[i];
+        for (size_t j = 0; j < s->count; j++)
+            sum += s->ptr[j];
+    }
+    if (n->array_of_int)
+    {
+        for (size_t i = 0; i < 4; i++)
+            sum += (uint64_t)n->array_of_int[i];
+    }
+    return sum;
+}
+
+uint64_t host_sum_array(NestedStruct* s, size_t n)
+{
+    uint64_t sum = 0;
+    for (size_t i = 0; i < n; i++)
+        sum += sum_nested(&s[i]);
+    return sum;
+}
+
+void host_double(NestedStruct* n)
+{
+    for (size_t i = 0; i < n->num; i++)
+    {
+        CountParamStruct* s = &n->array_of_struct[i];
+        for (size_t j = 0; j < s->count; j++)
+            s->ptr[j] *= 2;
+    }
+    for (size_t i = 0; i < 4; i++)
+        n->array_of_int[i] *= 2;
+}
+
+static size_t align(size_t size)
+{
+    return (size + OE_EDGER8R_BUFFER_ALIGNMENT - 1) &
+           ~(OE_EDGER8R_BUFFER_ALIGNMENT - 1);
+}
+
+/*
+ * Marshal a NestedStruct with one CountParamStruct by hand, with the given
+ * offsets of the nested blocks and count of the innermost one, and pass it
+ * to enc_sum. The blocks are at their usual places, so only the offsets
+ * differ from what the wrapper writes.
+ */
+static oe_result_t enc_sum_raw(
+    oe_enclave_t* enclave,
+    size_t structs_offset,
+    size_t ptr_offset,
+    size_t count,
+    uint64_t* sum)
+{
+    static uint64_t global_id = OE_GLOBAL_ECALL_ID_NULL;
+    const size_t n_offset = align(sizeof(enc_sum_args_t));
+    const size_t c_offset = n_offset + align(sizeof(NestedStruct));
+    const size_t data_offset = c_offset + align(sizeof(CountParamStruct));
+    const size_t input_size = data_offset + 2 * sizeof(uint64_t);
+    const size_t output_size = align(sizeof(enc_sum_args_t));
+    uint8_t input[1024];
+    uint8_t output[1024];
+    size_t output_bytes_written = 0;
+    oe_result_t result = OE_FAILURE;
+    enc_sum_args_t args;
+    NestedStruct n = {1, (CountParamStruct*)structs_offset, NULL};
+    CountParamStruct c = {count, (uint64_t*)ptr_offset};
+    uint64_t data[2] = {20, 22};
+
+    memset(input, 0, sizeof(input));
+    memset(output, 0, sizeof(output));
+    memset(&args, 0, sizeof(args));
+    args.n = (NestedStruct*)n_offset;
+    memcpy(input, &args, sizeof(args));
+    memcpy(input + n_offset, &n, sizeof(n));
+    memcpy(input + c_offset, &c, sizeof(c));
+    memcpy(input + data_offset, data, sizeof(data));
+
+    result = oe_call_enclave_function(
+        enclave,
+        &global_id,
+        "enc_sum",
+        input,
+        input_size,
+        output,
+        output_size,
+        &output_bytes_written);
+
+    memcpy(&args, output, sizeof(args));
+    *sum = args.oe_retval;
+    return result;
+}
+
+static void test_offsets_checked(oe_enclave_t* enclave)
+{
+    const size_t n_offset = align(sizeof(enc_sum_args_t));
+    const size_t c_offset = n_offset + align(sizeof(NestedStruct));
+    const size_t data_offset = c_offset + align(sizeof(CountParamStruct));
+    const size_t end = data_offset + 2 * sizeof(uint64_t);
+    uint64_t sum = 0;
+
+    OE_TEST(enc_sum_raw(enclave, c_offset, data_offset, 2, &sum) == OE_OK);
+    OE_TEST(sum == 42);
+
+    /* The offsets are used as is, so a gap between blocks is fine. */
+    OE_TEST(enc_sum_raw(enclave, c_offset, end - 8, 1, &sum) == OE_OK);
+    OE_TEST(sum == 22);
+
+    /* A block must end within the buffer. */
+    OE_TEST(
+        enc_sum_raw(enclave, c_offset, data_offset, 3, &sum) ==
+        OE_BUFFER_TOO_SMALL);
+    OE_TEST(
+        enc_sum_raw(enclave, c_offset, end, 1, &sum) == OE_BUFFER_TOO_SMALL);
+    OE_TEST(
+        enc_sum_raw(enclave, c_offset, SIZE_MAX - 8, 1, &sum) ==
+        OE_BUFFER_TOO_SMALL);
+
+    /* A block must not overlap the parameter or an earlier block. */
+    OE_TEST(
+        enc_sum_raw(enclave, n_offset, data_offset, 2, &sum) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(
+        enc_sum_raw(enclave, c_offset, c_offset, 2, &sum) ==
+        OE_INVALID_PARAMETER);
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_deepcopy_offsets_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    uint64_t data[3][4] = {{1, 2, 3, 4}, {5, 6, 7, 8}, {9, 10, 11, 12}};
+    CountParamStruct c[3] = {{4, data[0]}, {4, data[1]}, {4, data[2]}};
+    int ints[4] = {100, 200, 300, 400};
+    NestedStruct n[2] = {{3, c, ints}, {1, &c[2], NULL}};
+    uint64_t sum = 0;
+
+    OE_TEST(enc_sum(enclave, &sum, &n[0]) == OE_OK);
+    OE_TEST(sum == 78 + 1000);
+
+    /* The second element only has some of its nested pointers set. */
+    OE_TEST(enc_sum_array(enclave, &sum, n, 2) == OE_OK);
+    OE_TEST(sum == 78 + 1000 + 42);
+
+    SuperNestedStruct super = {n};
+    OE_TEST(enc_sum_super(enclave, &sum, &super) == OE_OK);
+    OE_TEST(sum == 78 + 1000 + 42);
+
+    /* A null nested array is not fixed up. */
+    NestedStruct empty = {0, NULL, NULL};
+    OE_TEST(enc_sum(enclave, &sum, &empty) == OE_OK);
+    OE_TEST(sum == 0);
+
+    OE_TEST(enc_double(enclave, &n[0]) == OE_OK);
+    for (size_t i = 0; i < 3; i++)
+        for (size_t j = 0; j < 4; j++)
+            OE_TEST(data[i][j] == 2 * (4 * i + j + 1));
+    for (size_t i = 0; i < 4; i++)
+        OE_TEST(ints[i] == 200 * (int)(i + 1));
+
+    /* The size field is 16 bits wide. */
+    uint8_t bytes[3] = {1, 2, 3};
+    BytesStruct b[2] = {{3, bytes}, {0, NULL}};
+    OE_TEST(enc_sum_bytes(enclave, &sum, b, 2) == OE_OK);
+    OE_TEST(sum == 6);
+
+    test_offsets_checked(enclave);
+
+    OE_TEST(enc_deepcopy_offsets_test(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (deepcopy_offsets)\n");
+}
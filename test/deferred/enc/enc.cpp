@@ -0,0 +1,48 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "deferred_t.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void enc_log(int count)
+{
+    char msg[32];
+    for (int i = 0; i < count; i++)
+    {
+        snprintf(msg, sizeof(msg), "message %d", i);
+        OE_TEST(host_log(msg) == OE_OK);
+    }
+}
+
+void enc_flush()
+{
+    OE_TEST(deferred_flush_deferred() == OE_OK);
+
+    /* Flushing an empty buffer does not call the host. */
+    OE_TEST(deferred_flush_deferred() == OE_OK);
+}
+
+void enc_deferred_test()
+{
+    for (uint64_t i = 1; i <= 100; i++)
+        OE_TEST(host_add(i) == OE_OK);
+
+    uint64_t values[] = {1, 2, 3, 4};
+    Samples samples = {4, values};
+    OE_TEST(host_samples(&samples) == OE_OK);
+
+    /* Records larger than the deferred OCALL buffer grow it. */
+    static uint8_t buf[16384];
+    for (size_t i = 0; i < sizeof(buf); i++)
+        buf[i] = (uint8_t)i;
+    OE_TEST(host_buffer(buf, sizeof(buf)) == OE_OK);
+    OE_TEST(host_add(1000) == OE_OK);
+
+    /* A synchronous OCALL delivers the deferred ones first. */
+    size_t count = 0;
+    OE_TEST(host_get_log_count(&count) == OE_OK);
+    OE_TEST(count == 1003);
+}
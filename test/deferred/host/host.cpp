@@ -0,0 +1,86 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include <openenclave/internal/tests.h>
+#include "deferred_u.h"
+
+static std::vector<std::string> _logs;
+static uint64_t _sum;
+static uint64_t _samples_sum;
+static size_t _buffer_size;
+
+void host_log(const char* msg)
+{
+    _logs.push_back(msg);
+}
+
+void host_add(uint64_t value)
+{
+    _sum += value;
+}
+
+void host_samples(Samples* samples)
+{
+    OE_TEST(samples->count == 4);
+    for (size_t i = 0; i < samples->count; i++)
+        _samples_sum += samples->values[i];
+}
+
+void host_buffer(const uint8_t* buf, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+        OE_TEST(buf[i] == (uint8_t)i);
+    _buffer_size = size;
+}
+
+size_t host_get_log_count(void)
+{
+    /* All the deferred OCALLs made before arrive first and in order. */
+    OE_TEST(_sum == 5050 + 1000);
+    OE_TEST(_samples_sum == 10);
+    OE_TEST(_buffer_size != 0);
+    return _logs.size();
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_deferred_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    /* Deferred OCALLs stay in the enclave until the buffer is flushed. */
+    OE_TEST(enc_log(enclave, 3) == OE_OK);
+    OE_TEST(_logs.empty());
+    OE_TEST(enc_flush(enclave) == OE_OK);
+    OE_TEST(_logs.size() == 3);
+    for (size_t i = 0; i < 3; i++)
+        OE_TEST(_logs[i] == "message " + std::to_string(i));
+
+    /* The buffer is flushed when it fills up. */
+    OE_TEST(enc_log(enclave, 1000) == OE_OK);
+    OE_TEST(_logs.size() > 3 && _logs.size() < 1003);
+    OE_TEST(enc_flush(enclave) == OE_OK);
+    OE_TEST(_logs.size() == 1003);
+    for (size_t i = 0; i < 1000; i++)
+        OE_TEST(_logs[i + 3] == "message " + std::to_string(i));
+
+    OE_TEST(enc_deferred_test(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (deferred)\n");
+}
@@ -0,0 +1,52 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/edger8r/enclave.h>
+#include <openenclave/internal/tests.h>
+#include "host_memory_t.h"
+
+void enc_host_memory_test()
+{
+    const size_t count = 64;
+    uint8_t* buf = (uint8_t*)oe_host_malloc(count);
+    uint64_t* values = (uint64_t*)oe_host_malloc(count * sizeof(uint64_t));
+    OE_TEST(buf && values);
+
+    /* The host writes to the buffer directly. */
+    OE_TEST(host_fill(buf, count, 7, buf) == OE_OK);
+    for (size_t i = 0; i < count; i++)
+        OE_TEST(buf[i] == 7);
+
+    uint64_t sum = 0;
+    OE_TEST(host_sum(&sum, buf, count, buf) == OE_OK);
+    OE_TEST(sum == 7 * count);
+
+    for (size_t i = 0; i < count; i++)
+        values[i] = i;
+    OE_TEST(host_increment(values, count, values) == OE_OK);
+    for (size_t i = 0; i < count; i++)
+        OE_TEST(values[i] == i + 1);
+
+    /* A null buffer is passed through. */
+    OE_TEST(host_sum(&sum, NULL, 0, NULL) == OE_OK);
+    OE_TEST(sum == 0);
+
+    size_t calls = 0;
+    OE_TEST(host_get_call_count(&calls) == OE_OK);
+    OE_TEST(calls == 4);
+
+    /* Buffers in enclave memory are rejected before the host is called. */
+    uint8_t* enclave_buf = (uint8_t*)oe_malloc(count);
+    OE_TEST(enclave_buf != NULL);
+    OE_TEST(
+        host_fill(enclave_buf, count, 7, enclave_buf) == OE_INVALID_PARAMETER);
+    OE_TEST(
+        host_sum(&sum, enclave_buf, count, enclave_buf) ==
+        OE_INVALID_PARAMETER);
+    OE_TEST(host_get_call_count(&calls) == OE_OK);
+    OE_TEST(calls == 4);
+    oe_free(enclave_buf);
+
+    oe_host_free(values);
+    oe_host_free(buf);
+}
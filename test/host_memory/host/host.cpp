@@ -0,0 +1,65 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+
+#include <openenclave/internal/tests.h>
+#include "host_memory_u.h"
+
+static size_t _calls;
+
+void host_fill(uint8_t* buf, size_t count, uint8_t value, const void* expected)
+{
+    OE_TEST(buf == expected);
+    for (size_t i = 0; i < count; i++)
+        buf[i] = value;
+    _calls++;
+}
+
+uint64_t host_sum(const uint8_t* buf, size_t size, const void* expected)
+{
+    uint64_t sum = 0;
+    OE_TEST(buf == expected);
+    for (size_t i = 0; i < size; i++)
+        sum += buf[i];
+    _calls++;
+    return sum;
+}
+
+void host_increment(uint64_t* values, size_t count, const void* expected)
+{
+    OE_TEST(values == expected);
+    for (size_t i = 0; i < count; i++)
+        values[i]++;
+    _calls++;
+}
+
+size_t host_get_call_count(void)
+{
+    return _calls;
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_host_memory_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    OE_TEST(enc_host_memory_test(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (host_memory)\n");
+
+    return 0;
+}
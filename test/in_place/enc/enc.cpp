@@ -0,0 +1,68 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "in_place_t.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+void enc_in_out(uint64_t* buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        buf[i] *= 2;
+}
+
+void enc_in_place_test()
+{
+    {
+        uint64_t buf[64];
+        for (size_t i = 0; i < 64; i++)
+            buf[i] = i;
+        OE_TEST(host_in_out(buf, 64) == OE_OK);
+        for (size_t i = 0; i < 64; i++)
+            OE_TEST(buf[i] == i + 1);
+
+        /* A null in-out parameter takes no space in the output buffer. */
+        OE_TEST(host_in_out(NULL, 0) == OE_OK);
+    }
+
+    {
+        char str[] = "in-place";
+        OE_TEST(host_in_out_string(str) == OE_OK);
+        OE_TEST(strcmp(str, "IN-PLACE") == 0);
+    }
+
+    {
+        uint8_t in_buf[5] = {1, 2, 3, 4, 5};
+        uint64_t out_buf[2] = {0, 0};
+        uint64_t inout_buf[3] = {10, 20, 30};
+        uint64_t data[4] = {1, 2, 3, 4};
+        CountParamStruct s = {4, 0, data};
+        int scalar = 7;
+        size_t ret = 0;
+
+        OE_TEST(
+            host_mixed(
+                &ret, in_buf, 5, out_buf, inout_buf, &s, &scalar) == OE_OK);
+        OE_TEST(ret == 15);
+        OE_TEST(out_buf[0] == 100 && out_buf[1] == 200);
+        OE_TEST(inout_buf[0] == 11);
+        OE_TEST(inout_buf[1] == 21);
+        OE_TEST(inout_buf[2] == 31);
+        OE_TEST(s.size == 32);
+        for (size_t i = 0; i < 4; i++)
+            OE_TEST(data[i] == 2 * (i + 1));
+        OE_TEST(scalar == 8);
+
+        /* Null parameters mixed with non-null ones. */
+        OE_TEST(
+            host_mixed(&ret, in_buf, 5, NULL, inout_buf, NULL, &scalar) ==
+            OE_OK);
+        OE_TEST(inout_buf[0] == 12);
+        OE_TEST(scalar == 9);
+    }
+
+    printf("=== enc_in_place_test passed\n");
+}
@@ -0,0 +1,79 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <ctype.h>
+#include <stdio.h>
+
+#include <openenclave/internal/tests.h>
+#include "in_place_u.h"
+
+void host_in_out(uint64_t* buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        buf[i]++;
+}
+
+void host_in_out_string(char* str)
+{
+    for (char* p = str; *p; p++)
+        *p = (char)toupper(*p);
+}
+
+size_t host_mixed(
+    const uint8_t* in_buf,
+    size_t in_size,
+    uint64_t* out_buf,
+    uint64_t* inout_buf,
+    CountParamStruct* s,
+    int* scalar)
+{
+    size_t sum = 0;
+    for (size_t i = 0; i < in_size; i++)
+        sum += in_buf[i];
+    if (out_buf)
+    {
+        out_buf[0] = 100;
+        out_buf[1] = 200;
+    }
+    for (size_t i = 0; i < 3; i++)
+        inout_buf[i]++;
+    if (s)
+    {
+        s->size = 32;
+        for (size_t i = 0; i < s->count; i++)
+            s->ptr[i] *= 2;
+    }
+    (*scalar)++;
+    return sum;
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_in_place_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    /* ECALLs keep the regular layout. */
+    uint64_t buf[16];
+    for (size_t i = 0; i < 16; i++)
+        buf[i] = i;
+    OE_TEST(enc_in_out(enclave, buf, 16) == OE_OK);
+    for (size_t i = 0; i < 16; i++)
+        OE_TEST(buf[i] == 2 * i);
+
+    OE_TEST(enc_in_place_test(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (in_place)\n");
+}
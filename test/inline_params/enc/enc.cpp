@@ -0,0 +1,46 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+
+/* Include the generated code to check the layout of its structs. */
+#include "inline_params_t.c"
+
+static_assert(sizeof(enc_point_args_t::p_inline) == 8, "p_inline");
+static_assert(sizeof(enc_point_args_t::sum_inline) == 4, "sum_inline");
+static_assert(sizeof(enc_point_args_t::counter_inline) == 8, "counter");
+static_assert(sizeof(enc_arrays_args_t::quad_inline) == 16, "quad_inline");
+static_assert(sizeof(enc_arrays_args_t::octet_inline) == 64, "octet_inline");
+static_assert(sizeof(host_point_args_t::p_inline) == 8, "host p_inline");
+
+int enc_point(point_t* p, int* sum, uint64_t* counter)
+{
+    if (!p)
+    {
+        OE_TEST(!sum && !counter);
+        return -1;
+    }
+    *sum = p->x + p->y;
+    (*counter)++;
+    return 0;
+}
+
+void enc_arrays(const int* quad, uint64_t* octet, uint64_t* large)
+{
+    for (int i = 0; i < 8; i++)
+        octet[i] = (uint64_t)quad[i % 4] + large[i * 4];
+}
+
+void enc_call_host()
+{
+    point_t p = {10, 20};
+    int sum = 0;
+    uint64_t counter = 41;
+
+    OE_TEST(host_point(&p, &sum, &counter) == OE_OK);
+    OE_TEST(sum == 30);
+    OE_TEST(counter == 42);
+
+    /* Null pointers stay null. */
+    OE_TEST(host_point(NULL, NULL, NULL) == OE_OK);
+}
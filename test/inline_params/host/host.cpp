@@ -0,0 +1,61 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+
+#include <openenclave/internal/tests.h>
+#include "inline_params_u.h"
+
+void host_point(const point_t* p, int* sum, uint64_t* counter)
+{
+    if (!p)
+    {
+        OE_TEST(!sum && !counter);
+        return;
+    }
+    *sum = p->x + p->y;
+    (*counter)++;
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+    point_t p = {3, 4};
+    int sum = 0;
+    uint64_t counter = 7;
+    int retval = 0;
+    int quad[] = {1, 2, 3, 4};
+    uint64_t octet[8] = {0};
+    uint64_t large[32];
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_inline_params_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, 0, NULL, 0, &enclave) == OE_OK);
+
+    OE_TEST(enc_point(enclave, &retval, &p, &sum, &counter) == OE_OK);
+    OE_TEST(retval == 0);
+    OE_TEST(sum == 7);
+    OE_TEST(counter == 8);
+
+    /* Null pointers stay null. */
+    OE_TEST(enc_point(enclave, &retval, NULL, NULL, NULL) == OE_OK);
+    OE_TEST(retval == -1);
+
+    for (uint64_t i = 0; i < 32; i++)
+        large[i] = i * 100;
+    OE_TEST(enc_arrays(enclave, quad, octet, large) == OE_OK);
+    for (uint64_t i = 0; i < 8; i++)
+        OE_TEST(octet[i] == (uint64_t)quad[i % 4] + i * 400);
+
+    OE_TEST(enc_call_host(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+    printf("=== passed all tests (inline_params)\n");
+    return 0;
+}
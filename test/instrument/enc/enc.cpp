@@ -0,0 +1,35 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "../trace.h"
+#include "instrument_t.h"
+
+int enc_sum(const int* values, size_t count)
+{
+    int sum = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        int value = values[i];
+        OE_TEST(host_double(&value) == OE_OK);
+        sum += value;
+    }
+    return sum;
+}
+
+bool enc_check_trace()
+{
+    /* The forwarder of enc_sum, with the wrappers of its two OCALLs. */
+    size_t i = 0;
+    uint32_t enc_sum_id = check_forwarder_begin(i, "enc_sum", true);
+    for (int call = 0; call < 2; call++)
+    {
+        uint32_t id = check_wrapper_begin(i, "host_double", false);
+        check_wrapper_end(i, id);
+    }
+    check_forwarder_end(i, enc_sum_id);
+
+    /* This call has not returned yet. */
+    check_forwarder_begin(i, "enc_check_trace", true);
+    OE_TEST(i == trace.size());
+    return true;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+
+#include "../trace.h"
+#include "instrument_u.h"
+
+void host_double(int* value)
+{
+    *value *= 2;
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_instrument_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    int values[2] = {3, 4};
+    int sum = 0;
+    OE_TEST(enc_sum(enclave, &sum, values, 2) == OE_OK);
+    OE_TEST(sum == 14);
+
+    bool ok = false;
+    OE_TEST(enc_check_trace(enclave, &ok) == OE_OK);
+    OE_TEST(ok);
+
+    /* The wrapper of enc_sum, with the forwarders of its two OCALLs. */
+    size_t i = 0;
+    uint32_t enc_sum_id = check_wrapper_begin(i, "enc_sum", true);
+    for (int call = 0; call < 2; call++)
+    {
+        uint32_t id = check_forwarder_begin(i, "host_double", false);
+        check_forwarder_end(i, id);
+    }
+    check_wrapper_end(i, enc_sum_id);
+
+    uint32_t id = check_wrapper_begin(i, "enc_check_trace", true);
+    check_wrapper_end(i, id);
+    OE_TEST(i == trace.size());
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (instrument)\n");
+
+    return 0;
+}
@@ -0,0 +1,126 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <openenclave/edger8r/common.h>
+#include <openenclave/internal/tests.h>
+#include <string.h>
+#include <vector>
+
+/*
+ * The events reported to the trace hooks, in order. Each side records its
+ * own: the wrappers of the calls it makes and the forwarders of the calls
+ * it receives.
+ */
+enum TraceKind
+{
+    TRACE_BEGIN,
+    TRACE_POINT,
+    TRACE_END,
+};
+
+struct TraceEvent
+{
+    TraceKind kind;
+    uint32_t function_id;
+    const char* name; /* Only for TRACE_BEGIN. */
+    uint32_t value; /* ecall for TRACE_BEGIN, point or result otherwise. */
+    size_t input_buffer_size;
+    size_t output_buffer_size;
+};
+
+static std::vector<TraceEvent> trace;
+
+extern "C"
+{
+    void oe_edger8r_trace_begin(
+        uint32_t function_id,
+        const char* name,
+        bool ecall)
+    {
+        trace.push_back({TRACE_BEGIN, function_id, name, ecall, 0, 0});
+    }
+
+    void oe_edger8r_trace_point(
+        uint32_t function_id,
+        oe_edger8r_trace_point_t point,
+        size_t input_buffer_size,
+        size_t output_buffer_size)
+    {
+        trace.push_back({TRACE_POINT,
+                         function_id,
+                         NULL,
+                         point,
+                         input_buffer_size,
+                         output_buffer_size});
+    }
+
+    void oe_edger8r_trace_end(uint32_t function_id, oe_result_t result)
+    {
+        trace.push_back({TRACE_END, function_id, NULL, result, 0, 0});
+    }
+}
+
+static void check_event(
+    size_t& i,
+    TraceKind kind,
+    uint32_t function_id,
+    uint32_t value)
+{
+    OE_TEST(i < trace.size());
+    OE_TEST(trace[i].kind == kind);
+    OE_TEST(trace[i].function_id == function_id);
+    OE_TEST(trace[i].value == value);
+    i++;
+}
+
+/* Check the begin event of a call and return the id of the function. */
+static uint32_t check_begin(size_t& i, const char* name, bool ecall)
+{
+    OE_TEST(i < trace.size());
+    OE_TEST(trace[i].kind == TRACE_BEGIN);
+    OE_TEST(strcmp(trace[i].name, name) == 0);
+    OE_TEST(trace[i].value == ecall);
+    return trace[i++].function_id;
+}
+
+/* Check the events of a wrapper up to the call of the other side. */
+static uint32_t check_wrapper_begin(size_t& i, const char* name, bool ecall)
+{
+    uint32_t function_id = check_begin(i, name, ecall);
+    check_event(i, TRACE_POINT, function_id, OE_EDGER8R_TRACE_MARSHALLED);
+    OE_TEST(trace[i - 1].input_buffer_size > 0);
+    OE_TEST(trace[i - 1].output_buffer_size > 0);
+    return function_id;
+}
+
+static void check_wrapper_end(size_t& i, uint32_t function_id)
+{
+    check_event(i, TRACE_POINT, function_id, OE_EDGER8R_TRACE_RETURNED);
+    check_event(i, TRACE_POINT, function_id, OE_EDGER8R_TRACE_UNMARSHALLED);
+    check_event(i, TRACE_END, function_id, OE_OK);
+}
+
+/* Check the events of a forwarder up to the call of the user function. */
+static uint32_t check_forwarder_begin(
+    size_t& i,
+    const char* name,
+    bool ecall)
+{
+    uint32_t function_id = check_begin(i, name, ecall);
+    check_event(i, TRACE_POINT, function_id, OE_EDGER8R_TRACE_UNMARSHALLED);
+    OE_TEST(trace[i - 1].input_buffer_size > 0);
+    OE_TEST(trace[i - 1].output_buffer_size > 0);
+    return function_id;
+}
+
+static void check_forwarder_end(size_t& i, uint32_t function_id)
+{
+    check_event(i, TRACE_POINT, function_id, OE_EDGER8R_TRACE_RETURNED);
+    check_event(i, TRACE_POINT, function_id, OE_EDGER8R_TRACE_MARSHALLED);
+    check_event(i, TRACE_END, function_id, OE_OK);
+}
+
+#endif // TRACE_H
@@ -0,0 +1,52 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include <string.h>
+#include "length_t.h"
+
+void enc_read(uint8_t* buf, size_t cap, size_t* produced, size_t n)
+{
+    memset(buf, 0x11, cap);
+    *produced = n;
+}
+
+void enc_split(
+    uint32_t* values,
+    char* text,
+    size_t cap,
+    uint32_t* nvalues,
+    uint16_t* nbytes,
+    uint64_t* tail)
+{
+    for (size_t i = 0; i < cap; i++)
+        values[i] = (uint32_t)i;
+    memset(text, 'x', cap);
+    memcpy(text, "hello", 5);
+
+    /* The caller passes the number of bytes it wants. */
+    OE_TEST(*nbytes <= cap);
+    *nvalues = 3;
+    *tail = 0x1234567890abcdefULL;
+}
+
+void enc_run_ocalls()
+{
+    uint8_t buf[64];
+    size_t produced = 0;
+
+    memset(buf, 0xaa, sizeof(buf));
+    OE_TEST(ocall_read(buf, sizeof(buf), &produced, 10) == OE_OK);
+    OE_TEST(produced == 10);
+    for (size_t i = 0; i < sizeof(buf); i++)
+        OE_TEST(buf[i] == (i < 10 ? 0x22 : 0xaa));
+
+    /* Nothing is copied back without a length. */
+    memset(buf, 0xaa, sizeof(buf));
+    OE_TEST(ocall_read(buf, sizeof(buf), NULL, 10) == OE_OK);
+    for (size_t i = 0; i < sizeof(buf); i++)
+        OE_TEST(buf[i] == 0xaa);
+
+    /* A length beyond the capacity fails the call. */
+    OE_TEST(ocall_read(buf, sizeof(buf), &produced, 65) != OE_OK);
+}
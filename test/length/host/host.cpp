@@ -0,0 +1,90 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include "length_u.h"
+
+static oe_enclave_t* enclave;
+
+void ocall_read(uint8_t* buf, size_t cap, size_t* produced, size_t n)
+{
+    memset(buf, 0x22, cap);
+    if (produced)
+        *produced = n;
+}
+
+static void test_read()
+{
+    uint8_t buf[4096];
+    size_t produced = 0;
+
+    /* Only the produced bytes are copied back. */
+    memset(buf, 0xaa, sizeof(buf));
+    OE_TEST(enc_read(enclave, buf, sizeof(buf), &produced, 100) == OE_OK);
+    OE_TEST(produced == 100);
+    for (size_t i = 0; i < sizeof(buf); i++)
+        OE_TEST(buf[i] == (i < 100 ? 0x11 : 0xaa));
+
+    memset(buf, 0xaa, sizeof(buf));
+    OE_TEST(enc_read(enclave, buf, sizeof(buf), &produced, 0) == OE_OK);
+    OE_TEST(produced == 0);
+    OE_TEST(buf[0] == 0xaa);
+
+    OE_TEST(
+        enc_read(enclave, buf, sizeof(buf), &produced, sizeof(buf)) == OE_OK);
+    OE_TEST(produced == sizeof(buf));
+    OE_TEST(buf[sizeof(buf) - 1] == 0x11);
+
+    /* A length beyond the capacity fails the call. */
+    OE_TEST(
+        enc_read(enclave, buf, sizeof(buf), &produced, sizeof(buf) + 1) !=
+        OE_OK);
+}
+
+static void test_split()
+{
+    uint32_t values[16];
+    char text[16];
+    uint32_t nvalues = 0;
+    uint16_t nbytes = 5;
+    uint64_t tail = 0;
+
+    memset(values, 0xff, sizeof(values));
+    memset(text, '-', sizeof(text));
+    OE_TEST(
+        enc_split(enclave, values, text, 16, &nvalues, &nbytes, &tail) ==
+        OE_OK);
+    OE_TEST(nvalues == 3 && nbytes == 5);
+    OE_TEST(tail == 0x1234567890abcdefULL);
+    for (uint32_t i = 0; i < 16; i++)
+        OE_TEST(values[i] == (i < 3 ? i : 0xffffffff));
+    OE_TEST(memcmp(text, "hello-----------", 16) == 0);
+}
+
+int main(int argc, char** argv)
+{
+    const uint32_t flags = 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_length_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, flags, NULL, 0, &enclave) == OE_OK);
+
+    test_read();
+    test_split();
+    OE_TEST(enc_run_ocalls(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (length)\n");
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <openenclave/internal/tests.h>
+#include <stddef.h>
+#include <string.h>
+
+/* Include the generated code to check the layout of its structs. */
+#include "reorder_args_t.c"
+
+/* The fields that fit after oe_result come before the deepcopy fields. */
+static_assert(offsetof(enc_small_args_t, oe_retval) == 4, "oe_retval");
+static_assert(offsetof(enc_mixed_args_t, i) == 4, "i");
+static_assert(offsetof(host_mixed_args_t, ocall_errno) == 4, "ocall_errno");
+
+/* The sizes are 40, 104 and 64 bytes in parameter order. */
+static_assert(sizeof(enc_small_args_t) == 32, "enc_small_args_t");
+static_assert(sizeof(enc_mixed_args_t) == 88, "enc_mixed_args_t");
+static_assert(sizeof(host_mixed_args_t) == 56, "host_mixed_args_t");
+
+uint64_t enc_mixed(
+    char c,
+    uint64_t u,
+    short s,
+    int i,
+    double d,
+    int* values,
+    char* name,
+    point_t p,
+    color_t color,
+    bool flag)
+{
+    OE_TEST(c == 'c');
+    OE_TEST(u == 0x0123456789abcdefULL);
+    OE_TEST(s == -2);
+    OE_TEST(i == 3);
+    OE_TEST(d == 4.5);
+    OE_TEST(values[0] == 6 && values[1] == 7);
+    OE_TEST(strcmp(name, "reorder") == 0);
+    OE_TEST(p.x == 8 && p.y == 9);
+    OE_TEST(color == BLUE);
+    OE_TEST(flag);
+    return u + 1;
+}
+
+int enc_small(char a, short b, uint8_t c)
+{
+    return a + b + c;
+}
+
+void enc_call_host()
+{
+    short retval = 0;
+    int result = 0;
+    point_t p = {10, 11};
+
+    errno = 0;
+    OE_TEST(
+        host_mixed(&retval, 'h', 0xfedcba9876543210ULL, -3, &result, p) ==
+        OE_OK);
+    OE_TEST(retval == -4);
+    OE_TEST(result == 21);
+    OE_TEST(errno == 12);
+}
@@ -0,0 +1,63 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <openenclave/internal/tests.h>
+#include "reorder_args_u.h"
+
+short host_mixed(char c, uint64_t u, short s, int* result, point_t p)
+{
+    OE_TEST(c == 'h');
+    OE_TEST(u == 0xfedcba9876543210ULL);
+    OE_TEST(s == -3);
+    *result = p.x + p.y;
+    errno = 12;
+    return (short)(s - 1);
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+    uint64_t u = 0;
+    int small = 0;
+    int values[] = {6, 7};
+    char name[] = "reorder";
+    point_t p = {8, 9};
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_reorder_args_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, 0, NULL, 0, &enclave) == OE_OK);
+
+    OE_TEST(
+        enc_mixed(
+            enclave,
+            &u,
+            'c',
+            0x0123456789abcdefULL,
+            -2,
+            3,
+            4.5,
+            values,
+            name,
+            p,
+            BLUE,
+            true) == OE_OK);
+    OE_TEST(u == 0x0123456789abcdf0ULL);
+
+    OE_TEST(enc_small(enclave, &small, 1, 2, 3) == OE_OK);
+    OE_TEST(small == 6);
+
+    OE_TEST(enc_call_host(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+    printf("=== passed all tests (reorder_args)\n");
+    return 0;
+}
@@ -0,0 +1,45 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include <string.h>
+#include "stats_t.h"
+
+int enc_add(int a, int b)
+{
+    return a + b;
+}
+
+void enc_fill(uint8_t* buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+        buf[i] = (uint8_t)i;
+}
+
+void enc_hold(int* entered, int* release)
+{
+    __atomic_fetch_add(entered, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(release, __ATOMIC_ACQUIRE))
+        ;
+}
+
+void enc_check_ocall_stats()
+{
+    oe_call_stats_t stats[1];
+
+    OE_TEST(stats_get_call_stats(stats, 1) == 1);
+    OE_TEST(stats[0].calls == 0);
+
+    for (int i = 0; i < 3; i++)
+        OE_TEST(host_ping() == OE_OK);
+
+    OE_TEST(stats_get_call_stats(stats, 1) == 1);
+    OE_TEST(strcmp(stats[0].name, "host_ping") == 0);
+    OE_TEST(stats[0].calls == 3);
+    OE_TEST(stats[0].input_bytes > 0);
+    OE_TEST(stats[0].output_bytes > 0);
+
+    stats_reset_call_stats();
+    OE_TEST(stats_get_call_stats(stats, 1) == 1);
+    OE_TEST(stats[0].calls == 0);
+}
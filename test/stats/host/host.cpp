@@ -0,0 +1,117 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include <thread>
+#include "stats_u.h"
+
+#define NUM_ECALLS 4
+#define NUM_CALLS 100
+
+/* The ECALLs in the order of the EDL. */
+#define ENC_ADD 0
+#define ENC_FILL 1
+#define ENC_HOLD 2
+
+void host_ping()
+{
+}
+
+static uint64_t sum(const uint64_t* counters, size_t count)
+{
+    uint64_t total = 0;
+    for (size_t i = 0; i < count; i++)
+        total += counters[i];
+    return total;
+}
+
+int main(int argc, char** argv)
+{
+    oe_enclave_t* enclave = NULL;
+    oe_call_stats_t stats[NUM_ECALLS];
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_stats_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, 0, NULL, 0, &enclave) == OE_OK);
+
+    /* The table has one entry per ECALL. */
+    OE_TEST(stats_get_call_stats(NULL, 0) == NUM_ECALLS);
+    OE_TEST(stats_get_call_stats(stats, NUM_ECALLS) == NUM_ECALLS);
+    OE_TEST(strcmp(stats[ENC_ADD].name, "enc_add") == 0);
+    OE_TEST(strcmp(stats[ENC_FILL].name, "enc_fill") == 0);
+    OE_TEST(stats[ENC_ADD].calls == 0);
+
+    for (int i = 0; i < NUM_CALLS; i++)
+    {
+        int ret = 0;
+        OE_TEST(enc_add(enclave, &ret, i, 1) == OE_OK);
+        OE_TEST(ret == i + 1);
+    }
+
+    uint8_t buf[256];
+    OE_TEST(enc_fill(enclave, buf, sizeof(buf)) == OE_OK);
+
+    OE_TEST(stats_get_call_stats(stats, NUM_ECALLS) == NUM_ECALLS);
+    OE_TEST(stats[ENC_ADD].calls == NUM_CALLS);
+    OE_TEST(sum(stats[ENC_ADD].failures, OE_CALL_STATS_MAX_RESULTS) == 0);
+    OE_TEST(stats[ENC_ADD].input_bytes > 0);
+    OE_TEST(stats[ENC_ADD].input_bytes % NUM_CALLS == 0);
+    OE_TEST(
+        sum(stats[ENC_ADD].latency, OE_CALL_STATS_LATENCY_BUCKETS) ==
+        NUM_CALLS);
+    OE_TEST(stats[ENC_FILL].calls == 1);
+    OE_TEST(stats[ENC_FILL].output_bytes >= sizeof(buf));
+
+    /* A call rejected for lack of a TCS is counted by its result. */
+    {
+        int entered = 0;
+        int release = 0;
+        std::thread holder([&] {
+            OE_TEST(enc_hold(enclave, &entered, &release) == OE_OK);
+        });
+        while (!__atomic_load_n(&entered, __ATOMIC_ACQUIRE))
+            std::this_thread::yield();
+
+        int ret = 0;
+        OE_TEST(enc_add(enclave, &ret, 1, 1) == OE_OUT_OF_THREADS);
+
+        __atomic_store_n(&release, 1, __ATOMIC_RELEASE);
+        holder.join();
+    }
+    OE_TEST(stats_get_call_stats(stats, NUM_ECALLS) == NUM_ECALLS);
+    OE_TEST(stats[ENC_ADD].calls == NUM_CALLS + 1);
+    OE_TEST(stats[ENC_ADD].failures[OE_OUT_OF_THREADS] == 1);
+    OE_TEST(sum(stats[ENC_ADD].failures, OE_CALL_STATS_MAX_RESULTS) == 1);
+    OE_TEST(stats[ENC_HOLD].calls == 1);
+
+    /* Only the requested entries are copied. */
+    stats[ENC_FILL].calls = 0;
+    OE_TEST(stats_get_call_stats(stats, 1) == NUM_ECALLS);
+    OE_TEST(stats[ENC_FILL].calls == 0);
+
+    stats_reset_call_stats();
+    OE_TEST(stats_get_call_stats(stats, NUM_ECALLS) == NUM_ECALLS);
+    for (size_t i = 0; i < NUM_ECALLS; i++)
+    {
+        OE_TEST(stats[i].calls == 0);
+        OE_TEST(stats[i].input_bytes == 0);
+        OE_TEST(sum(stats[i].latency, OE_CALL_STATS_LATENCY_BUCKETS) == 0);
+    }
+
+    OE_TEST(enc_check_ocall_stats(enclave) == OE_OK);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (stats)\n");
+
+    return 0;
+}
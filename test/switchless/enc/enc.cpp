@@ -0,0 +1,28 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "switchless_t.h"
+
+int enc_add(int a, int b)
+{
+    return a + b;
+}
+
+void enc_call_host_add(int count)
+{
+    for (int i = 0; i < count; i++)
+    {
+        int sum = 0;
+        OE_TEST(host_add(&sum, i, 1) == OE_OK);
+        OE_TEST(sum == i + 1);
+    }
+}
+
+int enc_chain(int depth)
+{
+    int result = 0;
+    if (depth > 0)
+        OE_TEST(host_chain(&result, depth - 1) == OE_OK);
+    return result + 1;
+}
@@ -0,0 +1,136 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+
+#include <openenclave/internal/switchless.h>
+#include <openenclave/internal/tests.h>
+#include <thread>
+#include <vector>
+#include "switchless_u.h"
+
+#define NUM_THREADS 4
+#define NUM_CALLS 1000
+#define CHAIN_DEPTH 4
+
+static oe_enclave_t* _enclave;
+
+int host_add(int a, int b)
+{
+    return a + b;
+}
+
+int host_chain(int depth)
+{
+    int result = 0;
+    if (depth > 0)
+        OE_TEST(enc_chain(_enclave, &result, depth - 1) == OE_OK);
+    return result + 1;
+}
+
+static void call_enc_add(oe_enclave_t* enclave)
+{
+    for (int i = 0; i < NUM_CALLS; i++)
+    {
+        int sum = 0;
+        OE_TEST(enc_add(enclave, &sum, i, 1) == OE_OK);
+        OE_TEST(sum == i + 1);
+    }
+}
+
+static oe_enclave_t* create_enclave(
+    const char* path,
+    size_t host_workers,
+    size_t enclave_workers)
+{
+    oe_enclave_t* enclave = NULL;
+    oe_enclave_setting_context_switchless_t switchless_setting = {
+        host_workers, enclave_workers};
+    oe_enclave_setting_t setting;
+    setting.setting_type = OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS;
+    setting.u.context_switchless_setting = &switchless_setting;
+
+    OE_TEST(
+        oe_create_switchless_enclave(
+            path, OE_ENCLAVE_TYPE_SGX, 0, &setting, 1, &enclave) == OE_OK);
+    return enclave;
+}
+
+int main(int argc, char** argv)
+{
+    oe_switchless_stats_t ecalls;
+    oe_switchless_stats_t ocalls;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    /* The calls are run by the workers. */
+    {
+        oe_enclave_t* enclave = create_enclave(argv[1], 2, 2);
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < NUM_THREADS; i++)
+            threads.emplace_back(call_enc_add, enclave);
+        for (std::thread& thread : threads)
+            thread.join();
+        OE_TEST(enc_call_host_add(enclave, NUM_CALLS) == OE_OK);
+
+        OE_TEST(oe_get_switchless_stats(enclave, &ecalls, &ocalls) == OE_OK);
+        OE_TEST(ecalls.workers == 2);
+        OE_TEST(ecalls.calls == NUM_THREADS * NUM_CALLS);
+        OE_TEST(ecalls.fallbacks == 0);
+        OE_TEST(ecalls.occupancy == 0);
+        OE_TEST(ecalls.max_occupancy >= 1);
+        OE_TEST(ecalls.max_occupancy <= NUM_THREADS);
+        OE_TEST(ocalls.workers == 2);
+        OE_TEST(ocalls.calls == NUM_CALLS);
+        OE_TEST(ocalls.fallbacks == 0);
+
+        OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+    }
+
+    /*
+     * Calls made by the workers fall back to regular calls, so a chain of
+     * switchless calls completes with a single worker on each side.
+     */
+    {
+        _enclave = create_enclave(argv[1], 1, 1);
+
+        int result = 0;
+        OE_TEST(enc_chain(_enclave, &result, CHAIN_DEPTH) == OE_OK);
+        OE_TEST(result == CHAIN_DEPTH + 1);
+
+        OE_TEST(oe_get_switchless_stats(_enclave, &ecalls, &ocalls) == OE_OK);
+        OE_TEST(ecalls.calls == 1);
+        OE_TEST(ecalls.fallbacks == CHAIN_DEPTH / 2);
+        OE_TEST(ocalls.calls == 0);
+        OE_TEST(ocalls.fallbacks == CHAIN_DEPTH / 2);
+
+        OE_TEST(oe_terminate_enclave(_enclave) == OE_OK);
+    }
+
+    /* Without workers the calls fall back to regular calls. */
+    {
+        oe_enclave_t* enclave = create_enclave(argv[1], 0, 0);
+
+        call_enc_add(enclave);
+        OE_TEST(enc_call_host_add(enclave, NUM_CALLS) == OE_OK);
+
+        OE_TEST(oe_get_switchless_stats(enclave, &ecalls, &ocalls) == OE_OK);
+        OE_TEST(ecalls.workers == 0);
+        OE_TEST(ecalls.calls == 0);
+        OE_TEST(ecalls.fallbacks == NUM_CALLS);
+        OE_TEST(ocalls.calls == 0);
+        OE_TEST(ocalls.fallbacks == NUM_CALLS);
+
+        OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+    }
+
+    OE_TEST(oe_get_switchless_stats(NULL, &ecalls, &ocalls) ==
+            OE_INVALID_PARAMETER);
+
+    printf("=== passed all tests (switchless)\n");
+}
@@ -0,0 +1,24 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "tcs_t.h"
+
+int enc_add(int a, int b)
+{
+    return a + b;
+}
+
+int enc_nested(int a, int b)
+{
+    int sum = 0;
+    OE_TEST(host_add(&sum, a, b) == OE_OK);
+    return sum;
+}
+
+void enc_hold(int* entered, int* release)
+{
+    __atomic_add_fetch(entered, 1, __ATOMIC_RELEASE);
+    while (!__atomic_load_n(release, __ATOMIC_ACQUIRE))
+        ;
+}
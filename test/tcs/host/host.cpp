@@ -0,0 +1,125 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <openenclave/internal/tests.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "tcs_u.h"
+
+#define NUM_THREADS 16
+#define NUM_CALLS 1000
+
+static oe_enclave_t* enclave;
+
+/* Called by enc_nested, which already holds a TCS. */
+int host_add(int a, int b)
+{
+    int sum = 0;
+    OE_TEST(enc_add(enclave, &sum, a, b) == OE_OK);
+    return sum;
+}
+
+static void call_enc_add()
+{
+    for (int i = 0; i < NUM_CALLS; i++)
+    {
+        int sum = 0;
+        OE_TEST(enc_add(enclave, &sum, i, 1) == OE_OK);
+        OE_TEST(sum == i + 1);
+    }
+}
+
+static int env(const char* name)
+{
+    const char* value = getenv(name);
+    return value ? atoi(value) : 0;
+}
+
+int main(int argc, char** argv)
+{
+    const int num_tcs = env("OE_VIRTUAL_NUM_TCS");
+    const bool tcs_wait = env("OE_VIRTUAL_TCS_WAIT") != 0;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "Usage: %s ENCLAVE_PATH\n", argv[0]);
+        return 1;
+    }
+
+    OE_TEST(
+        oe_create_tcs_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, 0, NULL, 0, &enclave) == OE_OK);
+
+    /* Concurrent ecalls, up to the number of TCSs unless they wait. */
+    {
+        int num_threads =
+            (num_tcs && !tcs_wait && num_tcs < NUM_THREADS) ? num_tcs
+                                                            : NUM_THREADS;
+        std::vector<std::thread> threads;
+        for (int i = 0; i < num_threads; i++)
+            threads.emplace_back(call_enc_add);
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+
+    if (num_tcs)
+    {
+        int entered = 0;
+        int release = 0;
+
+        auto hold = [&] {
+            OE_TEST(enc_hold(enclave, &entered, &release) == OE_OK);
+        };
+
+        /* A nested ecall does not take another TCS. */
+        std::vector<std::thread> holders;
+        for (int i = 0; i < num_tcs - 1; i++)
+            holders.emplace_back(hold);
+        while (__atomic_load_n(&entered, __ATOMIC_ACQUIRE) != num_tcs - 1)
+            std::this_thread::yield();
+        int sum = 0;
+        OE_TEST(enc_nested(enclave, &sum, 2, 3) == OE_OK);
+        OE_TEST(sum == 5);
+
+        /* Take the last TCS. */
+        holders.emplace_back(hold);
+        while (__atomic_load_n(&entered, __ATOMIC_ACQUIRE) != num_tcs)
+            std::this_thread::yield();
+
+        if (tcs_wait)
+        {
+            /* The ecall waits for a TCS to be released. */
+            std::atomic<bool> done(false);
+            std::thread waiter([&] {
+                int s = 0;
+                OE_TEST(enc_add(enclave, &s, 1, 1) == OE_OK);
+                OE_TEST(s == 2);
+                done = true;
+            });
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            OE_TEST(!done);
+            __atomic_store_n(&release, 1, __ATOMIC_RELEASE);
+            waiter.join();
+            OE_TEST(done);
+        }
+        else
+        {
+            /* The ecall fails like on SGX. */
+            OE_TEST(enc_add(enclave, &sum, 1, 1) == OE_OUT_OF_THREADS);
+            __atomic_store_n(&release, 1, __ATOMIC_RELEASE);
+        }
+
+        for (std::thread& holder : holders)
+            holder.join();
+        OE_TEST(enc_add(enclave, &sum, 1, 1) == OE_OK);
+    }
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (tcs)\n");
+}
@@ -0,0 +1,32 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/internal/tests.h>
+#include "trace_t.h"
+
+int enc_outer(int x)
+{
+    int ret = 0;
+    OE_TEST(host_middle(&ret, x) == OE_OK);
+    return ret + 1;
+}
+
+int enc_inner(int x)
+{
+    return x * 2;
+}
+
+/* Switchless ocalls made by an enclave worker fall back to regular ones. */
+int enc_switchless(int x)
+{
+    int ret = 0;
+    OE_TEST(host_switchless(&ret, x) == OE_OK);
+    return ret;
+}
+
+int enc_call_host_switchless(int x)
+{
+    int ret = 0;
+    OE_TEST(host_switchless(&ret, x) == OE_OK);
+    return ret;
+}
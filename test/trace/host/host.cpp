@@ -0,0 +1,185 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <openenclave/internal/tests.h>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "trace_u.h"
+
+/*
+ * Run with OE_VIRTUAL_TRACE set to record a trace, which the runtime writes
+ * at exit, then with --check FILE to check the spans in it.
+ */
+
+static oe_enclave_t* enclave;
+
+int host_middle(int x)
+{
+    int ret = 0;
+    OE_TEST(enc_inner(enclave, &ret, x) == OE_OK);
+    return ret;
+}
+
+int host_switchless(int x)
+{
+    return x;
+}
+
+struct Span
+{
+    std::string name;
+    std::string category;
+    double ts;
+    double dur;
+    unsigned long long tid;
+    unsigned long long input_buffer_size;
+    unsigned long long allocations;
+};
+
+/* Each event is written on its own line. */
+static std::string field(const std::string& line, const std::string& key)
+{
+    size_t pos = line.find("\"" + key + "\": ");
+    OE_TEST(pos != std::string::npos);
+    pos += key.size() + 4;
+    if (line[pos] == '"')
+        return line.substr(pos + 1, line.find('"', pos + 1) - pos - 1);
+    return line.substr(pos, line.find_first_of(",}", pos) - pos);
+}
+
+static std::vector<Span> read_trace(const char* path)
+{
+    std::vector<Span> spans;
+    std::ifstream file(path);
+    std::string line;
+    OE_TEST(file.good());
+    while (std::getline(file, line))
+    {
+        if (line.find("\"ph\": \"X\"") == std::string::npos)
+            continue;
+        Span span;
+        span.name = field(line, "name");
+        span.category = field(line, "cat");
+        span.ts = atof(field(line, "ts").c_str());
+        span.dur = atof(field(line, "dur").c_str());
+        span.tid = strtoull(field(line, "tid").c_str(), NULL, 10);
+        span.input_buffer_size =
+            strtoull(field(line, "input_buffer_size").c_str(), NULL, 10);
+        span.allocations =
+            strtoull(field(line, "allocations").c_str(), NULL, 10);
+        spans.push_back(span);
+    }
+    return spans;
+}
+
+static const Span& find(
+    const std::vector<Span>& spans,
+    const char* name,
+    const char* category)
+{
+    for (const Span& span : spans)
+        if (span.name == name && span.category == category)
+            return span;
+    fprintf(stderr, "error: no %s span %s\n", category, name);
+    exit(1);
+}
+
+static size_t count(
+    const std::vector<Span>& spans,
+    const char* name,
+    const char* category)
+{
+    size_t n = 0;
+    for (const Span& span : spans)
+        if (span.name == name && span.category == category)
+            n++;
+    return n;
+}
+
+/* ts and dur are rounded to nanoseconds separately. */
+static bool contains(const Span& outer, const Span& inner)
+{
+    return outer.tid == inner.tid && outer.ts <= inner.ts + 0.002 &&
+           inner.ts + inner.dur <= outer.ts + outer.dur + 0.002;
+}
+
+static void check(const char* path)
+{
+    std::vector<Span> spans = read_trace(path);
+
+    /* An ecall, the ocall it makes and the ecall that one makes nest on
+     * the same thread. The ocalls are shown by id. */
+    const Span& outer = find(spans, "enc_outer", "ecall");
+    const Span& middle = find(spans, "ocall 0", "ocall");
+    const Span& inner = find(spans, "enc_inner", "ecall");
+    OE_TEST(contains(outer, middle));
+    OE_TEST(contains(middle, inner));
+    OE_TEST(outer.input_buffer_size > 0);
+    OE_TEST(inner.allocations > 0);
+    OE_TEST(outer.allocations > inner.allocations);
+
+    /* The switchless calls are run by the workers. */
+    const Span& switchless_ecall =
+        find(spans, "enc_switchless", "switchless_ecall");
+    OE_TEST(find(spans, "enc_switchless", "ecall").tid != switchless_ecall.tid);
+    const Span& switchless_ocall = find(spans, "ocall 1", "switchless_ocall");
+    OE_TEST(count(spans, "ocall 1", "switchless_ocall") == 1);
+
+    /* The ocall of the enclave worker falls back without a switchless span,
+     * so one ocall span runs on a host worker and one on the caller. */
+    OE_TEST(count(spans, "ocall 1", "ocall") == 2);
+    size_t on_caller = 0;
+    for (const Span& span : spans)
+        if (span.name == "ocall 1" && span.category == "ocall" &&
+            span.tid == switchless_ocall.tid)
+            on_caller++;
+    OE_TEST(on_caller == 0);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc == 3 && strcmp(argv[1], "--check") == 0)
+    {
+        check(argv[2]);
+        printf("=== passed all tests (trace)\n");
+        return 0;
+    }
+
+    if (argc != 2)
+    {
+        fprintf(
+            stderr,
+            "Usage: %s ENCLAVE_PATH\n"
+            "       %s --check TRACE_FILE\n",
+            argv[0],
+            argv[0]);
+        return 1;
+    }
+
+    oe_enclave_setting_context_switchless_t switchless_setting = {1, 1};
+    oe_enclave_setting_t setting;
+    setting.setting_type = OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS;
+    setting.u.context_switchless_setting = &switchless_setting;
+    OE_TEST(
+        oe_create_trace_enclave(
+            argv[1], OE_ENCLAVE_TYPE_SGX, 0, &setting, 1, &enclave) == OE_OK);
+
+    int ret = 0;
+    OE_TEST(enc_outer(enclave, &ret, 3) == OE_OK);
+    OE_TEST(ret == 7);
+    OE_TEST(enc_switchless(enclave, &ret, 5) == OE_OK);
+    OE_TEST(ret == 5);
+    OE_TEST(enc_call_host_switchless(enclave, &ret, 6) == OE_OK);
+    OE_TEST(ret == 6);
+
+    OE_TEST(oe_terminate_enclave(enclave) == OE_OK);
+
+    printf("=== passed all tests (trace)\n");
+
+    return 0;
+}
@@ -0,0 +1,155 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "call_pool.h"
+
+#include <condition_variable>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <new>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+struct _oe_call
+{
+    oe_call_async_func_t func;
+    void* context;
+    oe_result_t result;
+    bool done;
+};
+
+namespace
+{
+/*
+ * Worker threads that run the posted asynchronous calls in the order they
+ * were posted. The workers are started by the first call. Their number is
+ * read from OE_VIRTUAL_CALL_WORKERS and defaults to 4.
+ */
+class CallPool
+{
+    std::mutex _lock;
+    std::condition_variable _posted;
+    std::condition_variable _completed;
+    std::deque<oe_call_handle_t> _queue;
+    std::vector<std::thread> _workers;
+    bool _stop = false;
+
+  public:
+    ~CallPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            _stop = true;
+        }
+        _posted.notify_all();
+        for (std::thread& worker : _workers)
+            worker.join();
+    }
+
+    bool post(oe_call_handle_t call)
+    {
+        {
+            std::lock_guard<std::mutex> lock(_lock);
+            if (_workers.empty() && !start())
+                return false;
+            _queue.push_back(call);
+        }
+        _posted.notify_one();
+        return true;
+    }
+
+    void wait(oe_call_handle_t call)
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        _completed.wait(lock, [call] { return call->done; });
+    }
+
+    bool poll(oe_call_handle_t call)
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        return call->done;
+    }
+
+  private:
+    bool start()
+    {
+        size_t count = 4;
+        const char* env = getenv("OE_VIRTUAL_CALL_WORKERS");
+        if (env && atoi(env) > 0)
+            count = static_cast<size_t>(atoi(env));
+        try
+        {
+            for (size_t i = 0; i < count; i++)
+                _workers.emplace_back(&CallPool::run, this);
+        }
+        catch (const std::system_error&)
+        {
+        }
+        return !_workers.empty();
+    }
+
+    void run()
+    {
+        std::unique_lock<std::mutex> lock(_lock);
+        while (true)
+        {
+            _posted.wait(lock, [this] { return _stop || !_queue.empty(); });
+            if (_queue.empty())
+                return;
+            oe_call_handle_t call = _queue.front();
+            _queue.pop_front();
+
+            lock.unlock();
+            oe_result_t result = call->func(call->context);
+            lock.lock();
+
+            call->result = result;
+            call->done = true;
+            _completed.notify_all();
+        }
+    }
+};
+
+CallPool _pool;
+} // namespace
+
+oe_call_handle_t oe_virtual_call_post(
+    oe_call_async_func_t func,
+    void* context)
+{
+    if (!func)
+        return nullptr;
+
+    oe_call_handle_t call =
+        new (std::nothrow) _oe_call{func, context, OE_FAILURE, false};
+    if (call && !_pool.post(call))
+    {
+        delete call;
+        call = nullptr;
+    }
+    return call;
+}
+
+extern "C"
+{
+    oe_result_t oe_call_wait(oe_call_handle_t handle)
+    {
+        if (!handle)
+            return OE_INVALID_PARAMETER;
+
+        _pool.wait(handle);
+        oe_result_t result = handle->result;
+        delete handle;
+        return result;
+    }
+
+    oe_result_t oe_call_poll(oe_call_handle_t handle)
+    {
+        if (!handle)
+            return OE_INVALID_PARAMETER;
+
+        return _pool.poll(handle) ? OE_OK : OE_BUSY;
+    }
+}
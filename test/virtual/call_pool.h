@@ -0,0 +1,17 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef CALL_POOL_H
+#define CALL_POOL_H
+
+#include <openenclave/edger8r/common.h>
+
+/*
+ * Run func(context) on one of the host worker threads that run the
+ * asynchronous ECALLs. The host implements oe_call_post with it.
+ */
+oe_call_handle_t oe_virtual_call_post(
+    oe_call_async_func_t func,
+    void* context);
+
+#endif
@@ -0,0 +1,120 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/edger8r/common.h>
+
+#include <chrono>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/*
+ * The counters are plain fields of a C struct, so they are updated with
+ * relaxed atomic operations on their addresses. Calls only add to them, and
+ * readers only need each counter to be read whole.
+ */
+static void _add(uint64_t* counter, uint64_t value)
+{
+#if defined(_MSC_VER)
+    _InterlockedExchangeAdd64((volatile long long*)counter, (long long)value);
+#else
+    __atomic_fetch_add(counter, value, __ATOMIC_RELAXED);
+#endif
+}
+
+static uint64_t _load(const uint64_t* counter)
+{
+#if defined(_MSC_VER)
+    return *(const volatile uint64_t*)counter;
+#else
+    return __atomic_load_n(counter, __ATOMIC_RELAXED);
+#endif
+}
+
+static void _store(uint64_t* counter, uint64_t value)
+{
+#if defined(_MSC_VER)
+    *(volatile uint64_t*)counter = value;
+#else
+    __atomic_store_n(counter, value, __ATOMIC_RELAXED);
+#endif
+}
+
+static size_t _latency_bucket(uint64_t ns)
+{
+    size_t bucket = 0;
+    while (ns > 1 && bucket < OE_CALL_STATS_LATENCY_BUCKETS - 1)
+    {
+        ns >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+extern "C"
+{
+    uint64_t oe_call_stats_begin(void)
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch())
+            .count();
+    }
+
+    void oe_call_stats_end(
+        oe_call_stats_t* stats,
+        uint64_t begin,
+        oe_result_t result,
+        size_t input_bytes,
+        size_t output_bytes,
+        size_t deepcopy_bytes)
+    {
+        uint64_t end = oe_call_stats_begin();
+        _add(&stats->calls, 1);
+        if (result != OE_OK)
+        {
+            size_t index = (size_t)result < OE_CALL_STATS_MAX_RESULTS
+                               ? (size_t)result
+                               : OE_CALL_STATS_MAX_RESULTS - 1;
+            _add(&stats->failures[index], 1);
+        }
+        _add(&stats->input_bytes, input_bytes);
+        _add(&stats->output_bytes, output_bytes);
+        _add(&stats->deepcopy_bytes, deepcopy_bytes);
+        _add(&stats->latency[_latency_bucket(end - begin)], 1);
+    }
+
+    void oe_call_stats_copy(
+        oe_call_stats_t* dst,
+        const oe_call_stats_t* src,
+        size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            dst[i].name = src[i].name;
+            dst[i].calls = _load(&src[i].calls);
+            for (size_t j = 0; j < OE_CALL_STATS_MAX_RESULTS; j++)
+                dst[i].failures[j] = _load(&src[i].failures[j]);
+            dst[i].input_bytes = _load(&src[i].input_bytes);
+            dst[i].output_bytes = _load(&src[i].output_bytes);
+            dst[i].deepcopy_bytes = _load(&src[i].deepcopy_bytes);
+            for (size_t j = 0; j < OE_CALL_STATS_LATENCY_BUCKETS; j++)
+                dst[i].latency[j] = _load(&src[i].latency[j]);
+        }
+    }
+
+    void oe_call_stats_reset(oe_call_stats_t* stats, size_t count)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            _store(&stats[i].calls, 0);
+            for (size_t j = 0; j < OE_CALL_STATS_MAX_RESULTS; j++)
+                _store(&stats[i].failures[j], 0);
+            _store(&stats[i].input_bytes, 0);
+            _store(&stats[i].output_bytes, 0);
+            _store(&stats[i].deepcopy_bytes, 0);
+            for (size_t j = 0; j < OE_CALL_STATS_LATENCY_BUCKETS; j++)
+                _store(&stats[i].latency[j], 0);
+        }
+    }
+}
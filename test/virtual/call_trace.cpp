@@ -0,0 +1,228 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "call_trace.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace
+{
+struct Span
+{
+    const char* category;
+    const char* name;
+    uint64_t function_id;
+    uint64_t begin_ns;
+    uint64_t end_ns;
+    size_t input_buffer_size;
+    size_t output_buffer_size;
+    uint64_t allocations;
+    oe_result_t result;
+};
+
+/*
+ * The closed spans are appended to chunks that are never moved or freed.
+ * The writer publishes each span by a release store of the count, so the
+ * spans can be read while threads are still running.
+ */
+struct Chunk
+{
+    Span spans[1024];
+    std::atomic<size_t> count;
+    std::atomic<Chunk*> next;
+
+    Chunk() : count(0), next(nullptr)
+    {
+    }
+};
+
+/* The spans of one thread. Only that thread writes to it. */
+struct ThreadBuffer
+{
+    uint64_t tid;
+    Chunk* head;
+    Chunk* tail;
+    /* The open spans, innermost last. */
+    std::vector<Span> open;
+    /* The allocations made by the thread so far. */
+    uint64_t allocations;
+    ThreadBuffer* next;
+
+    explicit ThreadBuffer(uint64_t id)
+        : tid(id), head(new Chunk), tail(head), allocations(0), next(nullptr)
+    {
+    }
+
+    void append(const Span& span)
+    {
+        size_t count = tail->count.load(std::memory_order_relaxed);
+        if (count == sizeof(tail->spans) / sizeof(tail->spans[0]))
+        {
+            Chunk* chunk = new Chunk;
+            tail->next.store(chunk, std::memory_order_release);
+            tail = chunk;
+            count = 0;
+        }
+        tail->spans[count] = span;
+        tail->count.store(count + 1, std::memory_order_release);
+    }
+};
+
+class Recorder : public CallTrace
+{
+    std::string _path;
+    std::chrono::steady_clock::time_point _start;
+    /* The buffers of all the threads, pushed to the front of the list. */
+    std::atomic<ThreadBuffer*> _buffers;
+    std::atomic<uint64_t> _num_threads;
+
+  public:
+    explicit Recorder(const char* path)
+        : _path(path), _start(std::chrono::steady_clock::now()),
+          _buffers(nullptr), _num_threads(0)
+    {
+    }
+
+    void begin(
+        const char* category,
+        const char* name,
+        uint64_t function_id,
+        size_t input_buffer_size,
+        size_t output_buffer_size) override
+    {
+        ThreadBuffer* buffer = thread_buffer();
+        buffer->open.push_back({category,
+                                name,
+                                function_id,
+                                now(),
+                                0,
+                                input_buffer_size,
+                                output_buffer_size,
+                                buffer->allocations,
+                                OE_OK});
+    }
+
+    void end(oe_result_t result) override
+    {
+        ThreadBuffer* buffer = thread_buffer();
+        if (buffer->open.empty())
+            return;
+
+        Span span = buffer->open.back();
+        buffer->open.pop_back();
+        span.end_ns = now();
+        span.allocations = buffer->allocations - span.allocations;
+        span.result = result;
+        buffer->append(span);
+    }
+
+    void allocation() override
+    {
+        thread_buffer()->allocations++;
+    }
+
+    /* Write the closed spans as complete events, which nest by time. */
+    void dump()
+    {
+        FILE* file = fopen(_path.c_str(), "w");
+        if (!file)
+        {
+            fprintf(stderr, "error: cannot open %s\n", _path.c_str());
+            return;
+        }
+
+        const char* separator = "";
+        fprintf(file, "{\"traceEvents\": [");
+        for (ThreadBuffer* buffer = _buffers.load(std::memory_order_acquire);
+             buffer;
+             buffer = buffer->next)
+        {
+            for (Chunk* chunk = buffer->head; chunk;
+                 chunk = chunk->next.load(std::memory_order_acquire))
+            {
+                size_t count = chunk->count.load(std::memory_order_acquire);
+                for (size_t i = 0; i < count; i++)
+                {
+                    fprintf(file, "%s\n  ", separator);
+                    write_span(file, buffer->tid, chunk->spans[i]);
+                    separator = ",";
+                }
+            }
+        }
+        fprintf(file, "\n], \"displayTimeUnit\": \"ns\"}\n");
+        fclose(file);
+    }
+
+  private:
+    uint64_t now() const
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now() - _start)
+            .count();
+    }
+
+    ThreadBuffer* thread_buffer()
+    {
+        thread_local ThreadBuffer* buffer;
+        if (!buffer)
+        {
+            buffer = new ThreadBuffer(
+                _num_threads.fetch_add(1, std::memory_order_relaxed) + 1);
+            buffer->next = _buffers.load(std::memory_order_relaxed);
+            while (!_buffers.compare_exchange_weak(
+                buffer->next, buffer, std::memory_order_release))
+                ;
+        }
+        return buffer;
+    }
+
+    static void write_span(FILE* file, uint64_t tid, const Span& span)
+    {
+        std::string name = span.name
+                               ? span.name
+                               : "ocall " + std::to_string(span.function_id);
+        fprintf(
+            file,
+            "{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", "
+            "\"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, \"tid\": %llu, "
+            "\"args\": {\"input_buffer_size\": %zu, "
+            "\"output_buffer_size\": %zu, \"allocations\": %llu, "
+            "\"result\": %u}}",
+            name.c_str(),
+            span.category,
+            span.begin_ns / 1000.0,
+            (span.end_ns - span.begin_ns) / 1000.0,
+            (unsigned long long)tid,
+            span.input_buffer_size,
+            span.output_buffer_size,
+            (unsigned long long)span.allocations,
+            (unsigned)span.result);
+    }
+};
+
+Recorder* _recorder;
+
+void _dump_recorder()
+{
+    _recorder->dump();
+}
+} // namespace
+
+CallTrace* oe_virtual_call_trace()
+{
+    /* The recorder is never deleted since threads may still use it. */
+    static CallTrace* trace = []() -> CallTrace* {
+        const char* path = getenv("OE_VIRTUAL_TRACE");
+        if (!path || !*path)
+            return nullptr;
+        _recorder = new Recorder(path);
+        atexit(_dump_recorder);
+        return _recorder;
+    }();
+    return trace;
+}
@@ -0,0 +1,45 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef CALL_TRACE_H
+#define CALL_TRACE_H
+
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+/*
+ * Records the ecalls and ocalls of each thread as nested spans. The host
+ * creates the recorder and hands it to the enclaves; the methods are virtual
+ * so that the enclave library records into the host's per-thread buffers.
+ */
+class CallTrace
+{
+  public:
+    virtual ~CallTrace() = default;
+
+    /*
+     * Open a span on the calling thread. Calls without a name, the ocalls,
+     * are shown by function id.
+     */
+    virtual void begin(
+        const char* category,
+        const char* name,
+        uint64_t function_id,
+        size_t input_buffer_size,
+        size_t output_buffer_size) = 0;
+
+    /* Close the innermost open span of the calling thread. */
+    virtual void end(oe_result_t result) = 0;
+
+    /* Count an allocation of enclave memory in the open spans. */
+    virtual void allocation() = 0;
+};
+
+/*
+ * The recorder of the process, or null unless OE_VIRTUAL_TRACE names the
+ * file that the spans are written to at exit, as Chrome trace-event JSON.
+ * Only available on the host side.
+ */
+CallTrace* oe_virtual_call_trace();
+
+#endif
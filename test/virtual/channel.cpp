@@ -0,0 +1,110 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include "channel.h"
+
+#include <string.h>
+
+/*
+ * The indexes are plain fields of a C struct shared by the two sides, so
+ * they are accessed with atomic operations on their addresses. The release
+ * store of an index publishes the records written or frees the records read
+ * before it.
+ */
+static uint64_t _load(const uint64_t* index)
+{
+#if defined(_MSC_VER)
+    return *(const volatile uint64_t*)index;
+#else
+    return __atomic_load_n(index, __ATOMIC_ACQUIRE);
+#endif
+}
+
+static void _store(uint64_t* index, uint64_t value)
+{
+#if defined(_MSC_VER)
+    *(volatile uint64_t*)index = value;
+#else
+    __atomic_store_n(index, value, __ATOMIC_RELEASE);
+#endif
+}
+
+static uint8_t* _records(oe_channel_t* channel)
+{
+    return (uint8_t*)(channel->ring + 1);
+}
+
+size_t oe_virtual_channel_send(
+    oe_channel_t* channel,
+    const void* records,
+    size_t count,
+    void* (*copy)(void* dest, const void* src, size_t count))
+{
+    if (!channel->ring || !channel->capacity)
+        return 0;
+
+    /* The consumer cannot be ahead of the producer or behind the records it
+     * has not read yet. */
+    uint64_t head = _load(&channel->ring->head);
+    uint64_t used = channel->tail - head;
+    if (used > channel->capacity)
+        return 0;
+
+    size_t n = channel->capacity - (size_t)used;
+    if (n > count)
+        n = count;
+
+    /* Copy in up to two parts since the records may wrap around. */
+    size_t size = channel->record_size;
+    size_t index = (size_t)(channel->tail % channel->capacity);
+    size_t first = channel->capacity - index < n
+                       ? channel->capacity - index
+                       : n;
+    copy(_records(channel) + index * size, records, first * size);
+    copy(
+        _records(channel),
+        (const uint8_t*)records + first * size,
+        (n - first) * size);
+
+    channel->tail += n;
+    _store(&channel->ring->tail, channel->tail);
+    return n;
+}
+
+extern "C"
+{
+    size_t oe_channel_receive(
+        oe_channel_t* channel,
+        void* records,
+        size_t count)
+    {
+        if (!channel->ring || !channel->capacity)
+            return 0;
+
+        /* The producer cannot be behind the consumer or ahead of the records
+         * the consumer has not freed yet. */
+        uint64_t tail = _load(&channel->ring->tail);
+        uint64_t used = tail - channel->head;
+        if (used > channel->capacity)
+            return 0;
+
+        size_t n = (size_t)used;
+        if (n > count)
+            n = count;
+
+        size_t size = channel->record_size;
+        size_t index = (size_t)(channel->head % channel->capacity);
+        size_t first = channel->capacity - index < n
+                           ? channel->capacity - index
+                           : n;
+        memcpy(records, _records(channel) + index * size, first * size);
+        memcpy(
+            (uint8_t*)records + first * size,
+            _records(channel),
+            (n - first) * size);
+
+        channel->head += n;
+        _store(&channel->ring->head, channel->head);
+        return n;
+    }
+}
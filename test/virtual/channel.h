@@ -0,0 +1,20 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <openenclave/edger8r/common.h>
+
+/*
+ * Append up to count records to the ring of the channel with copy. The
+ * enclave implements oe_channel_send with oe_memcpy_with_barrier, since its
+ * records go to host memory, and the host with memcpy.
+ */
+size_t oe_virtual_channel_send(
+    oe_channel_t* channel,
+    const void* records,
+    size_t count,
+    void* (*copy)(void* dest, const void* src, size_t count));
+
+#endif
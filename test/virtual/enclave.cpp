@@ -2,13 +2,15 @@
 // Licensed under the MIT License.
 
 #include <openenclave/edger8r/enclave.h>
+#include "channel.h"
 #include "enclave_impl.h"
 
 #include <map>
 
 extern "C"
 {
-    oe_enclave_t* _enclave;
+    /* The enclave whose ecall the thread is running. */
+    thread_local oe_enclave_t* _enclave;
 
     extern "C" oe_ecall_func_t oe_ecalls_table[];
     extern "C" size_t oe_ecalls_table_size;
@@ -68,6 +70,17 @@ extern "C"
         return _enclave->free(ptr);
     }
 
+    /* Host memory is whatever the enclave did not allocate. */
+    void* oe_host_malloc(size_t size)
+    {
+        return ::malloc(size);
+    }
+
+    void oe_host_free(void* ptr)
+    {
+        ::free(ptr);
+    }
+
     void oe_memcpy_aligned(void* dest, const void* src, size_t count)
     {
         memcpy(dest, src, count);
@@ -78,6 +91,16 @@ extern "C"
         return memcpy(dest, src, count);
     }
 
+    /* The records are written to the ring in host memory. */
+    size_t oe_channel_send(
+        oe_channel_t* channel,
+        const void* records,
+        size_t count)
+    {
+        return oe_virtual_channel_send(
+            channel, records, count, oe_memcpy_with_barrier);
+    }
+
     oe_result_t oe_call_host_function(
         size_t function_id,
         const void* input_buffer,
@@ -86,6 +109,15 @@ extern "C"
         size_t output_buffer_size,
         size_t* output_bytes_written)
     {
+        CallTrace* trace = _enclave->_trace;
+        if (trace)
+            trace->begin(
+                "ocall",
+                nullptr,
+                function_id,
+                input_buffer_size,
+                output_buffer_size);
+
         _enclave->_ocall_table[function_id](
             reinterpret_cast<const uint8_t*>(input_buffer),
             input_buffer_size,
@@ -107,7 +139,11 @@ extern "C"
             free(args->deepcopy_out_buffer);
             args->deepcopy_out_buffer = enclave_buffer;
         }
-        return *reinterpret_cast<oe_result_t*>(output_buffer);
+
+        oe_result_t result = *reinterpret_cast<oe_result_t*>(output_buffer);
+        if (trace)
+            trace->end(result);
+        return result;
     }
 
     oe_result_t oe_switchless_call_host_function(
@@ -118,28 +154,67 @@ extern "C"
         size_t output_buffer_size,
         size_t* output_bytes_written)
     {
-        _enclave->_ocall_table[function_id](
-            reinterpret_cast<const uint8_t*>(input_buffer),
-            input_buffer_size,
-            reinterpret_cast<uint8_t*>(output_buffer),
-            output_buffer_size,
-            output_bytes_written);
+        CallTrace* trace = _enclave->_trace;
+        oe_result_t result;
 
-        /* Emulate the args->deepcopy_out_buffer passing. */
-        oe_call_args_t* args = static_cast<oe_call_args_t*>(output_buffer);
-        if (args->deepcopy_out_buffer && args->deepcopy_out_buffer_size)
+        struct
         {
-            uint8_t* enclave_buffer =
-                (uint8_t*)oe_malloc(args->deepcopy_out_buffer_size);
-            memcpy(
-                enclave_buffer,
-                args->deepcopy_out_buffer,
-                args->deepcopy_out_buffer_size);
-            /* oe_host_free. */
-            free(args->deepcopy_out_buffer);
-            args->deepcopy_out_buffer = enclave_buffer;
+            oe_enclave_t* enclave;
+            size_t function_id;
+            const void* input_buffer;
+            size_t input_buffer_size;
+            void* output_buffer;
+            size_t output_buffer_size;
+            size_t* output_bytes_written;
+        } args = {_enclave,
+                  function_id,
+                  input_buffer,
+                  input_buffer_size,
+                  output_buffer,
+                  output_buffer_size,
+                  output_bytes_written};
+        SwitchlessCall call(
+            [](void* context) {
+                auto a = static_cast<decltype(args)*>(context);
+                _enclave = a->enclave;
+                return oe_call_host_function(
+                    a->function_id,
+                    a->input_buffer,
+                    a->input_buffer_size,
+                    a->output_buffer,
+                    a->output_buffer_size,
+                    a->output_bytes_written);
+            },
+            &args);
+
+        /*
+         * Fall back to a regular ocall when no host worker is free. Only
+         * the calls taken by a worker get a switchless span.
+         */
+        if (_enclave->_host_workers && _enclave->_host_workers->post(&call))
+        {
+            if (trace)
+                trace->begin(
+                    "switchless_ocall",
+                    nullptr,
+                    function_id,
+                    input_buffer_size,
+                    output_buffer_size);
+            _enclave->_host_workers->wait(&call);
+            result = call.result;
+            if (trace)
+                trace->end(result);
         }
-        return *reinterpret_cast<oe_result_t*>(output_buffer);
+        else
+            result = oe_call_host_function(
+                function_id,
+                input_buffer,
+                input_buffer_size,
+                output_buffer,
+                output_buffer_size,
+                output_bytes_written);
+
+        return result;
     }
 
     // Required by tests
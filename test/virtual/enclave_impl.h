@@ -4,12 +4,18 @@
 #include <openenclave/bits/result.h>
 #include <openenclave/bits/types.h>
 
+#include <condition_variable>
 #include <cstdlib>
 #include <map>
+#include <mutex>
+#include <shared_mutex>
+
+#include "call_trace.h"
+#include "switchless.h"
 
 #define OE_ECALL_ID_NULL OE_UINT64_MAX
 /* Temporily set value. */
-#define OE_MAX_ECALLS 256
+#define OE_MAX_ECALLS 4096
 
 typedef void (*oe_ocall_func_t)(
     const uint8_t* input_buffer,
@@ -43,7 +49,10 @@ typedef struct _oe_call_args_t
 struct _oe_enclave
 {
     oe_result_t status;
+    /* The start and end addresses of the enclave memory blocks. */
     std::map<void*, void*> _allocated_memory;
+    /* Guards _allocated_memory against concurrent (asynchronous) calls. */
+    std::shared_mutex _allocated_memory_lock;
     const oe_ocall_func_t* _ocall_table;
     uint32_t _num_ocalls;
     const oe_ecall_func_t* _ecall_table;
@@ -51,6 +60,21 @@ struct _oe_enclave
     oe_ecall_id_t _ecall_id_table[OE_MAX_ECALLS];
     void (*_set_enclave)(oe_enclave_t*);
     void* _lib_handle;
+    /* Workers that run the switchless ecalls and ocalls respectively. */
+    SwitchlessWorkers* _enclave_workers;
+    SwitchlessWorkers* _host_workers;
+    /*
+     * The number of TCSs, 0 for no limit, and the number in use. An ecall
+     * that finds no free TCS fails with OE_OUT_OF_THREADS or, if _tcs_wait
+     * is set, waits for one.
+     */
+    size_t _num_tcs;
+    size_t _tcs_in_use;
+    bool _tcs_wait;
+    std::mutex _tcs_lock;
+    std::condition_variable _tcs_released;
+    /* Records the calls and allocations if tracing is enabled. */
+    CallTrace* _trace;
 
     _oe_enclave(
         const oe_ocall_func_t* ocall_table,
@@ -64,23 +88,69 @@ struct _oe_enclave
         _num_ecalls = 0;
         _set_enclave = nullptr;
         _lib_handle = nullptr;
+        _enclave_workers = nullptr;
+        _host_workers = nullptr;
+        _num_tcs = 0;
+        _tcs_in_use = 0;
+        _tcs_wait = false;
+        _trace = nullptr;
         for (int i = 0; i < OE_MAX_ECALLS; i++)
         {
             _ecall_id_table[i].id = OE_ECALL_ID_NULL;
         }
     }
 
+    ~_oe_enclave()
+    {
+        delete _enclave_workers;
+        delete _host_workers;
+    }
+
+    oe_result_t acquire_tcs()
+    {
+        if (!_num_tcs)
+            return OE_OK;
+
+        std::unique_lock<std::mutex> lock(_tcs_lock);
+        if (_tcs_in_use == _num_tcs)
+        {
+            if (!_tcs_wait)
+                return OE_OUT_OF_THREADS;
+            _tcs_released.wait(
+                lock, [this] { return _tcs_in_use < _num_tcs; });
+        }
+        _tcs_in_use++;
+        return OE_OK;
+    }
+
+    void release_tcs()
+    {
+        if (!_num_tcs)
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(_tcs_lock);
+            _tcs_in_use--;
+        }
+        _tcs_released.notify_one();
+    }
+
     void* malloc(uint64_t size)
     {
         void* ptr = ::malloc(size);
+        if (_trace)
+            _trace->allocation();
+        std::unique_lock<std::shared_mutex> lock(_allocated_memory_lock);
         _allocated_memory[ptr] = (uint8_t*)ptr + size;
         return ptr;
     }
 
     void free(void* ptr)
     {
-        if (_allocated_memory.find(ptr) != _allocated_memory.end())
+        {
+            std::unique_lock<std::shared_mutex> lock(_allocated_memory_lock);
             _allocated_memory.erase(ptr);
+        }
         ::free(ptr);
     }
 
@@ -90,13 +160,15 @@ struct _oe_enclave
             return false;
 
         const void* end = static_cast<const uint8_t*>(ptr) + size;
-        for (auto p : _allocated_memory)
-        {
-            if (ptr >= p.first && end <= p.second)
-                return true;
-        }
+        std::shared_lock<std::shared_mutex> lock(_allocated_memory_lock);
 
-        return false;
+        /* The only block that can contain ptr is the last one at or
+         * before it since the blocks do not overlap. */
+        auto it = _allocated_memory.upper_bound(const_cast<void*>(ptr));
+        if (it == _allocated_memory.begin())
+            return false;
+        --it;
+        return end <= it->second;
     }
 
     bool is_outside_enclave(const void* ptr, uint64_t size)
@@ -105,15 +177,16 @@ struct _oe_enclave
             return false;
 
         const void* end = static_cast<const uint8_t*>(ptr) + size;
-        for (auto p : _allocated_memory)
-        {
-            if (ptr >= p.first && ptr <= p.second)
-                return false;
-            if (end >= p.first && end <= p.second)
-                return false;
-        }
-
-        return true;
+        std::shared_lock<std::shared_mutex> lock(_allocated_memory_lock);
+
+        /* Of the blocks starting at or before end, the last one reaches
+         * the furthest, so [ptr, end] overlaps a block iff it overlaps
+         * that one. */
+        auto it = _allocated_memory.upper_bound(const_cast<void*>(end));
+        if (it == _allocated_memory.begin())
+            return true;
+        --it;
+        return it->second < ptr;
     }
 };
 
@@ -8,64 +8,101 @@
 #endif
 
 #include <openenclave/edger8r/host.h>
-#include <mutex>
+#include <openenclave/internal/switchless.h>
+#include <atomic>
 #include <string>
 
+#include "call_pool.h"
+#include "channel.h"
 #include "enclave_impl.h"
 
-/* Temporily set value. */
-#define OE_MAX_ECALLS 256
+/*
+ * Number of slots of the global ecall registry. Twice OE_MAX_ECALLS keeps
+ * the probe sequences short. Must be a power of two.
+ */
+#define OE_ECALL_REGISTRY_SIZE (2 * OE_MAX_ECALLS)
+
+/*
+ * A slot of the global ecall registry, an open-addressing hash map from
+ * ecall names to global ids. A slot is claimed by setting its name and
+ * is never released. The id, plus one, is published once hash is set.
+ */
+struct oe_ecall_registry_slot_t
+{
+    std::atomic<const char*> name;
+    uint64_t hash;
+    std::atomic<uint64_t> id;
+};
 
 extern "C"
 {
-    const char* _ecall_table[OE_MAX_ECALLS];
-    uint32_t _ecall_table_size;
-    std::mutex oe_lock;
+    static oe_ecall_registry_slot_t _ecall_registry[OE_ECALL_REGISTRY_SIZE];
+    static std::atomic<uint64_t> _ecall_registry_count;
     thread_local oe_enclave_t* _enclave;
 
-    // Get the global ecall id from the _ecall_table.
-    oe_result_t oe_get_global_ecall_id_by_name(
-        const char* name,
-        uint64_t* global_id)
+    // The 64-bit FNV-1a hash of an ecall name.
+    static uint64_t oe_ecall_name_hash(const char* name)
     {
-        oe_result_t result = OE_NOT_FOUND;
-        uint64_t i;
-
-        oe_lock.lock();
-        if (!global_id)
+        uint64_t hash = 14695981039346656037ULL;
+        for (const char* p = name; *p; p++)
         {
-            result = OE_INVALID_PARAMETER;
-            goto done;
+            hash ^= static_cast<unsigned char>(*p);
+            hash *= 1099511628211ULL;
         }
+        return hash;
+    }
 
-        for (i = 0; i < _ecall_table_size; i++)
+    // Get the global ecall id of a name, adding the name if it is new.
+    static oe_result_t oe_get_global_ecall_id_by_hash(
+        const char* name,
+        uint64_t hash,
+        uint64_t* global_id)
+    {
+        for (size_t i = 0; i < OE_ECALL_REGISTRY_SIZE; i++)
         {
-            if (strcmp(_ecall_table[i], name) == 0)
+            oe_ecall_registry_slot_t* slot =
+                &_ecall_registry[(hash + i) & (OE_ECALL_REGISTRY_SIZE - 1)];
+            const char* claimed = slot->name.load(std::memory_order_acquire);
+            uint64_t id;
+
+            if (!claimed && slot->name.compare_exchange_strong(
+                                claimed, name, std::memory_order_acq_rel))
             {
-                *global_id = i;
-                result = OE_OK;
-                break;
+                id = _ecall_registry_count.fetch_add(
+                    1, std::memory_order_relaxed);
+                id = id < OE_MAX_ECALLS ? id + 1 : OE_UINT64_MAX;
+                slot->hash = hash;
+                slot->id.store(id, std::memory_order_release);
             }
-        }
-
-        /* If the name is not found, adding it to the table. */
-        if (result == OE_NOT_FOUND)
-        {
-            if (_ecall_table_size >= OE_MAX_ECALLS)
+            else
             {
-                result = OE_OUT_OF_BOUNDS;
-                goto done;
+                /* Wait for the thread that claimed the slot to publish. */
+                while (!(id = slot->id.load(std::memory_order_acquire)))
+                    oe_cpu_relax();
+                if (slot->hash != hash ||
+                    (claimed != name && strcmp(claimed, name) != 0))
+                    continue;
             }
 
-            _ecall_table[_ecall_table_size] = name;
-            *global_id = _ecall_table_size;
-            _ecall_table_size++;
-            result = OE_OK;
+            if (id == OE_UINT64_MAX)
+                return OE_OUT_OF_BOUNDS;
+            *global_id = id - 1;
+            return OE_OK;
         }
 
-    done:
-        oe_lock.unlock();
-        return result;
+        return OE_OUT_OF_BOUNDS;
+    }
+
+    // Get the global ecall id from the global ecall registry.
+    oe_result_t oe_get_global_ecall_id_by_name(
+        const char* name,
+        uint64_t* global_id)
+    {
+        if (!name || !global_id)
+            return OE_INVALID_PARAMETER;
+
+        return oe_get_global_ecall_id_by_hash(
+            name, oe_ecall_name_hash(name), global_id);
     }
 
     oe_result_t oe_get_enclave_function_id(
@@ -131,8 +168,9 @@ extern "C"
             const char* name = ecall_info_table[i].name;
             uint64_t local_id = i;
 
-            /* Assign a proper global id based on the global __ecall_table. */
-            if ((oe_get_global_ecall_id_by_name(name, &global_id)) != OE_OK)
+            /* Assign a proper global id based on the global registry. */
+            if ((oe_get_global_ecall_id_by_hash(
+                    name, oe_ecall_name_hash(name), &global_id)) != OE_OK)
                 continue;
 
             enclave->_ecall_id_table[global_id].id = local_id;
@@ -157,11 +195,14 @@ extern "C"
         oe_result_t result = OE_FAILURE;
         oe_enclave_t* previous_enclave = _enclave;
         uint64_t function_id = OE_ECALL_ID_NULL;
-        _enclave = enclave;
-        enclave->_set_enclave(enclave);
+        bool tcs_acquired = false;
+
+        if (enclave->_trace)
+            enclave->_trace->begin(
+                "ecall", name, 0, input_buffer_size, output_buffer_size);
 
-        if (!_enclave->is_outside_enclave(input_buffer, input_buffer_size) ||
-            !_enclave->is_outside_enclave(output_buffer, output_buffer_size) ||
+        if (!enclave->is_outside_enclave(input_buffer, input_buffer_size) ||
+            !enclave->is_outside_enclave(output_buffer, output_buffer_size) ||
             !global_id)
         {
             result = OE_INVALID_PARAMETER;
@@ -179,23 +220,43 @@ extern "C"
                 enclave, global_id, name, &function_id) != OE_OK)
             goto done;
 
+        /* A nested ecall runs on the TCS of the ecall it is nested in. */
+        if (previous_enclave != enclave)
         {
-            void* enc_input_buffer = enclave->malloc(input_buffer_size);
-            memcpy(enc_input_buffer, input_buffer, input_buffer_size);
-            void* enc_output_buffer = enclave->malloc(output_buffer_size);
-            memset(enc_output_buffer, 0, output_buffer_size);
+            if ((result = enclave->acquire_tcs()) != OE_OK)
+                goto done;
+            tcs_acquired = true;
+        }
+
+        _enclave = enclave;
+        enclave->_set_enclave(enclave);
+
+        if (function_id >= enclave->_num_ecalls)
+        {
+            result = OE_OUT_OF_BOUNDS;
+            goto done;
+        }
+
+        {
+            /* One enclave block holds the copies of both buffers and the
+             * number of bytes written. */
+            size_t output_offset = (input_buffer_size + 15) & ~(size_t)15;
+            size_t written_offset =
+                (output_offset + output_buffer_size + 15) & ~(size_t)15;
+            uint8_t* block = static_cast<uint8_t*>(
+                enclave->malloc(written_offset + sizeof(size_t)));
+            uint8_t* enc_input_buffer = block;
+            uint8_t* enc_output_buffer = block + output_offset;
             size_t* enc_output_bytes_written =
-                (size_t*)enclave->malloc(sizeof(size_t));
+                reinterpret_cast<size_t*>(block + written_offset);
 
-            if (function_id >= enclave->_num_ecalls)
-            {
-                result = OE_OUT_OF_BOUNDS;
-                goto done;
-            }
+            memcpy(enc_input_buffer, input_buffer, input_buffer_size);
+            memset(enc_output_buffer, 0, output_buffer_size);
+            *enc_output_bytes_written = 0;
             enclave->_ecall_table[function_id](
-                static_cast<const uint8_t*>(enc_input_buffer),
+                enc_input_buffer,
                 input_buffer_size,
-                static_cast<uint8_t*>(enc_output_buffer),
+                enc_output_buffer,
                 output_buffer_size,
                 enc_output_bytes_written);
 
@@ -203,7 +264,7 @@ extern "C"
 
             /* Emulate the args->deepcopy_out_buffer passing. */
             oe_call_args_t* args =
-                static_cast<oe_call_args_t*>(enc_output_buffer);
+                reinterpret_cast<oe_call_args_t*>(enc_output_buffer);
             if (args->deepcopy_out_buffer && args->deepcopy_out_buffer_size)
             {
                 uint8_t* host_buffer =
@@ -216,23 +277,148 @@ extern "C"
                 args->deepcopy_out_buffer = host_buffer;
             }
 
-            memcpy(output_buffer, enc_output_buffer, output_buffer_size);
+            /* Like the SGX runtime, copy back only the bytes written, but
+             * always the header that holds the result. */
+            size_t copied = *output_bytes_written;
+            if (copied < sizeof(oe_call_args_t))
+                copied = sizeof(oe_call_args_t);
+            if (copied > output_buffer_size)
+                copied = output_buffer_size;
+            memcpy(output_buffer, enc_output_buffer, copied);
 
-            enclave->free(enc_output_bytes_written);
-            enclave->free(enc_output_buffer);
-            enclave->free(enc_input_buffer);
+            enclave->free(block);
             result = *(oe_result_t*)output_buffer;
         }
 
     done:
-        _enclave = previous_enclave;
+        if (tcs_acquired)
+            enclave->release_tcs();
+
+        /* Restore the enclave of an ecall this one is nested in. */
+        if (_enclave != previous_enclave)
+        {
+            _enclave = previous_enclave;
+            if (previous_enclave)
+                previous_enclave->_set_enclave(previous_enclave);
+        }
 
         if (result == OE_INVALID_PARAMETER)
             printf("ecall returned OE_INVALID_PARAMETER\n");
 
+        if (enclave->_trace)
+            enclave->_trace->end(result);
+
         return result;
     }
 
+    oe_call_handle_t oe_call_post(oe_call_async_func_t func, void* context)
+    {
+        return oe_virtual_call_post(func, context);
+    }
+
+    size_t oe_channel_send(
+        oe_channel_t* channel,
+        const void* records,
+        size_t count)
+    {
+        return oe_virtual_channel_send(channel, records, count, memcpy);
+    }
+
+    oe_result_t oe_switchless_call_enclave_function(
+        oe_enclave_t* enclave,
+        uint64_t* global_id,
+        const char* name,
+        const void* input_buffer,
+        size_t input_buffer_size,
+        void* output_buffer,
+        size_t output_buffer_size,
+        size_t* output_bytes_written)
+    {
+        oe_result_t result;
+
+        if (!enclave)
+            return OE_INVALID_PARAMETER;
+
+        struct
+        {
+            oe_enclave_t* enclave;
+            uint64_t* global_id;
+            const char* name;
+            const void* input_buffer;
+            size_t input_buffer_size;
+            void* output_buffer;
+            size_t output_buffer_size;
+            size_t* output_bytes_written;
+        } args = {enclave,
+                  global_id,
+                  name,
+                  input_buffer,
+                  input_buffer_size,
+                  output_buffer,
+                  output_buffer_size,
+                  output_bytes_written};
+        SwitchlessCall call(
+            [](void* context) {
+                auto a = static_cast<decltype(args)*>(context);
+                return oe_call_enclave_function(
+                    a->enclave,
+                    a->global_id,
+                    a->name,
+                    a->input_buffer,
+                    a->input_buffer_size,
+                    a->output_buffer,
+                    a->output_buffer_size,
+                    a->output_bytes_written);
+            },
+            &args);
+
+        /*
+         * Fall back to a regular ecall when no enclave worker is free. Only
+         * the calls taken by a worker get a switchless span.
+         */
+        if (enclave->_enclave_workers && enclave->_enclave_workers->post(&call))
+        {
+            if (enclave->_trace)
+                enclave->_trace->begin(
+                    "switchless_ecall",
+                    name,
+                    0,
+                    input_buffer_size,
+                    output_buffer_size);
+            enclave->_enclave_workers->wait(&call);
+            result = call.result;
+            if (enclave->_trace)
+                enclave->_trace->end(result);
+        }
+        else
+            result = oe_call_enclave_function(
+                enclave,
+                global_id,
+                name,
+                input_buffer,
+                input_buffer_size,
+                output_buffer,
+                output_buffer_size,
+                output_bytes_written);
+
+        return result;
+    }
+
+    oe_result_t oe_get_switchless_stats(
+        oe_enclave_t* enclave,
+        oe_switchless_stats_t* ecalls,
+        oe_switchless_stats_t* ocalls)
+    {
+        if (!enclave)
+            return OE_INVALID_PARAMETER;
+
+        if (ecalls)
+            enclave->_enclave_workers->get_stats(ecalls);
+        if (ocalls)
+            enclave->_host_workers->get_stats(ocalls);
+        return OE_OK;
+    }
+
     oe_result_t oe_create_enclave(
         const char* path,
         oe_enclave_type_t type,
@@ -248,11 +434,40 @@ extern "C"
         OE_UNUSED(path);
         OE_UNUSED(type);
         OE_UNUSED(flags);
-        OE_UNUSED(settings);
-        OE_UNUSED(setting_count);
 
         oe_enclave_t* enc =
             new _oe_enclave(ocall_table, num_ocalls, num_ecalls);
+
+        /* Switchless calls fall back to regular calls without workers. */
+        size_t host_workers = 0;
+        size_t enclave_workers = 0;
+        for (uint32_t i = 0; settings && i < setting_count; i++)
+        {
+            if (settings[i].setting_type ==
+                    OE_ENCLAVE_SETTING_CONTEXT_SWITCHLESS &&
+                settings[i].u.context_switchless_setting)
+            {
+                host_workers = settings[i]
+                                   .u.context_switchless_setting
+                                   ->max_host_workers;
+                enclave_workers = settings[i]
+                                      .u.context_switchless_setting
+                                      ->max_enclave_workers;
+            }
+        }
+        enc->_host_workers = new SwitchlessWorkers(host_workers);
+        enc->_enclave_workers = new SwitchlessWorkers(enclave_workers);
+        SwitchlessWorkers::pair(enc->_host_workers, enc->_enclave_workers);
+
+        /* Emulate the TCS count of the enclave image. */
+        const char* num_tcs = getenv("OE_VIRTUAL_NUM_TCS");
+        if (num_tcs && atoi(num_tcs) > 0)
+            enc->_num_tcs = static_cast<size_t>(atoi(num_tcs));
+        const char* tcs_wait = getenv("OE_VIRTUAL_TCS_WAIT");
+        enc->_tcs_wait = tcs_wait && atoi(tcs_wait) > 0;
+
+        /* Record the calls if OE_VIRTUAL_TRACE is set. */
+        enc->_trace = oe_virtual_call_trace();
         printf("Loading virtual enclave %s\n", path);
 #if _WIN32
         std::string path_with_ext = std::string(path) + ".dll";
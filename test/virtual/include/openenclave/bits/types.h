@@ -183,4 +183,10 @@ typedef struct _oe_datetime
     uint32_t seconds; /* range: 0-59 */
 } oe_datetime_t;
 
+/**
+ * Handle of an asynchronous call started by a generated <function>_async
+ * wrapper. It is released by oe_call_wait().
+ */
+typedef struct _oe_call* oe_call_handle_t;
+
 #endif /* _OE_BITS_TYPES_H */
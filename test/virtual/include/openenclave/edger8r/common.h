@@ -68,7 +68,21 @@ done:
     return result;
 }
 
-#define OE_ADD_SIZE(total, size)                                   \
+/**
+ * Add a size value without rounding it. The compact layout only aligns each
+ * parameter to the natural alignment of its elements.
+ */
+OE_INLINE oe_result_t oe_add_compact_size(size_t* total, size_t size)
+{
+    size_t sum = *total + size;
+    if (sum < *total)
+        return OE_INTEGER_OVERFLOW;
+
+    *total = sum;
+    return OE_OK;
+}
+
+#define OE_ADD_SIZE_WITH(add_size, total, size)                    \
     do                                                             \
     {                                                              \
         if (sizeof(total) > sizeof(size_t) && total > OE_SIZE_MAX) \
@@ -81,13 +95,18 @@ done:
             _result = OE_INVALID_PARAMETER;                        \
             goto done;                                             \
         }                                                          \
-        if (oe_add_size((size_t*)&total, (size_t)size) != OE_OK)   \
+        if (add_size((size_t*)&total, (size_t)size) != OE_OK)      \
         {                                                          \
             _result = OE_INTEGER_OVERFLOW;                         \
             goto done;                                             \
         }                                                          \
     } while (0)
 
+#define OE_ADD_SIZE(total, size) OE_ADD_SIZE_WITH(oe_add_size, total, size)
+
+#define OE_ADD_COMPACT_SIZE(total, size) \
+    OE_ADD_SIZE_WITH(oe_add_compact_size, total, size)
+
 #define OE_COMPUTE_ARG_SIZE(total, argcount, argsize)                      \
     do                                                                     \
     {                                                                      \
@@ -101,23 +120,91 @@ done:
         total = _argcount * _argsize;                                      \
     } while (0)
 
-#define OE_ADD_ARG_SIZE(total, argcount, argsize)               \
+#define OE_ADD_ARG_SIZE_WITH(add, total, argcount, argsize)     \
     do                                                          \
     {                                                           \
         size_t _total_argsize = 0;                              \
         OE_COMPUTE_ARG_SIZE(_total_argsize, argcount, argsize); \
-        OE_ADD_SIZE(total, _total_argsize);                     \
-    } while (0);
+        add(total, _total_argsize);                             \
+    } while (0)
+
+#define OE_ADD_ARG_SIZE(total, argcount, argsize) \
+    OE_ADD_ARG_SIZE_WITH(OE_ADD_SIZE, total, argcount, argsize);
+
+#define OE_ADD_ARG_SIZE_COMPACT(total, argcount, argsize) \
+    OE_ADD_ARG_SIZE_WITH(OE_ADD_COMPACT_SIZE, total, argcount, argsize);
+
+/**
+ * Round a buffer size or offset up to the alignment of the next parameter,
+ * a power of two. Sizes and offsets are already rounded to
+ * OE_EDGER8R_BUFFER_ALIGNMENT, so the padding stays a multiple of it. The
+ * compact layout adds the exact padding instead.
+ */
+#define OE_ALIGN_SIZE_WITH(add, total, align)                  \
+    do                                                         \
+    {                                                          \
+        size_t _remainder = (size_t)(total) % (size_t)(align); \
+        if (_remainder)                                        \
+            add(total, (size_t)(align) - _remainder);          \
+    } while (0)
+
+#define OE_ALIGN_SIZE(total, align) \
+    OE_ALIGN_SIZE_WITH(OE_ADD_SIZE, total, align)
+
+#define OE_ALIGN_SIZE_COMPACT(total, align) \
+    OE_ALIGN_SIZE_WITH(OE_ADD_COMPACT_SIZE, total, align)
+
+/**
+ * The first address at or after ptr that is a multiple of align.
+ */
+#define OE_ALIGN_POINTER(ptr, align) \
+    ((uint8_t*)(ptr) +               \
+     ((size_t)(align) - (size_t)((uint64_t)(ptr) % (align))) % (align))
+
+/**
+ * The runtime copies the ECALL buffers into the enclave with a smaller
+ * alignment than the parameters may ask for. The wrapper reserves align bytes
+ * after each buffer, so the ECALL forwarder can move the input buffer up to
+ * the alignment and lay out the output buffer from it.
+ */
+#define OE_ALIGN_ECALL_BUFFERS(align)                                    \
+    if (input_buffer_size < (align) + sizeof(*_pargs_in) ||              \
+        output_buffer_size < (align) + sizeof(*_pargs_out))              \
+        goto done;                                                       \
+    input_buffer_size -= (align);                                        \
+    output_buffer_size -= (align);                                       \
+    if ((uint64_t)input_buffer % (align))                                \
+    {                                                                    \
+        uint8_t* _aligned_input_buffer =                                 \
+            OE_ALIGN_POINTER(input_buffer, align);                       \
+        memmove(_aligned_input_buffer, input_buffer, input_buffer_size); \
+        input_buffer = _aligned_input_buffer;                            \
+    }                                                                    \
+    output_buffer = OE_ALIGN_POINTER(output_buffer, align)
+
+/**
+ * Move the output of an ECALL forwarder back to the start of the buffer,
+ * where the runtime copies it from. Like the runtime, move at least the
+ * header that holds the result.
+ */
+#define OE_UNALIGN_ECALL_OUTPUT_BUFFER(unaligned_buffer) \
+    if (output_buffer != (unaligned_buffer))             \
+        memmove(                                         \
+            unaligned_buffer,                            \
+            output_buffer,                               \
+            *output_bytes_written > sizeof(*_pargs_out)  \
+                ? *output_bytes_written                  \
+                : sizeof(*_pargs_out))
 
 /**
  * Compute and set the pointer value for the given parameter within the input
  * buffer. Make sure that the buffer has enough space.
  */
-#define OE_SET_IN_POINTER(argname, argcount, argsize, argtype)               \
+#define OE_SET_IN_POINTER_WITH(add, argname, argcount, argsize, argtype)     \
     if (_pargs_in->argname)                                                  \
     {                                                                        \
         _pargs_in->argname = (argtype)(input_buffer + _input_buffer_offset); \
-        OE_ADD_ARG_SIZE(_input_buffer_offset, argcount, argsize);            \
+        OE_ADD_ARG_SIZE_WITH(add, _input_buffer_offset, argcount, argsize);  \
         if (_input_buffer_offset > input_buffer_size)                        \
         {                                                                    \
             _result = OE_BUFFER_TOO_SMALL;                                   \
@@ -125,17 +212,25 @@ done:
         }                                                                    \
     }
 
+#define OE_SET_IN_POINTER(argname, argcount, argsize, argtype) \
+    OE_SET_IN_POINTER_WITH(OE_ADD_SIZE, argname, argcount, argsize, argtype)
+
+#define OE_SET_IN_POINTER_COMPACT(argname, argcount, argsize, argtype) \
+    OE_SET_IN_POINTER_WITH(                                            \
+        OE_ADD_COMPACT_SIZE, argname, argcount, argsize, argtype)
+
 #define OE_SET_IN_OUT_POINTER OE_SET_IN_POINTER
+#define OE_SET_IN_OUT_POINTER_COMPACT OE_SET_IN_POINTER_COMPACT
 
 /**
  * Compute and set the pointer value for the given parameter within the output
  * buffer. Make sure that the buffer has enough space.
  */
-#define OE_SET_OUT_POINTER(argname, argcount, argsize, argtype)                \
+#define OE_SET_OUT_POINTER_WITH(add, argname, argcount, argsize, argtype)      \
     do                                                                         \
     {                                                                          \
         _pargs_in->argname = (argtype)(output_buffer + _output_buffer_offset); \
-        OE_ADD_ARG_SIZE(_output_buffer_offset, argcount, argsize);             \
+        OE_ADD_ARG_SIZE_WITH(add, _output_buffer_offset, argcount, argsize);   \
         if (_output_buffer_offset > output_buffer_size)                        \
         {                                                                      \
             _result = OE_BUFFER_TOO_SMALL;                                     \
@@ -143,20 +238,28 @@ done:
         }                                                                      \
     } while (0)
 
+#define OE_SET_OUT_POINTER(argname, argcount, argsize, argtype) \
+    OE_SET_OUT_POINTER_WITH(OE_ADD_SIZE, argname, argcount, argsize, argtype)
+
+#define OE_SET_OUT_POINTER_COMPACT(argname, argcount, argsize, argtype) \
+    OE_SET_OUT_POINTER_WITH(                                            \
+        OE_ADD_COMPACT_SIZE, argname, argcount, argsize, argtype)
+
 /**
  * Compute and set the pointer value for the given parameter within the output
  * buffer. Make sure that the buffer has enough space.
  * Also copy the contents of the corresponding in-out pointer in the input
  * buffer.
  */
-#define OE_COPY_AND_SET_IN_OUT_POINTER(argname, argcount, argsize, argtype)    \
+#define OE_COPY_AND_SET_IN_OUT_POINTER_WITH(                                   \
+    add, argname, argcount, argsize, argtype)                                  \
     if (_pargs_in->argname)                                                    \
     {                                                                          \
         size_t _size = 0;                                                      \
         OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);                         \
         argtype _p_in = (argtype)_pargs_in->argname;                           \
         _pargs_in->argname = (argtype)(output_buffer + _output_buffer_offset); \
-        OE_ADD_SIZE(_output_buffer_offset, _size);                             \
+        add(_output_buffer_offset, _size);                                     \
         if (_output_buffer_offset > output_buffer_size)                        \
         {                                                                      \
             _result = OE_BUFFER_TOO_SMALL;                                     \
@@ -165,32 +268,176 @@ done:
         memcpy(_pargs_in->argname, _p_in, _size);                              \
     }
 
+#define OE_COPY_AND_SET_IN_OUT_POINTER(argname, argcount, argsize, argtype) \
+    OE_COPY_AND_SET_IN_OUT_POINTER_WITH(                                    \
+        OE_ADD_SIZE, argname, argcount, argsize, argtype)
+
+#define OE_COPY_AND_SET_IN_OUT_POINTER_COMPACT( \
+    argname, argcount, argsize, argtype)        \
+    OE_COPY_AND_SET_IN_OUT_POINTER_WITH(        \
+        OE_ADD_COMPACT_SIZE, argname, argcount, argsize, argtype)
+
+/**
+ * Compute and set the pointer value for the given in-place in-out parameter
+ * within the output buffer, where the caller has already written its contents.
+ */
+#define OE_SET_IN_PLACE_POINTER OE_SET_OUT_POINTER
+#define OE_SET_IN_PLACE_POINTER_COMPACT OE_SET_OUT_POINTER_COMPACT
+
+/**
+ * Set the pointer value for the given inline parameter to its storage in the
+ * marshalling struct of the input buffer, or of the output buffer for out
+ * parameters.
+ */
+#define OE_SET_INLINE_IN_POINTER(argname, argtype) \
+    _pargs_in->argname = (argtype)_pargs_in->argname##_inline
+
+#define OE_SET_INLINE_OUT_POINTER(argname, argtype) \
+    _pargs_in->argname = (argtype)_pargs_out->argname##_inline
+
+/**
+ * Copy the contents of the given inline in-out parameter to the marshalling
+ * struct of the output buffer and set the pointer value to it.
+ */
+#define OE_COPY_AND_SET_INLINE_IN_OUT_POINTER(argname, argtype) \
+    do                                                          \
+    {                                                           \
+        memcpy(                                                 \
+            _pargs_out->argname##_inline,                       \
+            _pargs_in->argname##_inline,                        \
+            sizeof(_pargs_out->argname##_inline));              \
+        OE_SET_INLINE_OUT_POINTER(argname, argtype);            \
+    } while (0)
+
+/**
+ * Move the produced part of a variable-length out parameter down to the
+ * current offset of the output buffer, after checking it against the
+ * capacity of the parameter.
+ */
+#define OE_PACK_OUT_PARAM_WITH(add, argname, length, capacity, argsize)        \
+    if (_pargs_in->argname)                                                    \
+    {                                                                          \
+        size_t _length = (size_t)(length);                                     \
+        size_t _size = 0;                                                      \
+        if (_length > (size_t)(capacity))                                      \
+        {                                                                      \
+            _result = OE_BUFFER_TOO_SMALL;                                     \
+            goto done;                                                         \
+        }                                                                      \
+        OE_COMPUTE_ARG_SIZE(_size, _length, argsize);                          \
+        memmove(                                                               \
+            output_buffer + _output_buffer_offset, _pargs_in->argname, _size); \
+        add(_output_buffer_offset, _size);                                     \
+    }
+
+#define OE_PACK_OUT_PARAM(argname, length, capacity, argsize) \
+    OE_PACK_OUT_PARAM_WITH(OE_ADD_SIZE, argname, length, capacity, argsize)
+
+#define OE_PACK_OUT_PARAM_COMPACT(argname, length, capacity, argsize) \
+    OE_PACK_OUT_PARAM_WITH(                                           \
+        OE_ADD_COMPACT_SIZE, argname, length, capacity, argsize)
+
 /**
  * Copy an input parameter to input buffer.
  */
-#define OE_WRITE_IN_PARAM(argname, argcount, argsize, argtype)           \
-    if (argname)                                                         \
-    {                                                                    \
-        size_t _size = 0;                                                \
-        OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);                   \
-        _args.argname = (argtype)(_input_buffer + _input_buffer_offset); \
-        OE_ADD_SIZE(_input_buffer_offset, _size);                        \
-        memcpy((void*)_args.argname, argname, _size);                    \
+#define OE_WRITE_IN_PARAM_WITH(add, copy, argname, argcount, argsize, argtype) \
+    if (argname)                                                               \
+    {                                                                          \
+        size_t _size = 0;                                                      \
+        OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);                         \
+        _args.argname = (argtype)(_input_buffer + _input_buffer_offset);       \
+        add(_input_buffer_offset, _size);                                      \
+        copy((void*)_args.argname, argname, _size);                            \
     }
 
+#define OE_WRITE_IN_PARAM(argname, argcount, argsize, argtype) \
+    OE_WRITE_IN_PARAM_WITH(                                    \
+        OE_ADD_SIZE, memcpy, argname, argcount, argsize, argtype)
+
+#define OE_WRITE_IN_PARAM_COMPACT(argname, argcount, argsize, argtype) \
+    OE_WRITE_IN_PARAM_WITH(                                            \
+        OE_ADD_COMPACT_SIZE, memcpy, argname, argcount, argsize, argtype)
+
 #define OE_WRITE_IN_OUT_PARAM OE_WRITE_IN_PARAM
+#define OE_WRITE_IN_OUT_PARAM_COMPACT OE_WRITE_IN_PARAM_COMPACT
 
 #define OE_WRITE_IN_PARAM_WITH_BARRIER(argname, argcount, argsize, argtype) \
-    if (argname)                                                            \
-    {                                                                       \
-        size_t _size = 0;                                                   \
-        OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);                      \
-        _args.argname = (argtype)(_input_buffer + _input_buffer_offset);    \
-        OE_ADD_SIZE(_input_buffer_offset, _size);                           \
-        oe_memcpy_with_barrier((void*)_args.argname, argname, _size);       \
-    }
+    OE_WRITE_IN_PARAM_WITH(                                                 \
+        OE_ADD_SIZE,                                                        \
+        oe_memcpy_with_barrier,                                             \
+        argname,                                                            \
+        argcount,                                                           \
+        argsize,                                                            \
+        argtype)
+
+#define OE_WRITE_IN_PARAM_WITH_BARRIER_COMPACT( \
+    argname, argcount, argsize, argtype)        \
+    OE_WRITE_IN_PARAM_WITH(                     \
+        OE_ADD_COMPACT_SIZE,                    \
+        oe_memcpy_with_barrier,                 \
+        argname,                                \
+        argcount,                               \
+        argsize,                                \
+        argtype)
 
 #define OE_WRITE_IN_OUT_PARAM_WITH_BARRIER OE_WRITE_IN_PARAM_WITH_BARRIER
+#define OE_WRITE_IN_OUT_PARAM_WITH_BARRIER_COMPACT \
+    OE_WRITE_IN_PARAM_WITH_BARRIER_COMPACT
+
+/**
+ * Copy an in-place in-out parameter to output buffer.
+ */
+#define OE_WRITE_IN_PLACE_PARAM_WITH_BARRIER_WITH(                         \
+    add, argname, argcount, argsize, argtype)                              \
+    if (argname)                                                           \
+    {                                                                      \
+        size_t _size = 0;                                                  \
+        OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);                     \
+        _args.argname = (argtype)(_output_buffer + _output_buffer_offset); \
+        add(_output_buffer_offset, _size);                                 \
+        oe_memcpy_with_barrier((void*)_args.argname, argname, _size);      \
+    }
+
+#define OE_WRITE_IN_PLACE_PARAM_WITH_BARRIER(  \
+    argname, argcount, argsize, argtype)       \
+    OE_WRITE_IN_PLACE_PARAM_WITH_BARRIER_WITH( \
+        OE_ADD_SIZE, argname, argcount, argsize, argtype)
+
+#define OE_WRITE_IN_PLACE_PARAM_WITH_BARRIER_COMPACT( \
+    argname, argcount, argsize, argtype)              \
+    OE_WRITE_IN_PLACE_PARAM_WITH_BARRIER_WITH(        \
+        OE_ADD_COMPACT_SIZE, argname, argcount, argsize, argtype)
+
+/**
+ * Copy an inline in or in-out parameter to the marshalling struct and point
+ * the parameter at its copy in the input buffer, like OE_WRITE_IN_PARAM does,
+ * so that the caller's pointer is not passed to the other side.
+ */
+#define OE_WRITE_INLINE_PARAM(argname, argtype)               \
+    if (argname)                                              \
+    {                                                         \
+        _args.argname = (argtype)_pargs_in->argname##_inline; \
+        memcpy(                                               \
+            _args.argname##_inline,                           \
+            argname,                                          \
+            sizeof(_args.argname##_inline));                  \
+    }
+
+/**
+ * Check that a host_memory parameter, which is passed to the host without a
+ * copy, lies outside the enclave.
+ */
+#define OE_CHECK_HOST_MEMORY_PARAM(argname, argcount, argsize) \
+    if (argname)                                               \
+    {                                                          \
+        size_t _size = 0;                                      \
+        OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);         \
+        if (!oe_is_outside_enclave(argname, _size))            \
+        {                                                      \
+            _result = OE_INVALID_PARAMETER;                    \
+            goto done;                                         \
+        }                                                      \
+    }
 
 #define OE_WRITE_DEEPCOPY_OUT_PARAM(argname, argcount, argsize)                \
     do                                                                         \
@@ -224,19 +471,91 @@ done:
         memcpy(argname, _ptr, _size);                                      \
     }
 
+/**
+ * Point a nested out pointer into the deep-copy out buffer instead of
+ * copying it to a separate allocation.
+ */
+#define OE_SET_DEEPCOPY_OUT_ARENA_PARAM(argname, argcount, argsize, argtype) \
+    if (argname)                                                             \
+    {                                                                        \
+        size_t _size = 0;                                                    \
+        OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);                       \
+        argname =                                                            \
+            (argtype)(_deepcopy_out_buffer + _deepcopy_out_buffer_offset);   \
+        OE_ADD_SIZE(_deepcopy_out_buffer_offset, _size);                     \
+        if (_deepcopy_out_buffer_offset > _deepcopy_out_buffer_size)         \
+        {                                                                    \
+            _result = OE_BUFFER_TOO_SMALL;                                   \
+            goto done;                                                       \
+        }                                                                    \
+    }
+
+/**
+ * Replace a parameter pointer into the record of a deferred OCALL with its
+ * offset from the start of the record. The offset of a non-null pointer is
+ * never 0 since the marshalling struct comes first.
+ */
+#define OE_SET_DEFERRED_OFFSET(argname, argtype)           \
+    if (_args.argname)                                     \
+        _args.argname = (argtype)(uintptr_t)(              \
+            (const uint8_t*)_args.argname - _input_buffer)
+
 /**
  * Read an output parameter from output buffer.
  */
-#define OE_READ_OUT_PARAM(argname, argcount, argsize)                          \
+#define OE_READ_OUT_PARAM_WITH(add, argname, argcount, argsize)                \
     if (argname)                                                               \
     {                                                                          \
         size_t _size = 0;                                                      \
         OE_COMPUTE_ARG_SIZE(_size, argcount, argsize);                         \
         memcpy((void*)argname, _output_buffer + _output_buffer_offset, _size); \
-        OE_ADD_SIZE(_output_buffer_offset, _size);                             \
+        add(_output_buffer_offset, _size);                                     \
     }
 
+#define OE_READ_OUT_PARAM(argname, argcount, argsize) \
+    OE_READ_OUT_PARAM_WITH(OE_ADD_SIZE, argname, argcount, argsize)
+
+#define OE_READ_OUT_PARAM_COMPACT(argname, argcount, argsize) \
+    OE_READ_OUT_PARAM_WITH(OE_ADD_COMPACT_SIZE, argname, argcount, argsize)
+
 #define OE_READ_IN_OUT_PARAM OE_READ_OUT_PARAM
+#define OE_READ_IN_OUT_PARAM_COMPACT OE_READ_OUT_PARAM_COMPACT
+
+/**
+ * Read an inline out or in-out parameter from the marshalling struct of the
+ * output buffer.
+ */
+#define OE_READ_INLINE_PARAM(argname)     \
+    if (argname)                          \
+        memcpy(                           \
+            (void*)argname,               \
+            _pargs_out->argname##_inline, \
+            sizeof(_pargs_out->argname##_inline))
+
+/**
+ * Read the produced part of a variable-length out parameter, after checking
+ * the length reported by the other side against the capacity.
+ */
+#define OE_READ_OUT_PARAM_LENGTH_WITH(        \
+    read, argname, length, capacity, argsize) \
+    if (argname)                              \
+    {                                         \
+        size_t _length = (size_t)(length);    \
+        if (_length > (size_t)(capacity))     \
+        {                                     \
+            _result = OE_FAILURE;             \
+            goto done;                        \
+        }                                     \
+        read(argname, _length, argsize);      \
+    }
+
+#define OE_READ_OUT_PARAM_LENGTH(argname, length, capacity, argsize) \
+    OE_READ_OUT_PARAM_LENGTH_WITH(                                   \
+        OE_READ_OUT_PARAM, argname, length, capacity, argsize)
+
+#define OE_READ_OUT_PARAM_LENGTH_COMPACT(argname, length, capacity, argsize) \
+    OE_READ_OUT_PARAM_LENGTH_WITH(                                           \
+        OE_READ_OUT_PARAM_COMPACT, argname, length, capacity, argsize)
 
 /**
  * Check that a string is null terminated.
@@ -266,6 +585,213 @@ done:
         }                                                     \
     }
 
+/**
+ * The flags of a chunk of a chunked parameter. The first chunk of a call
+ * begins it, and a call that fails after that is aborted by an empty chunk.
+ */
+#define OE_CHUNK_BEGIN 1
+#define OE_CHUNK_ABORT 2
+
+/**
+ * The function that a worker thread runs for an asynchronous call. It returns
+ * the result of the call.
+ */
+typedef oe_result_t (*oe_call_async_func_t)(void* context);
+
+/**
+ * Run func(context) on a host worker thread. Only the host wrappers of
+ * asynchronous ECALLs post calls.
+ *
+ * @returns The handle of the call or NULL if the call could not be posted.
+ */
+oe_call_handle_t oe_call_post(oe_call_async_func_t func, void* context);
+
+/**
+ * The points of a call reported to oe_edger8r_trace_point by the wrappers
+ * and forwarders generated with --instrument.
+ */
+typedef enum _oe_edger8r_trace_point
+{
+    /** The wrapper wrote the input buffer or the forwarder the outputs. */
+    OE_EDGER8R_TRACE_MARSHALLED,
+    /** The other side or the user function returned. */
+    OE_EDGER8R_TRACE_RETURNED,
+    /** The wrapper read the outputs or the forwarder the inputs. */
+    OE_EDGER8R_TRACE_UNMARSHALLED,
+    __OE_EDGER8R_TRACE_POINT_MAX = OE_ENUM_MAX,
+} oe_edger8r_trace_point_t;
+
+/**
+ * Called when a wrapper or forwarder generated with --instrument starts.
+ *
+ * The runtime defines the trace hooks as weak functions that do nothing, so
+ * an application installs its own hooks by defining them.
+ *
+ * @param function_id The id of the function in the ECALL or OCALL table.
+ * @param name The name of the function.
+ * @param ecall Whether the function is an ECALL.
+ */
+void oe_edger8r_trace_begin(uint32_t function_id, const char* name, bool ecall);
+
+/**
+ * Called when a call reaches one of the trace points.
+ *
+ * @param function_id The id of the function.
+ * @param point The trace point.
+ * @param input_buffer_size The size of the input buffer.
+ * @param output_buffer_size The size of the output buffer.
+ */
+void oe_edger8r_trace_point(
+    uint32_t function_id,
+    oe_edger8r_trace_point_t point,
+    size_t input_buffer_size,
+    size_t output_buffer_size);
+
+/**
+ * Called when a wrapper or forwarder generated with --instrument returns.
+ *
+ * @param function_id The id of the function.
+ * @param result The result the wrapper returns or the forwarder reports.
+ */
+void oe_edger8r_trace_end(uint32_t function_id, oe_result_t result);
+
+/**
+ * The number of failure counters of oe_call_stats_t. Failures with a larger
+ * result are counted in the last one.
+ */
+#define OE_CALL_STATS_MAX_RESULTS 64
+
+/**
+ * The number of latency buckets of oe_call_stats_t. Bucket i counts the calls
+ * that took [2^i, 2^(i+1)) nanoseconds, and bucket 0 also the faster ones.
+ */
+#define OE_CALL_STATS_LATENCY_BUCKETS 64
+
+/**
+ * The counters of one function kept by the wrappers generated with --stats.
+ * Each function has its own cache lines, so the calls of different functions
+ * do not contend.
+ */
+typedef struct _oe_call_stats
+{
+    /** The name of the function. */
+    const char* name;
+
+    /** The number of calls. */
+    uint64_t calls;
+
+    /** The number of failed calls by oe_result_t. */
+    uint64_t failures[OE_CALL_STATS_MAX_RESULTS];
+
+    /** The bytes of the input buffers. */
+    uint64_t input_bytes;
+
+    /** The bytes of the output buffers. */
+    uint64_t output_bytes;
+
+    /** The bytes of the deep-copied out parameters. */
+    uint64_t deepcopy_bytes;
+
+    /** The number of calls by log2 of the latency in nanoseconds. */
+    uint64_t latency[OE_CALL_STATS_LATENCY_BUCKETS];
+} OE_ALIGNED(64) oe_call_stats_t;
+
+/**
+ * Get the timestamp a wrapper generated with --stats passes to
+ * oe_call_stats_end.
+ */
+uint64_t oe_call_stats_begin(void);
+
+/**
+ * Count a call in the counters of its function.
+ *
+ * @param stats The counters of the function.
+ * @param begin The timestamp returned by oe_call_stats_begin.
+ * @param result The result of the call.
+ * @param input_bytes The size of the input buffer.
+ * @param output_bytes The size of the output buffer.
+ * @param deepcopy_bytes The size of the deep-copied out parameters.
+ */
+void oe_call_stats_end(
+    oe_call_stats_t* stats,
+    uint64_t begin,
+    oe_result_t result,
+    size_t input_bytes,
+    size_t output_bytes,
+    size_t deepcopy_bytes);
+
+/**
+ * Copy the counters of count functions. The counters are read one by one
+ * while calls may update them, so they need not be consistent.
+ */
+void oe_call_stats_copy(
+    oe_call_stats_t* dst,
+    const oe_call_stats_t* src,
+    size_t count);
+
+/**
+ * Clear the counters of count functions.
+ */
+void oe_call_stats_reset(oe_call_stats_t* stats, size_t count);
+
+/******************************************************************************/
+/********* Channels ***********************************************************/
+/******************************************************************************/
+
+/**
+ * The header of the ring of a channel, which the host allocates. The records
+ * follow it. head and tail count the records consumed and produced so far;
+ * each is written only by its own side and kept on its own cache line.
+ */
+typedef struct _oe_channel_ring
+{
+    uint64_t head;
+    uint8_t head_padding[56];
+    uint64_t tail;
+    uint8_t tail_padding[56];
+} oe_channel_ring_t;
+
+/**
+ * One side of a channel. The capacity, the record size and this side's
+ * copies of the indexes are never read from the ring, so a host that
+ * changes the ring cannot make the enclave access memory outside it.
+ */
+typedef struct _oe_channel
+{
+    oe_channel_ring_t* ring;
+    size_t capacity;
+    size_t record_size;
+    uint64_t head;
+    uint64_t tail;
+} oe_channel_t;
+
+/**
+ * The size of the ring of a channel, including the header.
+ */
+OE_INLINE size_t oe_channel_ring_size(const oe_channel_t* channel)
+{
+    return sizeof(oe_channel_ring_t) + channel->capacity * channel->record_size;
+}
+
+/**
+ * Append up to count records to the ring of the channel.
+ *
+ * @returns The number of records appended, which is 0 if the ring is full,
+ * the channel is closed or the consumer's index is invalid.
+ */
+size_t oe_channel_send(
+    oe_channel_t* channel,
+    const void* records,
+    size_t count);
+
+/**
+ * Copy up to count records out of the ring of the channel.
+ *
+ * @returns The number of records copied, which is 0 if the ring is empty,
+ * the channel is closed or the producer's index is invalid.
+ */
+size_t oe_channel_receive(oe_channel_t* channel, void* records, size_t count);
+
 OE_EXTERNC_END
 
 #endif // _OE_EDGER8R_COMMON_H
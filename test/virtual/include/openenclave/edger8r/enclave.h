@@ -185,6 +185,21 @@ void oe_memcpy_aligned(void* dest, const void* src, size_t count);
 #define OE_WEAK
 #endif
 
+/* Storage class of the per-thread state kept by the generated code. */
+#if defined(_MSC_VER)
+#define OE_EDGER8R_THREAD_LOCAL __declspec(thread)
+#else
+#define OE_EDGER8R_THREAD_LOCAL __thread
+#endif
+
+/**
+ * Minimum size of the per-thread buffer that holds the deferred OCALLs of an
+ * EDL. The buffer is flushed to the host when the next call does not fit.
+ */
+#ifndef OE_DEFERRED_OCALL_BUFFER_SIZE
+#define OE_DEFERRED_OCALL_BUFFER_SIZE 4096
+#endif
+
 #if __x86_64__ || _M_X64
 /**
  * Get the internal status of the enclave.
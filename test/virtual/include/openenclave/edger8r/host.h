@@ -84,11 +84,17 @@ oe_result_t oe_call_enclave_function(
 #endif
 
 /**
- * Placeholder.
+ * Perform a high-level enclave function call (ECALL) switchlessly.
+ *
+ * The call is handed to an enclave worker thread. It falls back to
+ * oe_call_enclave_function when the enclave has no worker thread or all of
+ * them are busy. The parameters and return values are those of
+ * oe_call_enclave_function.
  */
 oe_result_t oe_switchless_call_enclave_function(
     oe_enclave_t* enclave,
-    uint32_t function_id,
+    uint64_t* global_id,
+    const char* name,
     const void* input_buffer,
     size_t input_buffer_size,
     void* output_buffer,
@@ -677,6 +677,27 @@ oe_result_t oe_verify_attestation_certificate(
     oe_identity_verify_callback_t enclave_identity_callback,
     void* arg);
 
+/**
+ * Wait for an asynchronous call to complete and release its handle.
+ *
+ * @param[in] handle The handle returned by a <function>_async wrapper.
+ *
+ * @returns The result the synchronous wrapper of the function would have
+ * returned, or OE_INVALID_PARAMETER if the handle is NULL.
+ */
+oe_result_t oe_call_wait(oe_call_handle_t handle);
+
+/**
+ * Check whether an asynchronous call has completed.
+ *
+ * @param[in] handle The handle returned by a <function>_async wrapper.
+ *
+ * @returns OE_OK if the call has completed, OE_BUSY if it is still in flight
+ * or OE_INVALID_PARAMETER if the handle is NULL. The handle must still be
+ * released by oe_call_wait().
+ */
+oe_result_t oe_call_poll(oe_call_handle_t handle);
+
 OE_EXTERNC_END
 
 #endif /* _OE_ENCLAVE_H */
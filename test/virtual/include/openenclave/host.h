@@ -108,8 +108,7 @@ typedef struct _oe_enclave_setting_context_switchless
      */
     size_t max_host_workers;
     /**
-     * Context-switchless ecalls are not enabled yet. The max number of enclave
-     * workers should be 0.
+     * The max number of worker threads for context-switchless ecalls.
      */
     size_t max_enclave_workers;
 } oe_enclave_setting_context_switchless_t;
@@ -190,6 +189,27 @@ oe_result_t oe_create_enclave(
     uint32_t ecall_count,
     oe_enclave_t** enclave);
 
+/**
+ * Wait for an asynchronous call to complete and release its handle.
+ *
+ * @param[in] handle The handle returned by a <function>_async wrapper.
+ *
+ * @returns The result the synchronous wrapper of the function would have
+ * returned, or OE_INVALID_PARAMETER if the handle is NULL.
+ */
+oe_result_t oe_call_wait(oe_call_handle_t handle);
+
+/**
+ * Check whether an asynchronous call has completed.
+ *
+ * @param[in] handle The handle returned by a <function>_async wrapper.
+ *
+ * @returns OE_OK if the call has completed, OE_BUSY if it is still in flight
+ * or OE_INVALID_PARAMETER if the handle is NULL. The handle must still be
+ * released by oe_call_wait().
+ */
+oe_result_t oe_call_poll(oe_call_handle_t handle);
+
 /**
  * Terminate an enclave and reclaims its resources.
  *
@@ -0,0 +1,59 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+/**
+ * @file switchless.h
+ *
+ * This file defines the counters the virtual runtime keeps for
+ * context-switchless calls.
+ */
+
+#ifndef _OE_INTERNAL_SWITCHLESS_H
+#define _OE_INTERNAL_SWITCHLESS_H
+
+#include <openenclave/bits/defs.h>
+#include <openenclave/bits/result.h>
+#include <openenclave/bits/types.h>
+
+OE_EXTERNC_BEGIN
+
+/**
+ * Counters of the context-switchless calls of one direction.
+ */
+typedef struct _oe_switchless_stats
+{
+    /** The number of worker threads. */
+    uint64_t workers;
+
+    /** The number of calls run by a worker thread. */
+    uint64_t calls;
+
+    /** The number of calls run as regular calls because there was no worker
+     * thread or the request ring was full. */
+    uint64_t fallbacks;
+
+    /** The number of calls currently waiting in the request ring. */
+    uint64_t occupancy;
+
+    /** The largest number of calls seen waiting in the request ring. */
+    uint64_t max_occupancy;
+} oe_switchless_stats_t;
+
+/**
+ * Get the counters of the context-switchless calls of an enclave. This
+ * function is only available on the host side.
+ *
+ * @param[in] enclave The enclave.
+ * @param[out] ecalls The counters of the switchless ECALLs, or NULL.
+ * @param[out] ocalls The counters of the switchless OCALLs, or NULL.
+ *
+ * @returns OE_OK on success or OE_INVALID_PARAMETER if enclave is NULL.
+ */
+oe_result_t oe_get_switchless_stats(
+    oe_enclave_t* enclave,
+    oe_switchless_stats_t* ecalls,
+    oe_switchless_stats_t* ocalls);
+
+OE_EXTERNC_END
+
+#endif // _OE_INTERNAL_SWITCHLESS_H
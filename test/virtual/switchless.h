@@ -0,0 +1,296 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#ifndef SWITCHLESS_H
+#define SWITCHLESS_H
+
+#include <openenclave/bits/result.h>
+#include <openenclave/internal/switchless.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/* Default number of slots in a switchless request ring. */
+#define OE_SWITCHLESS_RING_SIZE 64
+
+inline void oe_cpu_relax()
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+/*
+ * Spin for a while, then yield the processor, then sleep between the checks
+ * of a condition that is expected to become true shortly.
+ */
+class Backoff
+{
+    uint32_t _count = 0;
+
+  public:
+    void pause()
+    {
+        if (_count < 1024)
+            oe_cpu_relax();
+        else if (_count < 1024 + 64)
+            std::this_thread::yield();
+        else
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        if (_count < UINT32_MAX)
+            _count++;
+    }
+
+    void reset()
+    {
+        _count = 0;
+    }
+};
+
+/*
+ * A call handed to a switchless worker. The caller owns it and waits for
+ * done to be set by the worker.
+ */
+struct SwitchlessCall
+{
+    oe_result_t (*func)(void* context);
+    void* context;
+    oe_result_t result;
+    std::atomic<bool> done;
+
+    SwitchlessCall(oe_result_t (*f)(void*), void* c)
+        : func(f), context(c), result(OE_FAILURE), done(false)
+    {
+    }
+};
+
+/*
+ * Bounded lock-free multi-producer multi-consumer ring of calls. Every slot
+ * carries a sequence number that tells whether it is free for the producer
+ * or filled for the consumer of the current lap, so producers and consumers
+ * only contend on their own index.
+ */
+class SwitchlessRing
+{
+    struct Slot
+    {
+        std::atomic<size_t> sequence;
+        SwitchlessCall* call;
+    };
+
+    std::unique_ptr<Slot[]> _slots;
+    size_t _mask;
+    alignas(64) std::atomic<size_t> _head;
+    alignas(64) std::atomic<size_t> _tail;
+
+  public:
+    /* The capacity is rounded up to a power of two. */
+    explicit SwitchlessRing(size_t capacity) : _head(0), _tail(0)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size <<= 1;
+        _slots.reset(new Slot[size]);
+        _mask = size - 1;
+        for (size_t i = 0; i < size; i++)
+            _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    bool push(SwitchlessCall* call)
+    {
+        size_t pos = _head.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true)
+        {
+            slot = &_slots[pos & _mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (_head.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return false; /* Full. */
+            else
+                pos = _head.load(std::memory_order_relaxed);
+        }
+        slot->call = call;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    SwitchlessCall* pop()
+    {
+        size_t pos = _tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true)
+        {
+            slot = &_slots[pos & _mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+            if (diff == 0)
+            {
+                if (_tail.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0)
+                return nullptr; /* Empty. */
+            else
+                pos = _tail.load(std::memory_order_relaxed);
+        }
+        SwitchlessCall* call = slot->call;
+        slot->sequence.store(pos + _mask + 1, std::memory_order_release);
+        return call;
+    }
+
+    size_t occupancy() const
+    {
+        size_t head = _head.load(std::memory_order_relaxed);
+        size_t tail = _tail.load(std::memory_order_relaxed);
+        return head > tail ? head - tail : 0;
+    }
+};
+
+/*
+ * Worker threads that poll a ring for the switchless calls of one direction.
+ * A call that finds no worker or a full ring is not run; the caller falls
+ * back to a regular call. So does a call made by a worker of either
+ * direction of the enclave: otherwise an ecall -> ocall -> ecall chain would
+ * leave each worker waiting for a call queued behind the other. The ring
+ * size is read from OE_VIRTUAL_SWITCHLESS_RING_SIZE and defaults to
+ * OE_SWITCHLESS_RING_SIZE.
+ */
+class SwitchlessWorkers
+{
+    SwitchlessRing _ring;
+    std::vector<std::thread> _threads;
+    const SwitchlessWorkers* _peer;
+    std::atomic<bool> _stop;
+    std::atomic<uint64_t> _calls;
+    std::atomic<uint64_t> _fallbacks;
+    std::atomic<uint64_t> _max_occupancy;
+
+  public:
+    explicit SwitchlessWorkers(size_t count)
+        : _ring(ring_size()), _peer(nullptr), _stop(false), _calls(0),
+          _fallbacks(0), _max_occupancy(0)
+    {
+        for (size_t i = 0; i < count; i++)
+            _threads.emplace_back(&SwitchlessWorkers::run, this);
+    }
+
+    ~SwitchlessWorkers()
+    {
+        _stop.store(true, std::memory_order_release);
+        for (std::thread& thread : _threads)
+            thread.join();
+    }
+
+    /* Pair the workers of the two directions of an enclave. */
+    static void pair(SwitchlessWorkers* a, SwitchlessWorkers* b)
+    {
+        a->_peer = b;
+        b->_peer = a;
+    }
+
+    /*
+     * Hand the call to a worker. Returns false, without running the call,
+     * when it has to fall back to a regular call.
+     */
+    bool post(SwitchlessCall* call)
+    {
+        if (_threads.empty() || on_worker_thread() || !_ring.push(call))
+        {
+            _fallbacks.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _calls.fetch_add(1, std::memory_order_relaxed);
+
+        uint64_t occupancy = _ring.occupancy();
+        uint64_t max = _max_occupancy.load(std::memory_order_relaxed);
+        while (occupancy > max &&
+               !_max_occupancy.compare_exchange_weak(
+                   max, occupancy, std::memory_order_relaxed))
+            ;
+        return true;
+    }
+
+    /* Wait for a worker to run a posted call. */
+    void wait(SwitchlessCall* call)
+    {
+        Backoff backoff;
+        while (!call->done.load(std::memory_order_acquire))
+            backoff.pause();
+    }
+
+    void get_stats(oe_switchless_stats_t* stats) const
+    {
+        stats->workers = _threads.size();
+        stats->calls = _calls.load(std::memory_order_relaxed);
+        stats->fallbacks = _fallbacks.load(std::memory_order_relaxed);
+        stats->occupancy = _ring.occupancy();
+        stats->max_occupancy = _max_occupancy.load(std::memory_order_relaxed);
+    }
+
+  private:
+    static size_t ring_size()
+    {
+        const char* env = getenv("OE_VIRTUAL_SWITCHLESS_RING_SIZE");
+        if (env && atoi(env) > 0)
+            return static_cast<size_t>(atoi(env));
+        return OE_SWITCHLESS_RING_SIZE;
+    }
+
+    /*
+     * Whether the calling thread is a worker of this direction or of its
+     * peer. The threads are compared by id, as a thread-local flag is not
+     * shared between the host and the enclave image.
+     */
+    bool on_worker_thread() const
+    {
+        return is_worker(std::this_thread::get_id()) ||
+               (_peer && _peer->is_worker(std::this_thread::get_id()));
+    }
+
+    bool is_worker(std::thread::id id) const
+    {
+        for (const std::thread& thread : _threads)
+            if (thread.get_id() == id)
+                return true;
+        return false;
+    }
+
+    void run()
+    {
+        Backoff backoff;
+        while (!_stop.load(std::memory_order_acquire))
+        {
+            SwitchlessCall* call = _ring.pop();
+            if (!call)
+            {
+                backoff.pause();
+                continue;
+            }
+            call->result = call->func(call->context);
+            call->done.store(true, std::memory_order_release);
+            backoff.reset();
+        }
+    }
+};
+
+#endif
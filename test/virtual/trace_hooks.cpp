@@ -0,0 +1,48 @@
+// Copyright (c) Open Enclave SDK contributors.
+// Licensed under the MIT License.
+
+#include <openenclave/edger8r/common.h>
+
+/*
+ * Default trace hooks, overridden by the application's definitions. They are
+ * weak where supported; elsewhere this object is only linked in from the
+ * static library when the application does not define them.
+ */
+#ifdef __GNUC__
+#define OE_TRACE_HOOK __attribute__((weak))
+#else
+#define OE_TRACE_HOOK
+#endif
+
+extern "C"
+{
+    OE_TRACE_HOOK void oe_edger8r_trace_begin(
+        uint32_t function_id,
+        const char* name,
+        bool ecall)
+    {
+        OE_UNUSED(function_id);
+        OE_UNUSED(name);
+        OE_UNUSED(ecall);
+    }
+
+    OE_TRACE_HOOK void oe_edger8r_trace_point(
+        uint32_t function_id,
+        oe_edger8r_trace_point_t point,
+        size_t input_buffer_size,
+        size_t output_buffer_size)
+    {
+        OE_UNUSED(function_id);
+        OE_UNUSED(point);
+        OE_UNUSED(input_buffer_size);
+        OE_UNUSED(output_buffer_size);
+    }
+
+    OE_TRACE_HOOK void oe_edger8r_trace_end(
+        uint32_t function_id,
+        oe_result_t result)
+    {
+        OE_UNUSED(function_id);
+        OE_UNUSED(result);
+    }
+}
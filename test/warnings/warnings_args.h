@@ -0,0 +1,22 @@
+/*
+ *  This file is auto generated by oeedger8r. DO NOT EDIT.
+ */
+#ifndef EDGER8R_WARNINGS_ARGS_H
+#define EDGER8R_WARNINGS_ARGS_H
+
+#include <openenclave/bits/result.h>
+
+/**** User includes. ****/
+/* There were no user includes. */
+
+/**** User defined types in EDL. ****/
+#ifndef EDGER8R_STRUCT_TESTSTRUCT
+#define EDGER8R_STRUCT_TESTSTRUCT
+typedef struct TestStruct
+{
+    size_t size;
+    int* p;
+} TestStruct;
+#endif
+
+#endif // EDGER8R_WARNINGS_ARGS_H
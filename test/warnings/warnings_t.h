@@ -0,0 +1,26 @@
+/*
+ *  This file is auto generated by oeedger8r. DO NOT EDIT.
+ */
+#ifndef EDGER8R_WARNINGS_T_H
+#define EDGER8R_WARNINGS_T_H
+
+#include <openenclave/enclave.h>
+
+#include "warnings_args.h"
+
+OE_EXTERNC_BEGIN
+
+extern bool oe_edger8r_secure_unserialize;
+
+/**** ECALL prototypes. ****/
+
+/**** OCALL prototypes. ****/
+oe_result_t func(
+    int* a,
+    int* b,
+    uint64_t* c,
+    char* d);
+
+OE_EXTERNC_END
+
+#endif // EDGER8R_WARNINGS_T_H
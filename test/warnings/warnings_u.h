@@ -0,0 +1,32 @@
+/*
+ *  This file is auto generated by oeedger8r. DO NOT EDIT.
+ */
+#ifndef EDGER8R_WARNINGS_U_H
+#define EDGER8R_WARNINGS_U_H
+
+#include <openenclave/host.h>
+
+#include "warnings_args.h"
+
+OE_EXTERNC_BEGIN
+
+oe_result_t oe_create_warnings_enclave(
+    const char* path,
+    oe_enclave_type_t type,
+    uint32_t flags,
+    const oe_enclave_setting_t* settings,
+    uint32_t setting_count,
+    oe_enclave_t** enclave);
+
+/**** ECALL prototypes. ****/
+
+/**** OCALL prototypes. ****/
+void func(
+    int* a,
+    int* b,
+    uint64_t* c,
+    char* d);
+
+OE_EXTERNC_END
+
+#endif // EDGER8R_WARNINGS_U_H